@@ -0,0 +1,54 @@
+#include "allocation_counter.hpp"
+
+#include <cstdlib>
+#include <new>
+
+namespace {
+
+thread_local size_t thread_allocations = 0;
+thread_local size_t thread_bytes = 0;
+
+void* counted_allocate(size_t size) {
+    thread_allocations += 1;
+    thread_bytes += size;
+    if (void* pointer = std::malloc(size ? size : 1)) {
+        return pointer;
+    }
+    throw std::bad_alloc();
+}
+
+}  // namespace
+
+void* operator new(size_t size) {
+    return counted_allocate(size);
+}
+
+void* operator new[](size_t size) {
+    return counted_allocate(size);
+}
+
+void operator delete(void* pointer) noexcept {
+    std::free(pointer);
+}
+
+void operator delete[](void* pointer) noexcept {
+    std::free(pointer);
+}
+
+void operator delete(void* pointer, size_t) noexcept {
+    std::free(pointer);
+}
+
+void operator delete[](void* pointer, size_t) noexcept {
+    std::free(pointer);
+}
+
+AllocationCounter::AllocationCounter() : start_allocations(thread_allocations), start_bytes(thread_bytes) {}
+
+size_t AllocationCounter::allocations() const {
+    return thread_allocations - start_allocations;
+}
+
+size_t AllocationCounter::bytes() const {
+    return thread_bytes - start_bytes;
+}
@@ -0,0 +1,21 @@
+#ifndef ALLOCATION_COUNTER_HPP
+#define ALLOCATION_COUNTER_HPP
+
+#include <cstddef>
+
+// Counts the global operator new calls of the current thread since it was constructed.
+// allocation_counter.cpp replaces the global operator new and delete to do so, it is only
+// linked into test builds through the json_repair_allocation_counter target.
+class AllocationCounter {
+public:
+    AllocationCounter();
+
+    size_t allocations() const;
+    size_t bytes() const;
+
+private:
+    size_t start_allocations;
+    size_t start_bytes;
+};
+
+#endif
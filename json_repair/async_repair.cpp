@@ -0,0 +1,58 @@
+#include "async_repair.hpp"
+
+ByteChannel::ByteChannel(Scheduler scheduler) : closed(false), scheduler(std::move(scheduler)) {
+}
+
+void ByteChannel::push(std::string_view bytes) {
+    if (bytes.empty()) {
+        return;
+    }
+    {
+        std::lock_guard< std::mutex > lock(mutex);
+        buffer.append(bytes);
+    }
+    wake();
+}
+
+void ByteChannel::close() {
+    {
+        std::lock_guard< std::mutex > lock(mutex);
+        closed = true;
+    }
+    wake();
+}
+
+void ByteChannel::wake() {
+    std::coroutine_handle<> waiting;
+    {
+        std::lock_guard< std::mutex > lock(mutex);
+        waiting = std::exchange(reader, nullptr);
+    }
+    if (!waiting) {
+        return;
+    }
+    if (scheduler) {
+        scheduler(waiting);
+    } else {
+        waiting.resume();
+    }
+}
+
+bool ByteChannel::Read::await_ready() {
+    std::lock_guard< std::mutex > lock(channel.mutex);
+    return !channel.buffer.empty() || channel.closed;
+}
+
+bool ByteChannel::Read::await_suspend(std::coroutine_handle<> reader) {
+    std::lock_guard< std::mutex > lock(channel.mutex);
+    if (!channel.buffer.empty() || channel.closed) {
+        return false;
+    }
+    channel.reader = reader;
+    return true;
+}
+
+std::string ByteChannel::Read::await_resume() {
+    std::lock_guard< std::mutex > lock(channel.mutex);
+    return std::exchange(channel.buffer, std::string());
+}
@@ -0,0 +1,209 @@
+#ifndef ASYNC_REPAIR_HPP
+#define ASYNC_REPAIR_HPP
+
+#include "incremental_repair.hpp"
+
+#include <coroutine>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+
+// Coroutine front end of IncrementalRepair, built with C++20 as the json_repair_async library.
+// A source is anything with a read() whose co_await returns the next bytes as a std::string, empty
+// at the end of the input. Nothing blocks: the repair suspends until the source resumes it.
+
+// Coroutine returning T, started when it is awaited or by start(), and resuming its awaiter when
+// it finishes
+template < typename T > class Task {
+public:
+    struct promise_type {
+        std::optional< T > value;
+        std::exception_ptr error;
+        std::coroutine_handle<> awaiting;
+
+        struct FinalAwaiter {
+            bool await_ready() noexcept { return false; }
+            std::coroutine_handle<> await_suspend(std::coroutine_handle< promise_type > handle) noexcept {
+                std::coroutine_handle<> next = handle.promise().awaiting;
+                return next ? next : std::noop_coroutine();
+            }
+            void await_resume() noexcept {}
+        };
+
+        Task get_return_object() { return Task(std::coroutine_handle< promise_type >::from_promise(*this)); }
+        std::suspend_always initial_suspend() noexcept { return {}; }
+        FinalAwaiter final_suspend() noexcept { return {}; }
+        void return_value(T result) { value = std::move(result); }
+        void unhandled_exception() { error = std::current_exception(); }
+    };
+
+    Task(Task&& other) noexcept : handle(std::exchange(other.handle, nullptr)) {}
+    Task& operator=(Task&& other) noexcept {
+        if (this != &other) {
+            destroy();
+            handle = std::exchange(other.handle, nullptr);
+        }
+        return *this;
+    }
+    ~Task() { destroy(); }
+
+    bool await_ready() const { return handle.done(); }
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiter) {
+        handle.promise().awaiting = awaiter;
+        return handle;
+    }
+    T await_resume() { return result(); }
+
+    // Runs the task until it first suspends, for the outermost task of an executor
+    void start() { handle.resume(); }
+    bool done() const { return handle.done(); }
+    // The returned value once done(), rethrowing what the task threw
+    T result() {
+        if (handle.promise().error) {
+            std::rethrow_exception(handle.promise().error);
+        }
+        return std::move(*handle.promise().value);
+    }
+
+private:
+    explicit Task(std::coroutine_handle< promise_type > handle) : handle(handle) {}
+
+    void destroy() {
+        if (handle) {
+            handle.destroy();
+        }
+    }
+
+    std::coroutine_handle< promise_type > handle;
+};
+
+// Coroutine yielding values of T, co_await next() resumes it until the next co_yield and returns
+// the value, or nothing once it has returned
+template < typename T > class AsyncGenerator {
+public:
+    struct promise_type {
+        std::optional< T > current;
+        std::exception_ptr error;
+        std::coroutine_handle<> consumer;
+
+        // Back to the consumer waiting in next()
+        struct Yield {
+            bool await_ready() noexcept { return false; }
+            std::coroutine_handle<> await_suspend(std::coroutine_handle< promise_type > handle) noexcept {
+                return handle.promise().consumer;
+            }
+            void await_resume() noexcept {}
+        };
+
+        AsyncGenerator get_return_object() {
+            return AsyncGenerator(std::coroutine_handle< promise_type >::from_promise(*this));
+        }
+        std::suspend_always initial_suspend() noexcept { return {}; }
+        Yield final_suspend() noexcept { return {}; }
+        Yield yield_value(T value) {
+            current = std::move(value);
+            return {};
+        }
+        void return_void() {}
+        void unhandled_exception() { error = std::current_exception(); }
+    };
+
+    struct Next {
+        std::coroutine_handle< promise_type > handle;
+
+        bool await_ready() const { return handle.done(); }
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<> consumer) {
+            handle.promise().consumer = consumer;
+            handle.promise().current.reset();
+            return handle;
+        }
+        std::optional< T > await_resume() {
+            if (handle.promise().error) {
+                std::rethrow_exception(std::exchange(handle.promise().error, nullptr));
+            }
+            return std::exchange(handle.promise().current, std::nullopt);
+        }
+    };
+
+    AsyncGenerator(AsyncGenerator&& other) noexcept : handle(std::exchange(other.handle, nullptr)) {}
+    ~AsyncGenerator() {
+        if (handle) {
+            handle.destroy();
+        }
+    }
+
+    Next next() { return Next{handle}; }
+
+private:
+    explicit AsyncGenerator(std::coroutine_handle< promise_type > handle) : handle(handle) {}
+
+    std::coroutine_handle< promise_type > handle;
+};
+
+// Source fed by a producer, such as a socket callback or a test. The reader suspended in read()
+// is resumed by push() or close() through the scheduler, which resumes it inline when empty and
+// can hand it to an executor instead. push() and close() may be called from any thread.
+class ByteChannel {
+public:
+    using Scheduler = std::function< void(std::coroutine_handle<>) >;
+
+    explicit ByteChannel(Scheduler scheduler = nullptr);
+
+    void push(std::string_view bytes);
+    void close();
+
+    struct Read {
+        ByteChannel& channel;
+
+        bool await_ready();
+        bool await_suspend(std::coroutine_handle<> reader);
+        std::string await_resume();
+    };
+
+    // The bytes pushed since the last read, empty once closed and drained
+    Read read() { return Read{*this}; }
+
+private:
+    void wake();
+
+    std::mutex mutex;
+    std::string buffer;
+    bool closed;
+    std::coroutine_handle<> reader;
+    Scheduler scheduler;
+};
+
+// The top-level values of parse() over the bytes of source, each as soon as it is settled
+template < typename Source > AsyncGenerator< JSONReturnType > repair_values(Source& source) {
+    IncrementalRepair repair;
+    while (!repair.done()) {
+        std::string bytes = co_await source.read();
+        if (bytes.empty()) {
+            repair.close();
+        } else {
+            repair.append(bytes);
+        }
+        while (auto value = repair.next()) {
+            co_yield std::move(*value);
+        }
+    }
+}
+
+// The value of parse() over the bytes of source: the only value, or an array of them
+template < typename Source > Task< JSONReturnType > async_repair(Source& source) {
+    auto values = repair_values(source);
+    JSONReturnType::VectorType collected;
+    while (auto value = co_await values.next()) {
+        collected.push_back(std::move(*value));
+    }
+    if (collected.size() == 1) {
+        co_return std::move(collected[0]);
+    }
+    co_return JSONReturnType(std::move(collected));
+}
+
+#endif
@@ -0,0 +1,352 @@
+#include "binary_writer.hpp"
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+namespace {
+
+// Writes big-endian through a cursor into memory sized by encoded_size
+class Cursor {
+public:
+    explicit Cursor(char* data) : data(data) {}
+
+    void byte(uint8_t value) { *data++ = static_cast< char >(value); }
+    void be16(uint16_t value) {
+        byte(value >> 8);
+        byte(value);
+    }
+    void be32(uint32_t value) {
+        be16(value >> 16);
+        be16(value);
+    }
+    void be64(uint64_t value) {
+        be32(value >> 32);
+        be32(value);
+    }
+    void float64(double value) {
+        uint64_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        be64(bits);
+    }
+    void bytes(const char* source, size_t count) {
+        std::memcpy(data, source, count);
+        data += count;
+    }
+
+private:
+    char* data;
+};
+
+// Parsed numbers are doubles, those holding an int are written as the int. Negative zero, which
+// an int would lose the sign of, stays a float.
+bool integral(double value, int64_t& result) {
+    if (!(value >= -0x1p63 && value < 0x1p63) || std::trunc(value) != value ||
+        (value == 0 && std::signbit(value))) {
+        return false;
+    }
+    result = static_cast< int64_t >(value);
+    return true;
+}
+
+// MessagePack
+
+size_t msgpack_int_size(int64_t value) {
+    if (value >= -32 && value <= 127) {
+        return 1;
+    } else if (value >= INT8_MIN && value <= UINT8_MAX) {
+        return 2;
+    } else if (value >= INT16_MIN && value <= UINT16_MAX) {
+        return 3;
+    } else if (value >= INT32_MIN && value <= UINT32_MAX) {
+        return 5;
+    }
+    return 9;
+}
+
+size_t msgpack_double_size(double value) {
+    int64_t i;
+    return integral(value, i) ? msgpack_int_size(i) : 9;
+}
+
+size_t msgpack_header_size(size_t length, size_t fix_limit) {
+    return length < fix_limit ? 1 : length <= UINT16_MAX ? 3 : 5;
+}
+
+size_t msgpack_str_size(size_t length) {
+    return (length < 32 ? 1 : length <= UINT8_MAX ? 2 : length <= UINT16_MAX ? 3 : 5) + length;
+}
+
+size_t msgpack_size(const JSONReturnType& value) {
+    if (value.is< JSONReturnType::MapType >()) {
+        const auto& map = value.get< JSONReturnType::MapType >();
+        size_t size = msgpack_header_size(map.size(), 16);
+        for (const auto& [key, item] : map) {
+            size += msgpack_str_size(key.size()) + msgpack_size(item);
+        }
+        return size;
+    } else if (value.is< JSONReturnType::PackedType >()) {
+        auto packed = value.as_span< double >();
+        size_t size = msgpack_header_size(packed.size(), 16);
+        for (double item : packed) {
+            size += msgpack_double_size(item);
+        }
+        return size;
+    } else if (value.is< JSONReturnType::VectorType >()) {
+        const auto& vec = value.get< JSONReturnType::VectorType >();
+        size_t size = msgpack_header_size(vec.size(), 16);
+        for (const auto& item : vec) {
+            size += msgpack_size(item);
+        }
+        return size;
+    } else if (value.is< JSONReturnType::StringType >()) {
+        return msgpack_str_size(value.get< JSONReturnType::StringType >().size());
+    } else if (value.is< JSONReturnType::DoubleType >()) {
+        return msgpack_double_size(value.get< JSONReturnType::DoubleType >());
+    } else if (value.is< JSONReturnType::IntType >()) {
+        return msgpack_int_size(value.get< JSONReturnType::IntType >());
+    }
+    return 1;
+}
+
+void msgpack_int(Cursor& out, int64_t value) {
+    if (value >= -32 && value <= 127) {
+        out.byte(static_cast< uint8_t >(value));
+    } else if (value >= 0) {
+        if (value <= UINT8_MAX) {
+            out.byte(0xcc);
+            out.byte(value);
+        } else if (value <= UINT16_MAX) {
+            out.byte(0xcd);
+            out.be16(value);
+        } else if (value <= UINT32_MAX) {
+            out.byte(0xce);
+            out.be32(value);
+        } else {
+            out.byte(0xcf);
+            out.be64(value);
+        }
+    } else if (value >= INT8_MIN) {
+        out.byte(0xd0);
+        out.byte(static_cast< uint8_t >(value));
+    } else if (value >= INT16_MIN) {
+        out.byte(0xd1);
+        out.be16(static_cast< uint16_t >(value));
+    } else if (value >= INT32_MIN) {
+        out.byte(0xd2);
+        out.be32(static_cast< uint32_t >(value));
+    } else {
+        out.byte(0xd3);
+        out.be64(static_cast< uint64_t >(value));
+    }
+}
+
+void msgpack_double(Cursor& out, double value) {
+    int64_t i;
+    if (integral(value, i)) {
+        msgpack_int(out, i);
+    } else {
+        out.byte(0xcb);
+        out.float64(value);
+    }
+}
+
+void msgpack_header(Cursor& out, size_t length, uint8_t fix, uint8_t code16) {
+    if (length < 16) {
+        out.byte(fix | length);
+    } else if (length <= UINT16_MAX) {
+        out.byte(code16);
+        out.be16(length);
+    } else {
+        out.byte(code16 + 1);
+        out.be32(length);
+    }
+}
+
+void msgpack_str(Cursor& out, const char* data, size_t length) {
+    if (length < 32) {
+        out.byte(0xa0 | length);
+    } else if (length <= UINT8_MAX) {
+        out.byte(0xd9);
+        out.byte(length);
+    } else if (length <= UINT16_MAX) {
+        out.byte(0xda);
+        out.be16(length);
+    } else {
+        out.byte(0xdb);
+        out.be32(length);
+    }
+    out.bytes(data, length);
+}
+
+void msgpack(Cursor& out, const JSONReturnType& value) {
+    if (value.is< JSONReturnType::MapType >()) {
+        const auto& map = value.get< JSONReturnType::MapType >();
+        msgpack_header(out, map.size(), 0x80, 0xde);
+        for (const auto& [key, item] : map) {
+            msgpack_str(out, key.data(), key.size());
+            msgpack(out, item);
+        }
+    } else if (value.is< JSONReturnType::PackedType >()) {
+        auto packed = value.as_span< double >();
+        msgpack_header(out, packed.size(), 0x90, 0xdc);
+        for (double item : packed) {
+            msgpack_double(out, item);
+        }
+    } else if (value.is< JSONReturnType::VectorType >()) {
+        const auto& vec = value.get< JSONReturnType::VectorType >();
+        msgpack_header(out, vec.size(), 0x90, 0xdc);
+        for (const auto& item : vec) {
+            msgpack(out, item);
+        }
+    } else if (value.is< JSONReturnType::StringType >()) {
+        const auto& str = value.get< JSONReturnType::StringType >();
+        msgpack_str(out, str.data(), str.size());
+    } else if (value.is< JSONReturnType::DoubleType >()) {
+        msgpack_double(out, value.get< JSONReturnType::DoubleType >());
+    } else if (value.is< JSONReturnType::IntType >()) {
+        msgpack_int(out, value.get< JSONReturnType::IntType >());
+    } else if (value.is< JSONReturnType::BoolType >()) {
+        out.byte(value.get< JSONReturnType::BoolType >() ? 0xc3 : 0xc2);
+    } else {
+        out.byte(0xc0);
+    }
+}
+
+// CBOR, with definite lengths only
+
+size_t cbor_head_size(uint64_t argument) {
+    return argument < 24 ? 1 : argument <= UINT8_MAX ? 2 : argument <= UINT16_MAX ? 3 : argument <= UINT32_MAX ? 5 : 9;
+}
+
+size_t cbor_int_size(int64_t value) {
+    return cbor_head_size(value < 0 ? -1 - value : value);
+}
+
+size_t cbor_double_size(double value) {
+    int64_t i;
+    return integral(value, i) ? cbor_int_size(i) : 9;
+}
+
+size_t cbor_size(const JSONReturnType& value) {
+    if (value.is< JSONReturnType::MapType >()) {
+        const auto& map = value.get< JSONReturnType::MapType >();
+        size_t size = cbor_head_size(map.size());
+        for (const auto& [key, item] : map) {
+            size += cbor_head_size(key.size()) + key.size() + cbor_size(item);
+        }
+        return size;
+    } else if (value.is< JSONReturnType::PackedType >()) {
+        auto packed = value.as_span< double >();
+        size_t size = cbor_head_size(packed.size());
+        for (double item : packed) {
+            size += cbor_double_size(item);
+        }
+        return size;
+    } else if (value.is< JSONReturnType::VectorType >()) {
+        const auto& vec = value.get< JSONReturnType::VectorType >();
+        size_t size = cbor_head_size(vec.size());
+        for (const auto& item : vec) {
+            size += cbor_size(item);
+        }
+        return size;
+    } else if (value.is< JSONReturnType::StringType >()) {
+        size_t length = value.get< JSONReturnType::StringType >().size();
+        return cbor_head_size(length) + length;
+    } else if (value.is< JSONReturnType::DoubleType >()) {
+        return cbor_double_size(value.get< JSONReturnType::DoubleType >());
+    } else if (value.is< JSONReturnType::IntType >()) {
+        return cbor_int_size(value.get< JSONReturnType::IntType >());
+    }
+    return 1;
+}
+
+void cbor_head(Cursor& out, uint8_t major, uint64_t argument) {
+    major <<= 5;
+    if (argument < 24) {
+        out.byte(major | argument);
+    } else if (argument <= UINT8_MAX) {
+        out.byte(major | 24);
+        out.byte(argument);
+    } else if (argument <= UINT16_MAX) {
+        out.byte(major | 25);
+        out.be16(argument);
+    } else if (argument <= UINT32_MAX) {
+        out.byte(major | 26);
+        out.be32(argument);
+    } else {
+        out.byte(major | 27);
+        out.be64(argument);
+    }
+}
+
+void cbor_int(Cursor& out, int64_t value) {
+    if (value < 0) {
+        cbor_head(out, 1, -1 - value);
+    } else {
+        cbor_head(out, 0, value);
+    }
+}
+
+void cbor_double(Cursor& out, double value) {
+    int64_t i;
+    if (integral(value, i)) {
+        cbor_int(out, i);
+    } else {
+        out.byte(0xfb);
+        out.float64(value);
+    }
+}
+
+void cbor(Cursor& out, const JSONReturnType& value) {
+    if (value.is< JSONReturnType::MapType >()) {
+        const auto& map = value.get< JSONReturnType::MapType >();
+        cbor_head(out, 5, map.size());
+        for (const auto& [key, item] : map) {
+            cbor_head(out, 3, key.size());
+            out.bytes(key.data(), key.size());
+            cbor(out, item);
+        }
+    } else if (value.is< JSONReturnType::PackedType >()) {
+        auto packed = value.as_span< double >();
+        cbor_head(out, 4, packed.size());
+        for (double item : packed) {
+            cbor_double(out, item);
+        }
+    } else if (value.is< JSONReturnType::VectorType >()) {
+        const auto& vec = value.get< JSONReturnType::VectorType >();
+        cbor_head(out, 4, vec.size());
+        for (const auto& item : vec) {
+            cbor(out, item);
+        }
+    } else if (value.is< JSONReturnType::StringType >()) {
+        const auto& str = value.get< JSONReturnType::StringType >();
+        cbor_head(out, 3, str.size());
+        out.bytes(str.data(), str.size());
+    } else if (value.is< JSONReturnType::DoubleType >()) {
+        cbor_double(out, value.get< JSONReturnType::DoubleType >());
+    } else if (value.is< JSONReturnType::IntType >()) {
+        cbor_int(out, value.get< JSONReturnType::IntType >());
+    } else if (value.is< JSONReturnType::BoolType >()) {
+        out.byte(value.get< JSONReturnType::BoolType >() ? 0xf5 : 0xf4);
+    } else {
+        out.byte(0xf6);
+    }
+}
+
+} // namespace
+
+size_t encoded_size(const JSONReturnType& value, BinaryFormat format) {
+    return format == BinaryFormat::MSGPACK ? msgpack_size(value) : cbor_size(value);
+}
+
+void write_binary(const JSONReturnType& value, BinaryFormat format, std::string& out) {
+    size_t start = out.size();
+    out.resize(start + encoded_size(value, format));
+    Cursor cursor(&out[start]);
+    if (format == BinaryFormat::MSGPACK) {
+        msgpack(cursor, value);
+    } else {
+        cbor(cursor, value);
+    }
+}
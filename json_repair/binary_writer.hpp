@@ -0,0 +1,31 @@
+#ifndef BINARY_WRITER_HPP
+#define BINARY_WRITER_HPP
+
+#include "json_parser.hpp"
+
+#include <cstddef>
+#include <string>
+
+enum class BinaryFormat { MSGPACK, CBOR };
+
+// Exact size of the encoding of value
+size_t encoded_size(const JSONReturnType& value, BinaryFormat format);
+
+// Appends the encoding of value to out, sized up front so that it grows once. Ints and the
+// doubles holding an int, packed array elements included, are written as the smallest int, other
+// doubles as float64. Keys are written in the order of the map.
+void write_binary(const JSONReturnType& value, BinaryFormat format, std::string& out);
+
+inline std::string to_msgpack(const JSONReturnType& value) {
+    std::string out;
+    write_binary(value, BinaryFormat::MSGPACK, out);
+    return out;
+}
+
+inline std::string to_cbor(const JSONReturnType& value) {
+    std::string out;
+    write_binary(value, BinaryFormat::CBOR, out);
+    return out;
+}
+
+#endif
@@ -0,0 +1,201 @@
+#include "candidate_scanner.hpp"
+#include "constants.hpp"
+#include "parser_pool.hpp"
+
+#include <algorithm>
+#include <cctype>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace {
+
+// First '{', '[' or '`' from i, 16 bytes at a time where SSE2 is available
+size_t find_special(std::string_view text, size_t i) {
+#if defined(__SSE2__)
+    const __m128i brace = _mm_set1_epi8('{');
+    const __m128i bracket = _mm_set1_epi8('[');
+    const __m128i tick = _mm_set1_epi8('`');
+    for (; i + 16 <= text.size(); i += 16) {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast< const __m128i* >(text.data() + i));
+        __m128i found = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chunk, brace), _mm_cmpeq_epi8(chunk, bracket)),
+                                     _mm_cmpeq_epi8(chunk, tick));
+        int mask = _mm_movemask_epi8(found);
+        if (mask != 0) {
+            return i + __builtin_ctz(static_cast< unsigned >(mask));
+        }
+    }
+#endif
+    for (; i < text.size(); ++i) {
+        char c = text[i];
+        if (c == '{' || c == '[' || c == '`') {
+            return i;
+        }
+    }
+    return std::string_view::npos;
+}
+
+bool starts_with(std::string_view text, size_t i, std::string_view prefix) {
+    return text.compare(i, prefix.size(), prefix) == 0;
+}
+
+// Whether the bracket at i is followed by something a value can start with
+bool plausible_start(std::string_view text, size_t i) {
+    size_t j = skip_spaces(text, i + 1);
+    if (j >= text.size()) {
+        return false;
+    }
+    char next = text[j];
+    if (text[i] == '{') {
+        if (next == '"' || next == '\'' || next == '}') {
+            return true;
+        }
+        // Unquoted key
+        if (!std::isalpha(static_cast< unsigned char >(next)) && next != '_') {
+            return false;
+        }
+        while (j < text.size() && (std::isalnum(static_cast< unsigned char >(text[j])) || text[j] == '_')) {
+            ++j;
+        }
+        j = skip_spaces(text, j);
+        return j < text.size() && text[j] == ':';
+    }
+    return next == '{' || next == '[' || next == '"' || next == ']' || next == '-' ||
+           std::isdigit(static_cast< unsigned char >(next)) || starts_with(text, j, "true") ||
+           starts_with(text, j, "false") || starts_with(text, j, "null");
+}
+
+// Length of the string delimiter at i, 0 when there is none: " and ' or the UTF-8 “ and ”
+size_t quote_length(std::string_view text, size_t i) {
+    if (text[i] == '"' || text[i] == '\'') {
+        return 1;
+    }
+    if (starts_with(text, i, "“") || starts_with(text, i, "”")) {
+        return 3;
+    }
+    return 0;
+}
+
+// End of the value opened at begin, the end of the text when it is never closed. Brackets in
+// strings do not count, a string closes on the quote that opened it and “ on ”.
+size_t match_end(std::string_view text, size_t begin) {
+    size_t depth = 0;
+    std::string_view closing;
+    for (size_t i = begin; i < text.size(); ++i) {
+        char c = text[i];
+        if (!closing.empty()) {
+            if (c == '\\') {
+                ++i;
+            } else if (starts_with(text, i, closing)) {
+                i += closing.size() - 1;
+                closing = std::string_view();
+            }
+        } else if (size_t length = quote_length(text, i)) {
+            closing = length == 1 ? text.substr(i, 1) : std::string_view("”");
+            i += length - 1;
+        } else if (c == '{' || c == '[') {
+            ++depth;
+        } else if (c == '}' || c == ']') {
+            if (--depth == 0) {
+                return i + 1;
+            }
+        }
+    }
+    return text.size();
+}
+
+struct Fence {
+    // Content without the surrounding whitespace
+    size_t begin;
+    size_t end;
+    // After the closing fence
+    size_t next;
+    bool json;
+};
+
+// The fence opened by the ``` at i
+Fence read_fence(std::string_view text, size_t i) {
+    size_t tag_begin = i + 3;
+    size_t content_begin = skip_spaces(text, tag_begin);
+    std::string tag;
+    if (content_begin < text.size() && text[content_begin] != '{' && text[content_begin] != '[') {
+        size_t line_end = std::min(text.find('\n', tag_begin), text.size());
+        for (size_t t = tag_begin; t < line_end; ++t) {
+            if (!is_space(text[t])) {
+                tag += static_cast< char >(std::tolower(static_cast< unsigned char >(text[t])));
+            }
+        }
+        content_begin = std::min(line_end + 1, text.size());
+    }
+
+    size_t closing = text.find("```", content_begin);
+    Fence fence;
+    fence.next = closing == std::string_view::npos ? text.size() : closing + 3;
+    fence.begin = skip_spaces(text, content_begin);
+    fence.end = std::max(std::min(closing, text.size()), fence.begin);
+    while (fence.end > fence.begin && is_space(text[fence.end - 1])) {
+        --fence.end;
+    }
+    bool has_content = fence.begin < fence.end;
+    bool opens_value = has_content && (text[fence.begin] == '{' || text[fence.begin] == '[');
+    fence.json = has_content && (tag.compare(0, 4, "json") == 0 || (tag.empty() && opens_value));
+    return fence;
+}
+
+} // namespace
+
+std::vector< JSONCandidate > CandidateScanner::scan(std::string_view text, CandidatePolicy policy) {
+    std::vector< JSONCandidate > fenced;
+    std::vector< JSONCandidate > unfenced;
+    size_t i = find_special(text, 0);
+    while (i != std::string_view::npos) {
+        if (text[i] == '`') {
+            if (!starts_with(text, i, "```")) {
+                i = find_special(text, i + 1);
+                continue;
+            }
+            // Brackets inside other fences are code, not candidates
+            Fence fence = read_fence(text, i);
+            if (fence.json) {
+                fenced.push_back({fence.begin, fence.end, true});
+                if (policy == CandidatePolicy::FIRST) {
+                    break;
+                }
+            }
+            i = find_special(text, fence.next);
+        } else if (fenced.empty() && plausible_start(text, i)) {
+            size_t end = match_end(text, i);
+            unfenced.push_back({i, end, false});
+            i = find_special(text, end);
+        } else {
+            i = find_special(text, i + 1);
+        }
+    }
+
+    std::vector< JSONCandidate >& found = fenced.empty() ? unfenced : fenced;
+    if (found.empty() || policy == CandidatePolicy::ALL) {
+        return std::move(found);
+    }
+    if (policy == CandidatePolicy::FIRST) {
+        return {found.front()};
+    }
+    auto largest = std::max_element(found.begin(), found.end(), [](const JSONCandidate& a, const JSONCandidate& b) {
+        return a.size() < b.size();
+    });
+    return {*largest};
+}
+
+std::vector< JSONReturnType > repair_candidates(std::string_view text, CandidatePolicy policy) {
+    std::vector< JSONReturnType > values;
+    std::vector< JSONCandidate > candidates = CandidateScanner::scan(text, policy);
+    if (candidates.empty()) {
+        values.push_back(ParserPool::acquire(std::string(text))->parse());
+        return values;
+    }
+    values.reserve(candidates.size());
+    for (const auto& candidate : candidates) {
+        values.push_back(ParserPool::acquire(std::string(text.substr(candidate.begin, candidate.size())))->parse());
+    }
+    return values;
+}
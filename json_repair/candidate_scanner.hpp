@@ -0,0 +1,35 @@
+#ifndef CANDIDATE_SCANNER_HPP
+#define CANDIDATE_SCANNER_HPP
+
+#include "json_parser.hpp"
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Region of mixed text that may hold a JSON value
+struct JSONCandidate {
+    size_t begin;
+    size_t end;
+    // Inside a ```json fence, or an untagged fence starting with '{' or '['
+    bool fenced;
+
+    size_t size() const { return end - begin; }
+};
+
+enum class CandidatePolicy { FIRST, ALL, LARGEST };
+
+// Finds JSON in prose around it, such as LLM answers, without running the parser over the prose.
+// Fenced blocks are preferred: '{' and '[' in the prose are only candidates when the text has no
+// JSON fence. An unfenced candidate starts at a bracket followed by something a value can start
+// with and ends at its matching bracket, or at the end of the text when it is never closed.
+class CandidateScanner {
+public:
+    static std::vector< JSONCandidate > scan(std::string_view text, CandidatePolicy policy = CandidatePolicy::FIRST);
+};
+
+// Repairs the candidates chosen by policy, the whole text when there are none
+std::vector< JSONReturnType > repair_candidates(std::string_view text, CandidatePolicy policy = CandidatePolicy::FIRST);
+
+#endif
@@ -1,9 +1,11 @@
 #ifndef CONSTANTS_HPP
 #define CONSTANTS_HPP
 
+#include <algorithm>
 #include <vector>
 #include <set>
 #include <string>
+#include <string_view>
 
 const std::vector<std::string> STRING_DELIMITERS = {
     "\"",  // regular double quote
@@ -17,4 +19,20 @@ const std::set<char> NUMBER_CHARS = {
     '-', '.', 'e', 'E', '/', ','
 };
 
+inline bool is_string_delimiter(char c) {
+    return std::find(STRING_DELIMITERS.begin(), STRING_DELIMITERS.end(), std::string(1, c)) != STRING_DELIMITERS.end();
+}
+
+// JSON whitespace only, unlike std::isspace
+inline bool is_space(char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+inline size_t skip_spaces(std::string_view text, size_t i) {
+    while (i < text.size() && is_space(text[i])) {
+        ++i;
+    }
+    return i;
+}
+
 #endif
\ No newline at end of file
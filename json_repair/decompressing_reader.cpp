@@ -0,0 +1,268 @@
+#include "decompressing_reader.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <stdexcept>
+
+#ifdef JSON_REPAIR_ZLIB
+#include <zlib.h>
+#endif
+#ifdef JSON_REPAIR_ZSTD
+#include <zstd.h>
+#endif
+
+namespace {
+
+constexpr size_t INPUT_BLOCK = 1 << 18;
+constexpr size_t OUTPUT_BLOCK = 1 << 18;
+
+// Takes the whole chunks out of the output, false to stop decoding
+using Drain = std::function< bool(std::string&) >;
+
+// Appends the decompressed bytes of every block of input to out, draining it after every output
+// block so that highly compressed input stays bounded too
+class Decoder {
+public:
+    virtual ~Decoder() = default;
+    virtual bool decode(const char* data, size_t size, std::string& out, const Drain& drain) = 0;
+    // Throws when the input ended inside a compressed stream
+    virtual void finish() {}
+};
+
+class PlainDecoder : public Decoder {
+public:
+    bool decode(const char* data, size_t size, std::string& out, const Drain& drain) override {
+        out.append(data, size);
+        return drain(out);
+    }
+};
+
+#ifdef JSON_REPAIR_ZLIB
+class GzipDecoder : public Decoder {
+public:
+    GzipDecoder() : in_stream(false) {
+        stream = z_stream();
+        // 32 detects the gzip header
+        if (inflateInit2(&stream, 15 + 32) != Z_OK) {
+            throw std::runtime_error("Cannot initialize zlib");
+        }
+    }
+    ~GzipDecoder() override { inflateEnd(&stream); }
+
+    bool decode(const char* data, size_t size, std::string& out, const Drain& drain) override {
+        stream.next_in = reinterpret_cast< Bytef* >(const_cast< char* >(data));
+        stream.avail_in = static_cast< uInt >(size);
+        while (stream.avail_in > 0) {
+            size_t before = out.size();
+            out.resize(before + OUTPUT_BLOCK);
+            stream.next_out = reinterpret_cast< Bytef* >(&out[before]);
+            stream.avail_out = OUTPUT_BLOCK;
+            int status = inflate(&stream, Z_NO_FLUSH);
+            out.resize(before + OUTPUT_BLOCK - stream.avail_out);
+            in_stream = true;
+            if (status == Z_STREAM_END) {
+                // Concatenated members, as written by appending to a .gz file
+                inflateReset(&stream);
+                in_stream = false;
+            } else if (status != Z_OK && status != Z_BUF_ERROR) {
+                throw std::runtime_error(std::string("gzip: ") + (stream.msg ? stream.msg : "corrupt input"));
+            }
+            if (!drain(out)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void finish() override {
+        if (in_stream) {
+            throw std::runtime_error("gzip: truncated input");
+        }
+    }
+
+private:
+    z_stream stream;
+    bool in_stream;
+};
+#endif
+
+#ifdef JSON_REPAIR_ZSTD
+class ZstdDecoder : public Decoder {
+public:
+    ZstdDecoder() : stream(ZSTD_createDStream()), pending(0) {
+        if (!stream) {
+            throw std::runtime_error("Cannot initialize zstd");
+        }
+        ZSTD_initDStream(stream);
+    }
+    ~ZstdDecoder() override { ZSTD_freeDStream(stream); }
+
+    bool decode(const char* data, size_t size, std::string& out, const Drain& drain) override {
+        ZSTD_inBuffer input{data, size, 0};
+        while (input.pos < input.size) {
+            size_t before = out.size();
+            out.resize(before + OUTPUT_BLOCK);
+            ZSTD_outBuffer output{&out[before], OUTPUT_BLOCK, 0};
+            pending = ZSTD_decompressStream(stream, &output, &input);
+            out.resize(before + output.pos);
+            if (ZSTD_isError(pending)) {
+                throw std::runtime_error(std::string("zstd: ") + ZSTD_getErrorName(pending));
+            }
+            if (!drain(out)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void finish() override {
+        if (pending != 0) {
+            throw std::runtime_error("zstd: truncated input");
+        }
+    }
+
+private:
+    ZSTD_DStream* stream;
+    // What ZSTD_decompressStream returned last, 0 once a frame is complete
+    size_t pending;
+};
+#endif
+
+std::unique_ptr< Decoder > make_decoder(Compression format) {
+    switch (format) {
+    case Compression::GZIP:
+#ifdef JSON_REPAIR_ZLIB
+        return std::make_unique< GzipDecoder >();
+#else
+        throw std::runtime_error("gzip input needs json_repair built with zlib");
+#endif
+    case Compression::ZSTD:
+#ifdef JSON_REPAIR_ZSTD
+        return std::make_unique< ZstdDecoder >();
+#else
+        throw std::runtime_error("zstd input needs json_repair built with libzstd");
+#endif
+    default:
+        return std::make_unique< PlainDecoder >();
+    }
+}
+
+} // namespace
+
+Compression detect_compression(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    unsigned char magic[4] = {};
+    file.read(reinterpret_cast< char* >(magic), sizeof(magic));
+    size_t count = file.gcount();
+    if (count >= 2 && magic[0] == 0x1f && magic[1] == 0x8b) {
+        return Compression::GZIP;
+    }
+    if (count == 4 && magic[0] == 0x28 && magic[1] == 0xb5 && magic[2] == 0x2f && magic[3] == 0xfd) {
+        return Compression::ZSTD;
+    }
+    return Compression::NONE;
+}
+
+DecompressingReader::DecompressingReader(const std::string& path, size_t chunk_length, size_t max_queued)
+    : path(path),
+      format(detect_compression(path)),
+      chunk_size(std::max< size_t >(chunk_length, 2)),
+      max_queued(std::max< size_t >(max_queued, 1)),
+      finished(false),
+      stopping(false) {
+    start();
+}
+
+DecompressingReader::~DecompressingReader() {
+    stop();
+}
+
+void DecompressingReader::start() {
+    finished = false;
+    stopping = false;
+    error = nullptr;
+    worker = std::thread([this]() { produce(); });
+}
+
+void DecompressingReader::stop() {
+    {
+        std::lock_guard< std::mutex > lock(mutex);
+        stopping = true;
+    }
+    changed.notify_all();
+    if (worker.joinable()) {
+        worker.join();
+    }
+    queue.clear();
+}
+
+void DecompressingReader::rewind() {
+    stop();
+    start();
+}
+
+bool DecompressingReader::push(std::string&& chunk) {
+    std::unique_lock< std::mutex > lock(mutex);
+    changed.wait(lock, [this]() { return stopping || queue.size() < max_queued; });
+    if (stopping) {
+        return false;
+    }
+    queue.push_back(std::move(chunk));
+    changed.notify_all();
+    return true;
+}
+
+void DecompressingReader::produce() {
+    try {
+        std::ifstream file(path, std::ios::binary);
+        if (!file) {
+            throw std::runtime_error("Cannot open " + path);
+        }
+        std::unique_ptr< Decoder > decoder = make_decoder(format);
+        Drain drain = [this](std::string& output) {
+            size_t offset = 0;
+            for (; output.size() - offset >= chunk_size; offset += chunk_size) {
+                if (!push(output.substr(offset, chunk_size))) {
+                    return false;
+                }
+            }
+            output.erase(0, offset);
+            return true;
+        };
+        std::string input(INPUT_BLOCK, '\0');
+        std::string output;
+        while (file) {
+            file.read(&input[0], input.size());
+            if (!decoder->decode(input.data(), file.gcount(), output, drain)) {
+                return;
+            }
+        }
+        decoder->finish();
+        if (!output.empty() && !push(std::move(output))) {
+            return;
+        }
+    } catch (...) {
+        std::lock_guard< std::mutex > lock(mutex);
+        error = std::current_exception();
+    }
+    std::lock_guard< std::mutex > lock(mutex);
+    finished = true;
+    changed.notify_all();
+}
+
+bool DecompressingReader::read(std::string& chunk) {
+    std::unique_lock< std::mutex > lock(mutex);
+    changed.wait(lock, [this]() { return !queue.empty() || finished; });
+    if (queue.empty()) {
+        if (error) {
+            std::rethrow_exception(error);
+        }
+        return false;
+    }
+    chunk = std::move(queue.front());
+    queue.pop_front();
+    changed.notify_all();
+    return true;
+}
@@ -0,0 +1,58 @@
+#ifndef DECOMPRESSING_READER_HPP
+#define DECOMPRESSING_READER_HPP
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <string>
+#include <thread>
+
+enum class Compression { NONE, GZIP, ZSTD };
+
+// Format of the file at path from its magic bytes, NONE when it cannot be read
+Compression detect_compression(const std::string& path);
+
+// Reads a file, decompressing gzip (with zlib) or zstd (with libzstd) when its magic bytes say so.
+// A thread decompresses ahead of the reader into a queue of at most max_queued chunks, so
+// decompression and repair run at the same time in bounded memory. Chunks are chunk_length bytes,
+// the last one may be shorter.
+// Give it to a StringFileWrapper to parse or stream-repair the decompressed bytes.
+class DecompressingReader {
+public:
+    explicit DecompressingReader(const std::string& path, size_t chunk_length = 1 << 20, size_t max_queued = 4);
+    DecompressingReader(const DecompressingReader&) = delete;
+    DecompressingReader& operator=(const DecompressingReader&) = delete;
+    ~DecompressingReader();
+
+    // The next chunk, false at the end of the input. Rethrows what decompression threw.
+    bool read(std::string& chunk);
+    // Starts over from the beginning of the file
+    void rewind();
+
+    Compression compression() const { return format; }
+    size_t chunk_length() const { return chunk_size; }
+
+private:
+    void start();
+    void stop();
+    void produce();
+    // Waits for room in the queue, false when stopping
+    bool push(std::string&& chunk);
+
+    std::string path;
+    Compression format;
+    size_t chunk_size;
+    size_t max_queued;
+
+    std::mutex mutex;
+    std::condition_variable changed;
+    std::deque< std::string > queue;
+    bool finished;
+    bool stopping;
+    std::exception_ptr error;
+    std::thread worker;
+};
+
+#endif
@@ -0,0 +1,111 @@
+#include "edit_script.hpp"
+
+#include <algorithm>
+#include <cctype>
+
+EditScriptSink::EditScriptSink(JSONParser& parser) : parser(parser), last_end(0) {}
+
+void EditScriptSink::write(const std::string& text, size_t source_begin, size_t source_end) {
+    // The repair only moves backwards before anything of the current value was written,
+    // anything that would overlap is turned into an insertion
+    // and closing brackets missing at the end of the input are all appended there
+    source_begin = std::min(std::max(source_begin, last_end), parser.get_length());
+    source_end = std::min(std::max(source_end, source_begin), parser.get_length());
+
+    drop_gap(source_begin);
+    if (parser.get_range(source_begin, source_end) != text) {
+        add(source_begin, source_end - source_begin, text);
+    }
+    last_end = source_end;
+}
+
+std::vector< JSONEdit > EditScriptSink::finish() {
+    drop_gap(parser.get_length());
+    last_end = parser.get_length();
+    // A deleted separator merged with the one written in its place can rewrite the source as it was
+    edits.erase(std::remove_if(edits.begin(), edits.end(),
+                               [this](const JSONEdit& edit) {
+                                   return parser.get_range(edit.offset, edit.offset + edit.length) == edit.text;
+                               }),
+                edits.end());
+    return std::move(edits);
+}
+
+void EditScriptSink::drop_gap(size_t stop) {
+    // Skipped whitespace is kept, anything else between two tokens was ignored by the repair
+    std::string gap = parser.get_range(last_end, stop);
+    size_t first = 0;
+    while (first < gap.size() && std::isspace(static_cast< unsigned char >(gap[first]))) {
+        first += 1;
+    }
+    size_t last = gap.size();
+    while (last > first && std::isspace(static_cast< unsigned char >(gap[last - 1]))) {
+        last -= 1;
+    }
+    if (first < last) {
+        add(last_end + first, last - first, "");
+    }
+}
+
+void EditScriptSink::add(size_t offset, size_t length, const std::string& text) {
+    if (!edits.empty() && edits.back().offset + edits.back().length == offset) {
+        edits.back().length += length;
+        edits.back().text += text;
+        return;
+    }
+    edits.push_back(JSONEdit{offset, length, text});
+}
+
+std::vector< JSONEdit > repair_edits(JSONParser& parser) {
+    EditScriptSink sink(parser);
+    StreamRepair repair(parser, sink);
+    repair.run();
+    return sink.finish();
+}
+
+std::string apply_edits(const std::string& source, const std::vector< JSONEdit >& edits) {
+    std::string result;
+    result.reserve(source.size());
+    size_t position = 0;
+    for (const auto& edit : edits) {
+        result.append(source, position, edit.offset - position);
+        result += edit.text;
+        position = edit.offset + edit.length;
+    }
+    result.append(source, std::min(position, source.size()), std::string::npos);
+    return result;
+}
+
+bool apply_edits_in_place(StringFileWrapper& file, const std::vector< JSONEdit >& edits) {
+    size_t size = file.size();
+    for (const auto& edit : edits) {
+        bool same_length = edit.text.size() == edit.length;
+        bool at_end = edit.offset + edit.length == size && edit.text.size() >= edit.length;
+        if (!same_length && !at_end) {
+            return false;
+        }
+    }
+    for (const auto& edit : edits) {
+        if (!edit.text.empty()) {
+            file.write_at(edit.offset, edit.text);
+        }
+    }
+    return true;
+}
+
+void apply_edits(StringFileWrapper& source, std::ostream& out, const std::vector< JSONEdit >& edits) {
+    const size_t block = 1 << 20;
+    auto copy = [&](size_t start, size_t stop) {
+        for (size_t i = start; i < stop; i += block) {
+            std::string bytes = source.get_range(i, std::min(i + block, stop));
+            out.write(bytes.data(), bytes.size());
+        }
+    };
+    size_t position = 0;
+    for (const auto& edit : edits) {
+        copy(position, edit.offset);
+        out.write(edit.text.data(), edit.text.size());
+        position = edit.offset + edit.length;
+    }
+    copy(position, source.size());
+}
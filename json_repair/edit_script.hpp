@@ -0,0 +1,54 @@
+#ifndef EDIT_SCRIPT_HPP
+#define EDIT_SCRIPT_HPP
+
+#include "json_parser.hpp"
+#include "stream_repair.hpp"
+#include "string_file_wrapper.hpp"
+
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Replaces the source bytes [offset, offset + length) with text: length 0 is an insertion and an
+// empty text a deletion
+struct JSONEdit {
+    size_t offset;
+    size_t length;
+    std::string text;
+
+    bool operator==(const JSONEdit& other) const {
+        return offset == other.offset && length == other.length && text == other.text;
+    }
+};
+
+// Turns the stream repair into the byte edits that make the source valid, keeping the source
+// whitespace and layout
+class EditScriptSink : public RepairSink {
+public:
+    explicit EditScriptSink(JSONParser& parser);
+
+    void write(const std::string& text, size_t source_begin, size_t source_end) override;
+    void separate_values(size_t) override {}
+
+    // Deletes whatever follows the last value and returns the sorted, merged edits
+    std::vector< JSONEdit > finish();
+
+private:
+    void add(size_t offset, size_t length, const std::string& text);
+    void drop_gap(size_t stop);
+
+    JSONParser& parser;
+    std::vector< JSONEdit > edits;
+    size_t last_end;
+};
+
+std::vector< JSONEdit > repair_edits(JSONParser& parser);
+
+std::string apply_edits(const std::string& source, const std::vector< JSONEdit >& edits);
+// Patches the file through write_at, which is only possible when no edit moves the bytes after it
+// (same length replacements, or edits that reach the end of the file). Returns false otherwise.
+bool apply_edits_in_place(StringFileWrapper& file, const std::vector< JSONEdit >& edits);
+// Streams source into out with the edits applied
+void apply_edits(StringFileWrapper& source, std::ostream& out, const std::vector< JSONEdit >& edits);
+
+#endif
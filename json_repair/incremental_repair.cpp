@@ -0,0 +1,88 @@
+#include "incremental_repair.hpp"
+
+#include <algorithm>
+
+IncrementalRepair::IncrementalRepair()
+    : parser(""), closed(false), first(true), finished(false), retry_length(0) {
+}
+
+void IncrementalRepair::append(std::string_view bytes) {
+    parser.append(bytes);
+}
+
+void IncrementalRepair::close() {
+    closed = true;
+}
+
+bool IncrementalRepair::done() const {
+    return finished;
+}
+
+bool IncrementalRepair::parse_value(JSONReturnType& value) {
+    size_t start = parser.index;
+    size_t budget = parser.backtrack_budget;
+    // A value may leave entries behind that the next one is parsed in, as in parse()
+    JsonContext context = parser.context;
+    if (!first) {
+        parser.context.reset();
+    }
+    parser.reached_end = false;
+    try {
+        value = parser.parse_iterative();
+    } catch (...) {
+        // Thrown by parse() too unless it came from the end of the input
+        if (closed || !parser.reached_end) {
+            throw;
+        }
+    }
+    if (closed || !parser.reached_end) {
+        retry_length = 0;
+        return true;
+    }
+    parser.index = start;
+    parser.backtrack_budget = budget;
+    parser.context = std::move(context);
+    // Only keys of the value being parsed are remembered, they may depend on the end too
+    parser.resolved_keys.clear();
+    retry_length = parser.get_length() + std::max< size_t >(1, (parser.get_length() - start) / 4);
+    return false;
+}
+
+std::optional< JSONReturnType > IncrementalRepair::next() {
+    // Same loop as parse(), with the values handed out instead of collected
+    while (!finished) {
+        if (!first && parser.index >= parser.get_length()) {
+            if (!closed) {
+                return std::nullopt;
+            }
+            finished = true;
+            return std::move(pending);
+        }
+        if (!closed && parser.get_length() < retry_length) {
+            return std::nullopt;
+        }
+        JSONReturnType value;
+        if (!parse_value(value)) {
+            return std::nullopt;
+        }
+        // Dropped once it is most of the input, so the input is moved a bounded number of times
+        if (parser.index > KEEP_BEHIND * 2 && parser.index * 2 > parser.get_length()) {
+            parser.discard(parser.index - KEEP_BEHIND);
+        }
+        if (first) {
+            first = false;
+            pending = std::move(value);
+        } else if (value != JSONReturnType::StringType()) {
+            if (*pending == value) {
+                pending = std::move(value);
+            } else {
+                std::optional< JSONReturnType > ready = std::move(pending);
+                pending = std::move(value);
+                return ready;
+            }
+        } else {
+            parser.index += 1;
+        }
+    }
+    return std::nullopt;
+}
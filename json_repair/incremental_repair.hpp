@@ -0,0 +1,45 @@
+#ifndef INCREMENTAL_REPAIR_HPP
+#define INCREMENTAL_REPAIR_HPP
+
+#include "json_parser.hpp"
+
+#include <cstddef>
+#include <optional>
+#include <string_view>
+
+// Repairs input that arrives in pieces, returning the top-level values of parse() one at a time
+// as soon as they no longer depend on bytes not received yet. A value is parsed again from its
+// start when it ran into the end of the input, once a quarter more bytes have come or the input
+// is closed. Equal consecutive values are merged as parse() does, so a value is only returned
+// once the next one is known to differ.
+class IncrementalRepair {
+public:
+    IncrementalRepair();
+
+    void append(std::string_view bytes);
+    // No more bytes will be appended
+    void close();
+
+    // The next value, or nothing until more bytes are appended or the input is closed
+    std::optional< JSONReturnType > next();
+    // Closed and every value returned
+    bool done() const;
+
+    // Consumed input kept before the value being parsed, for the parser to look back at
+    static constexpr size_t KEEP_BEHIND = 64;
+
+private:
+    // Parses one value into value, false when it depends on the end of the input
+    bool parse_value(JSONReturnType& value);
+
+    JSONParser parser;
+    bool closed;
+    bool first;
+    bool finished;
+    // Last value parsed, returned once the next one is known
+    std::optional< JSONReturnType > pending;
+    // Input length at which a value that ran into the end is parsed again
+    size_t retry_length;
+};
+
+#endif
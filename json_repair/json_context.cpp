@@ -1,16 +1,27 @@
 #include "json_context.hpp"
 
-JsonContext::JsonContext() : empty(true) {}
+namespace {
+
+const uint64_t FNV_OFFSET = 14695981039346656037ull;
+const uint64_t FNV_PRIME = 1099511628211ull;
+
+} // namespace
+
+JsonContext::JsonContext() : empty(true), counts{0, 0, 0} {}
 
 void JsonContext::set(ContextValues value) {
+    hashes.push_back((hash() ^ (static_cast<uint64_t>(value) + 1)) * FNV_PRIME);
     context.push_back(value);
+    counts[static_cast<size_t>(value)] += 1;
     current = value;
     empty = false;
 }
 
 void JsonContext::reset() {
     if (!context.empty()) {
+        counts[static_cast<size_t>(context.back())] -= 1;
         context.pop_back();
+        hashes.pop_back();
         if (!context.empty()) {
             current = context.back();
         } else {
@@ -23,6 +34,14 @@ void JsonContext::reset() {
     }
 }
 
+void JsonContext::clear() {
+    context.clear();
+    hashes.clear();
+    counts[0] = counts[1] = counts[2] = 0;
+    current = std::nullopt;
+    empty = true;
+}
+
 std::optional<ContextValues> JsonContext::getCurrent() const {
     return current;
 }
@@ -31,6 +50,18 @@ bool JsonContext::isEmpty() const {
     return empty;
 }
 
+bool JsonContext::contains(ContextValues value) const {
+    return counts[static_cast<size_t>(value)] > 0;
+}
+
 const std::vector<ContextValues>& JsonContext::getContext() const {
     return context;
+}
+
+size_t JsonContext::depth() const {
+    return context.size();
+}
+
+uint64_t JsonContext::hash() const {
+    return hashes.empty() ? FNV_OFFSET : hashes.back();
 }
\ No newline at end of file
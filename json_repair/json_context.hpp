@@ -1,6 +1,8 @@
 #ifndef JSON_CONTEXT_HPP
 #define JSON_CONTEXT_HPP
 
+#include <cstddef>
+#include <cstdint>
 #include <vector>
 #include <optional>
 
@@ -15,16 +17,25 @@ private:
     std::vector<ContextValues> context;
     std::optional<ContextValues> current;
     bool empty;
+    // Occurrences of each value in context, unclosed keys can make it as deep as the input
+    size_t counts[3];
+    // Hash of each prefix of context, so that contexts compare in constant time
+    std::vector<uint64_t> hashes;
 
 public:
     JsonContext();
 
     void set(ContextValues value);
     void reset();
+    // Empties the context and keeps its capacity
+    void clear();
 
     std::optional<ContextValues> getCurrent() const;
     bool isEmpty() const;
+    bool contains(ContextValues value) const;
     const std::vector<ContextValues>& getContext() const;
+    size_t depth() const;
+    uint64_t hash() const;
 };
 
 #endif
\ No newline at end of file
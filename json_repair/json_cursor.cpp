@@ -0,0 +1,169 @@
+#include "json_cursor.hpp"
+
+#include "constants.hpp"
+
+#include <algorithm>
+#include <cctype>
+
+JSONCursor::JSONCursor(JSONParser& parser) : parser(&parser), pos(0) {
+    parser.index = 0;
+    char current_char = parser.get_char_at();
+    while (current_char && current_char != '{' && current_char != '[') {
+        parser.index += 1;
+        current_char = parser.get_char_at();
+    }
+    pos = parser.index;
+}
+
+JSONCursor::JSONCursor(JSONParser& parser, size_t pos, std::vector< ContextValues > context)
+    : parser(&parser), pos(pos), context(std::move(context)) {}
+
+char JSONCursor::peek() const {
+    parser->index = pos;
+    return parser->get_char_at();
+}
+
+void JSONCursor::restore_context() const {
+    parser->context = JsonContext();
+    for (auto value : context) {
+        parser->context.set(value);
+    }
+}
+
+void JSONCursor::skip_separators() const {
+    char current_char = parser->get_char_at();
+    while (current_char && (std::isspace(current_char) || current_char == ',')) {
+        parser->index += 1;
+        current_char = parser->get_char_at();
+    }
+}
+
+bool JSONCursor::is_object() const { return peek() == '{'; }
+
+bool JSONCursor::is_array() const { return peek() == '['; }
+
+std::optional< JSONCursor > JSONCursor::find_field(const std::string& key) const {
+    if (!is_object()) {
+        return std::nullopt;
+    }
+    restore_context();
+    parser->index = pos + 1;
+
+    while (true) {
+        size_t start_index = parser->index;
+        skip_separators();
+        char current_char = parser->get_char_at();
+        if (current_char == '\0' || current_char == '}' || current_char == ']') {
+            return std::nullopt;
+        }
+
+        parser->context.set(ContextValues::OBJECT_KEY);
+        std::string current_key = parser->parse_string();
+        parser->context.reset();
+
+        parser->skip_whitespaces();
+        if (parser->get_char_at() == ':') {
+            parser->index += 1;
+        } else {
+            parser->log("While navigating an object we missed a : after a key");
+        }
+        parser->skip_whitespaces();
+
+        if (current_key == key) {
+            auto value_context = context;
+            value_context.push_back(ContextValues::OBJECT_VALUE);
+            return JSONCursor(*parser, parser->index, std::move(value_context));
+        }
+
+        parser->index += parser->skip_value();
+        if (parser->index == start_index) {
+            parser->index += 1;
+        }
+    }
+}
+
+std::optional< JSONCursor > JSONCursor::at(size_t i) const {
+    if (!is_array()) {
+        return std::nullopt;
+    }
+    restore_context();
+    parser->index = pos + 1;
+
+    size_t count = 0;
+    while (true) {
+        skip_separators();
+        char current_char = parser->get_char_at();
+        if (current_char == '\0' || current_char == ']' || current_char == '}') {
+            return std::nullopt;
+        }
+        if (count == i) {
+            auto value_context = context;
+            value_context.push_back(ContextValues::ARRAY);
+            return JSONCursor(*parser, parser->index, std::move(value_context));
+        }
+
+        size_t start_index = parser->index;
+        parser->index += parser->skip_value();
+        if (parser->index == start_index) {
+            parser->index += 1;
+        }
+        count += 1;
+    }
+}
+
+std::optional< JSONCursor > JSONCursor::at_pointer(const std::string& pointer) const {
+    std::optional< JSONCursor > current = *this;
+    size_t start = 0;
+    while (current && start < pointer.size()) {
+        if (pointer[start] != '/') {
+            return std::nullopt;
+        }
+        size_t end = pointer.find('/', start + 1);
+        if (end == std::string::npos) {
+            end = pointer.size();
+        }
+
+        std::string token;
+        for (size_t i = start + 1; i < end; ++i) {
+            if (pointer[i] == '~' && i + 1 < end && (pointer[i + 1] == '0' || pointer[i + 1] == '1')) {
+                token += pointer[i + 1] == '0' ? '~' : '/';
+                i += 1;
+            } else {
+                token += pointer[i];
+            }
+        }
+
+        if (current->is_array()) {
+            if (token.empty() || !std::all_of(token.begin(), token.end(), ::isdigit)) {
+                return std::nullopt;
+            }
+            current = current->at(std::stoul(token));
+        } else {
+            current = current->find_field(token);
+        }
+        start = end;
+    }
+    return current;
+}
+
+JSONReturnType JSONCursor::get() const {
+    char current_char = peek();
+    restore_context();
+
+    if (!context.empty() && context.back() == ContextValues::OBJECT_VALUE &&
+        (current_char == ',' || current_char == '}')) {
+        return std::string("");
+    }
+    // Same lookahead as parse_array: a quoted string followed by : starts an object
+    if (!context.empty() && context.back() == ContextValues::ARRAY &&
+        std::find(STRING_DELIMITERS.begin(), STRING_DELIMITERS.end(), std::string(1, current_char)) !=
+            STRING_DELIMITERS.end()) {
+        size_t i = parser->skip_to_character(current_char, 1);
+        i = parser->scroll_whitespaces(i + 1);
+        if (parser->get_char_at(i) == ':') {
+            return parser->parse_object();
+        }
+        return parser->parse_string();
+    }
+    return parser->parse_json();
+}
@@ -0,0 +1,45 @@
+#ifndef JSON_CURSOR_HPP
+#define JSON_CURSOR_HPP
+
+#include "json_context.hpp"
+#include "json_parser.hpp"
+
+#include <optional>
+#include <string>
+#include <vector>
+
+// On-demand navigation over the repaired document: only the values on the requested path are
+// repaired, siblings are skipped with JSONParser::skip_value.
+// Cursors share the parser and are only valid while it is alive.
+class JSONCursor {
+public:
+    // Positions the cursor on the first top-level object or array of the parser input
+    explicit JSONCursor(JSONParser& parser);
+
+    bool is_object() const;
+    bool is_array() const;
+
+    // First member named key of an object (the full parse keeps the last one on duplicates)
+    std::optional< JSONCursor > find_field(const std::string& key) const;
+    std::optional< JSONCursor > at(size_t i) const;
+    // RFC 6901 JSON pointer relative to this cursor, e.g. "/tool_calls/0/arguments"
+    std::optional< JSONCursor > at_pointer(const std::string& pointer) const;
+
+    // Repairs and materializes the value under the cursor
+    JSONReturnType get() const;
+
+    size_t position() const { return pos; }
+
+private:
+    JSONCursor(JSONParser& parser, size_t pos, std::vector< ContextValues > context);
+
+    char peek() const;
+    void restore_context() const;
+    void skip_separators() const;
+
+    JSONParser* parser;
+    size_t pos;
+    std::vector< ContextValues > context;
+};
+
+#endif
@@ -5,74 +5,163 @@
 #include "object_comparer.hpp"
 #include "parse_array.hpp"
 #include "parse_comment.hpp"
+#include "parse_iterative.hpp"
 #include "parse_number.hpp"
 #include "parse_object.hpp"
 #include "parse_string.hpp"
+#include "parse_typed.hpp"
+#include "result_cache.hpp"
 #include "string_file_wrapper.hpp"
 
 #include <cctype>
+#include <cstring>
 #include <functional>
 #include <variant>
 
 JSONParser::JSONParser(const std::string& json_str,
                        bool logging_param,
                        size_t json_fd_chunk_length,
-                       bool stream_stable_param)
+                       bool stream_stable_param,
+                       std::shared_ptr< const Projection > projection_param,
+                       std::shared_ptr< const CompiledSchema > schema_param)
     : json_str_variant(json_str),
       index(0),
       logging(logging_param),
-      stream_stable(stream_stable_param) {
-    if (logging) {
-        logger.clear();
-        log = [this](const std::string& text) { this->_log(text); };
-    } else {
-        log = [](const std::string&) {};
-    }
+      stream_stable(stream_stable_param),
+      projection(std::move(projection_param)),
+      schema(std::move(schema_param)),
+      schema_node(schema ? schema->root() : CompiledSchema::ANY),
+      iterative(true),
+      utf8_policy(Utf8Policy::KEEP),
+      max_depth(DEFAULT_MAX_DEPTH),
+      backtrack_budget(BACKTRACK_RATIO * get_length()),
+      limit_exceeded(LimitExceeded::NONE),
+      bytes_examined(0),
+      nodes(0),
+      reached_end(false),
+      resource(std::pmr::get_default_resource()),
+      next_limit_check(0),
+      budget_counted(0) {
 }
 
 JSONParser::JSONParser(StringFileWrapper& json_fd_wrapper,
                        bool logging_param,
                        size_t json_fd_chunk_length,
-                       bool stream_stable_param)
+                       bool stream_stable_param,
+                       std::shared_ptr< const Projection > projection_param,
+                       std::shared_ptr< const CompiledSchema > schema_param)
     : json_str_variant(json_fd_wrapper),
       index(0),
       logging(logging_param),
-      stream_stable(stream_stable_param) {
-    if (logging) {
-        logger.clear();
-        log = [this](const std::string& text) { this->_log(text); };
+      stream_stable(stream_stable_param),
+      projection(std::move(projection_param)),
+      schema(std::move(schema_param)),
+      schema_node(schema ? schema->root() : CompiledSchema::ANY),
+      iterative(true),
+      utf8_policy(Utf8Policy::KEEP),
+      max_depth(DEFAULT_MAX_DEPTH),
+      backtrack_budget(BACKTRACK_RATIO * get_length()),
+      limit_exceeded(LimitExceeded::NONE),
+      bytes_examined(0),
+      nodes(0),
+      reached_end(false),
+      resource(std::pmr::get_default_resource()),
+      next_limit_check(0),
+      budget_counted(0) {
+    if (json_fd_wrapper.streamed()) {
+        backtrack_budget = 0;
+    }
+}
+
+JSONParser::~JSONParser() = default;
+
+void JSONParser::reset(std::string_view json_str) {
+    if (std::holds_alternative< std::string >(json_str_variant)) {
+        std::get< std::string >(json_str_variant).assign(json_str);
     } else {
-        log = [](const std::string&) {};
+        json_str_variant.emplace< std::string >(json_str);
     }
+    index = 0;
+    context.clear();
+    logger.clear();
+    path.clear();
+    schema_node = schema ? schema->root() : CompiledSchema::ANY;
+    backtrack_budget = BACKTRACK_RATIO * get_length();
+    budget_counted = 0;
+    resolved_keys.clear();
+    reached_end = false;
+    set_limits(limits);
+}
+
+void JSONParser::append(std::string_view bytes) {
+    std::get< std::string >(json_str_variant).append(bytes);
+    backtrack_budget += BACKTRACK_RATIO * bytes.size();
+}
+
+void JSONParser::discard(size_t count) {
+    count = std::min(count, index);
+    std::get< std::string >(json_str_variant).erase(0, count);
+    index -= count;
+    // Keys are remembered at offsets before the value being parsed
+    resolved_keys.clear();
 }
 
 JSONReturnType JSONParser::parse() {
-    auto result = parse_json();
+    // Logs, a projection, a schema and limits change what parse() does besides its result
+    if (!cache || logging || projection || schema || has_limits() || get_view().empty()) {
+        return parse_values< JSONReturnType >();
+    }
+    ResultCache::Key key = ResultCache::key(get_view(), stream_stable, max_depth, utf8_policy, iterative);
+    if (auto cached = cache->find(key)) {
+        index = get_length();
+        return *cached;
+    }
+    JSONReturnType value = parse_values< JSONReturnType >();
+    cache->insert(key, value);
+    return value;
+}
+
+namespace {
+// Puts the parser resource back when parse(resource) returns or throws
+struct ResourceRestorer {
+    std::pmr::memory_resource*& resource;
+    std::pmr::memory_resource* previous;
+
+    ~ResourceRestorer() { resource = previous; }
+};
+} // namespace
+
+PmrJSONReturnType JSONParser::parse(std::pmr::memory_resource* memory_resource) {
+    ResourceRestorer restorer{resource, resource};
+    resource = memory_resource;
+    return parse_values< PmrJSONReturnType >();
+}
+
+template < typename Value > Value JSONParser::parse_values() {
+    auto result = iterative ? ::parse_iterative< Value >(*this) : ::parse_json< Value >(*this);
     if (index < get_length()) {
         log("The parser returned early, checking if there's more json elements");
-        std::vector< JSONReturnType > json_array = {result};
-        while (index < get_length()) {
+        // Moved rather than copied, copying a deeply nested value recurses as deep as it is
+        typename Value::VectorType json_array = Value::make_vector(resource);
+        json_array.push_back(std::move(result));
+        while (index < get_length() && limit_exceeded == LimitExceeded::NONE) {
             context.reset();
-            auto j = parse_json();
-            if (j != std::string("")) {
-                if (ObjectComparer::is_same_object(json_array.back(), j)) {
+            auto j = iterative ? ::parse_iterative< Value >(*this) : ::parse_json< Value >(*this);
+            if (j != typename Value::StringType()) {
+                // The hash of the previous value is cached, a different value is told apart in O(1)
+                if (json_array.back().hash() == j.hash() && ObjectComparer::is_same_object(json_array.back(), j)) {
                     json_array.pop_back();
                 }
-                json_array.push_back(j);
+                json_array.push_back(std::move(j));
             } else {
                 index += 1;
             }
         }
         if (json_array.size() == 1) {
             log("There were no more elements, returning the element without the array");
-            return json_array[0];
-        }
-        // Convert vector to JSONReturnType
-        std::vector< JSONReturnType > temp_vec;
-        for (const auto& item : json_array) {
-            temp_vec.push_back(item);
+            return std::move(json_array[0]);
         }
-        return temp_vec;
+        return json_array;
     }
 
     return result;
@@ -80,84 +169,147 @@ JSONReturnType JSONParser::parse() {
 
 std::pair< JSONReturnType, std::vector< std::map< std::string, std::string > > >
 JSONParser::parse_with_logs() {
-    auto result = parse_json();
+    auto result = iterative ? parse_iterative() : parse_json();
     if (index < get_length()) {
         log("The parser returned early, checking if there's more json elements");
-        std::vector< JSONReturnType > json_array = {result};
-        while (index < get_length()) {
+        std::vector< JSONReturnType > json_array;
+        json_array.push_back(std::move(result));
+        while (index < get_length() && limit_exceeded == LimitExceeded::NONE) {
             context.reset();
-            auto j = parse_json();
+            auto j = iterative ? parse_iterative() : parse_json();
             if (j != "") {
-                if (ObjectComparer::is_same_object(json_array.back(), j)) {
+                if (json_array.back().hash() == j.hash() && ObjectComparer::is_same_object(json_array.back(), j)) {
                     json_array.pop_back();
                 }
-                json_array.push_back(j);
+                json_array.push_back(std::move(j));
             } else {
                 index += 1;
             }
         }
         if (json_array.size() == 1) {
             log("There were no more elements, returning the element without the array");
-            result = json_array[0];
         }
+        // Only the first element is returned, an equal value may have replaced it
+        result = std::move(json_array[0]);
     }
-    return std::make_pair(result, logger);
+    // The logs are moved out, the parser keeps none of them
+    return std::make_pair(std::move(result), std::move(logger));
 }
 
 JSONReturnType JSONParser::parse_json() {
+    return ::parse_json< JSONReturnType >(*this);
+}
+
+template < typename Value > Value parse_json(JSONParser& parser) {
+    JSON_REPAIR_TRACE("parse_json", &parser.index);
     while (true) {
-        char current_char = get_char_at();
+        char current_char = parser.get_char_at();
         auto const curr_string = std::string{current_char};
         if (current_char == '\0') {
-            return std::string("");
+            return Value::make_string("", parser.resource);
+        } else if (parser.schema_node != CompiledSchema::ANY && !parser.context.isEmpty() &&
+                   (current_char == '{' || current_char == '[' || current_char == '-' ||
+                    current_char == '.' || std::isalnum(static_cast< unsigned char >(current_char)) ||
+                    std::find(STRING_DELIMITERS.begin(), STRING_DELIMITERS.end(), curr_string) !=
+                        STRING_DELIMITERS.end())) {
+            return parse_typed< Value >(parser);
         } else if (current_char == '{') {
-            index += 1;
-            return parse_object();
+            parser.index += 1;
+            return parse_object< Value >(parser);
         } else if (current_char == '[') {
-            index += 1;
-            return parse_array();
-        } else if (!context.isEmpty() &&
+            parser.index += 1;
+            return parse_array< Value >(parser);
+        } else if (!parser.context.isEmpty() &&
                    (std::find(STRING_DELIMITERS.begin(), STRING_DELIMITERS.end(), curr_string) !=
                         STRING_DELIMITERS.end() ||
                     std::isalpha(current_char))) {
-            return parse_string();
-        } else if (!context.isEmpty() &&
+            return parse_string< Value >(parser);
+        } else if (!parser.context.isEmpty() &&
                    (std::isdigit(current_char) || current_char == '-' || current_char == '.')) {
-            return parse_number();
+            return parse_number< Value >(parser);
         } else if (current_char == '#' || current_char == '/') {
-            return parse_comment();
+            return parse_comment< Value >(parser);
         } else {
-            index += 1;
+            parser.index += 1;
         }
     }
 }
 
-char JSONParser::get_char_at(int count) {
-    size_t pos = index + count;
-    if (pos >= get_length()) {
-        return '\0';
+template JSONReturnType parse_json< JSONReturnType >(JSONParser& parser);
+template PmrJSONReturnType parse_json< PmrJSONReturnType >(JSONParser& parser);
+
+LimitedParse JSONParser::parse_with_limits() {
+    set_limits(limits);
+    JSONReturnType value = parse();
+    return LimitedParse{std::move(value), limit_exceeded, bytes_examined, nodes, index};
+}
+
+void JSONParser::set_limits(const ParseLimits& new_limits) {
+    limits = new_limits;
+    limit_exceeded = LimitExceeded::NONE;
+    bytes_examined = 0;
+    nodes = 0;
+    next_limit_check = 0;
+}
+
+bool JSONParser::has_limits() const {
+    return limits.deadline != std::chrono::steady_clock::time_point::max() ||
+           limits.max_bytes != std::numeric_limits< size_t >::max() ||
+           limits.max_nodes != std::numeric_limits< size_t >::max();
+}
+
+void JSONParser::count_node() {
+    nodes += 1;
+    if (nodes >= limits.max_nodes && limit_exceeded == LimitExceeded::NONE) {
+        limit_exceeded = LimitExceeded::NODES;
+        log("Reached the maximum number of values, returning what was parsed so far");
+        next_limit_check = 0;
     }
-    return get_char_at_impl(pos);
 }
 
-void JSONParser::skip_whitespaces() {
-    try {
-        char current_char = get_char_at_impl(index);
-        while (std::isspace(current_char)) {
-            index += 1;
-            current_char = get_char_at_impl(index);
+bool JSONParser::within_limits() {
+    if (limit_exceeded != LimitExceeded::NONE) {
+        return false;
+    }
+    if (bytes_examined >= limits.max_bytes) {
+        limit_exceeded = LimitExceeded::BYTES;
+        log("Reached the maximum number of bytes examined, returning what was parsed so far");
+    } else if (limits.deadline != std::chrono::steady_clock::time_point::max() &&
+               std::chrono::steady_clock::now() >= limits.deadline) {
+        limit_exceeded = LimitExceeded::DEADLINE;
+        log("Reached the deadline, returning what was parsed so far");
+    } else {
+        // Only the deadline needs a periodic check
+        next_limit_check = limits.max_bytes;
+        if (limits.deadline != std::chrono::steady_clock::time_point::max()) {
+            next_limit_check = std::min(next_limit_check, bytes_examined + LIMIT_CHECK_INTERVAL);
         }
-    } catch (...) {
-        // Handle index out of bounds
+        return true;
+    }
+    next_limit_check = 0;
+    return false;
+}
+
+std::string JSONParser::get_range(size_t start, size_t stop) {
+    if (stop > get_length()) {
+        reached_end = true;
+        stop = get_length();
+    }
+    if (start >= stop) {
+        return "";
     }
+    if (std::holds_alternative< std::string >(json_str_variant)) {
+        return std::get< std::string >(json_str_variant).substr(start, stop - start);
+    }
+    return std::get< StringFileWrapper >(json_str_variant).get_range(start, stop);
 }
 
 size_t JSONParser::scroll_whitespaces(size_t idx) {
     try {
-        char current_char = get_char_at_impl(index + idx);
+        char current_char = charge_read() ? get_char_at_impl(index + idx) : '\0';
         while (std::isspace(current_char)) {
             idx += 1;
-            current_char = get_char_at_impl(index + idx);
+            current_char = charge_read() ? get_char_at_impl(index + idx) : '\0';
         }
     } catch (...) {
         // Handle index out of bounds
@@ -166,18 +318,62 @@ size_t JSONParser::scroll_whitespaces(size_t idx) {
 }
 
 size_t JSONParser::skip_to_character(char character, size_t idx) {
-    std::vector< char > chars = {character};
-    return skip_to_character(chars, idx);
+    size_t i = index + idx;
+    size_t n = get_length();
+    size_t backslashes = 0;
+
+    while (i < n) {
+        if (!charge_read()) {
+            // A limit was reached, the scan stops as if the input ended here
+            n = i;
+            break;
+        }
+        char ch = get_char_at_impl(i);
+        if (ch == '\0' && i >= get_length()) {
+            // A source of unknown length ended before n
+            n = std::max(get_length(), index);
+            break;
+        }
+
+        if (ch == '\\') {
+            backslashes += 1;
+            i += 1;
+            continue;
+        }
+
+        if (ch == character && (backslashes % 2 == 0)) {
+            return i - index;
+        }
+
+        backslashes = 0;
+        i += 1;
+    }
+
+    reached_end = true;
+    return n - index;
 }
 
 size_t JSONParser::skip_to_character(const std::vector< char >& characters, size_t idx) {
-    std::set< char > targets(characters.begin(), characters.end());
+    bool targets[256] = {};
+    for (char ch : characters) {
+        targets[static_cast< unsigned char >(ch)] = true;
+    }
     size_t i = index + idx;
     size_t n = get_length();
     size_t backslashes = 0;
 
     while (i < n) {
+        if (!charge_read()) {
+            // A limit was reached, the scan stops as if the input ended here
+            n = i;
+            break;
+        }
         char ch = get_char_at_impl(i);
+        if (ch == '\0' && i >= get_length()) {
+            // A source of unknown length ended before n
+            n = std::max(get_length(), index);
+            break;
+        }
 
         if (ch == '\\') {
             backslashes += 1;
@@ -185,7 +381,7 @@ size_t JSONParser::skip_to_character(const std::vector< char >& characters, size
             continue;
         }
 
-        if (targets.find(ch) != targets.end() && (backslashes % 2 == 0)) {
+        if (targets[static_cast< unsigned char >(ch)] && (backslashes % 2 == 0)) {
             return i - index;
         }
 
@@ -193,9 +389,159 @@ size_t JSONParser::skip_to_character(const std::vector< char >& characters, size
         i += 1;
     }
 
+    reached_end = true;
     return n - index;
 }
 
+size_t JSONParser::skip_value(size_t idx) {
+    // Skips one value without repairing it, ending where parse_json would: right after the closing
+    // bracket of a container or the closing quote of a string, at the first character that does not
+    // continue a number or a literal, and before the , } or ] that ends any other scalar
+    size_t i = index + idx;
+    size_t n = get_length();
+    // A source of unknown length ended before n, or a limit was reached and the scan stops at pos
+    auto ended = [&](size_t pos) {
+        if (pos < n && (get_char_at_impl(pos) != '\0' || pos < get_length()) && charge_read()) {
+            return false;
+        }
+        n = std::min(n, limit_exceeded != LimitExceeded::NONE ? pos : std::max(get_length(), index));
+        reached_end = true;
+        return true;
+    };
+    // Bytes of the string delimiter at pos, " ' or the UTF-8 “ and ”, 0 when there is none
+    auto quote_length = [&](size_t pos) -> size_t {
+        char ch = get_char_at_impl(pos);
+        if (ch == '"' || ch == '\'') {
+            return 1;
+        }
+        if (ch == '\xe2' && get_char_at_impl(pos + 1) == '\x80' &&
+            (get_char_at_impl(pos + 2) == '\x9c' || get_char_at_impl(pos + 2) == '\x9d')) {
+            return 3;
+        }
+        return 0;
+    };
+    // Moves pos past the string opened at pos, “ and ” are both closed by ”
+    auto skip_string = [&](size_t& pos) {
+        char open = get_char_at_impl(pos);
+        size_t length = quote_length(pos);
+        pos += length;
+        while (!ended(pos)) {
+            char ch = get_char_at_impl(pos);
+            if (ch == '\\') {
+                pos += 2;
+                continue;
+            }
+            pos += 1;
+            if (length == 1 ? ch == open
+                            : ch == '\xe2' && get_char_at_impl(pos) == '\x80' && get_char_at_impl(pos + 1) == '\x9d') {
+                pos += length - 1;
+                return;
+            }
+        }
+    };
+
+    while (!ended(i) && is_space(get_char_at_impl(i))) {
+        i += 1;
+    }
+    if (ended(i)) {
+        return n - index;
+    }
+    char first = get_char_at_impl(i);
+    if (quote_length(i)) {
+        skip_string(i);
+        return std::min(i, n) - index;
+    }
+    if (std::isdigit(static_cast< unsigned char >(first)) || first == '-' || first == '.') {
+        size_t end = i;
+        while (!ended(end) && std::strchr("0123456789-+.eE/", get_char_at_impl(end)) &&
+               get_char_at_impl(end) != '\0') {
+            end += 1;
+        }
+        // Letters after the digits make parse_number read a string instead
+        if (ended(end) || !std::isalpha(static_cast< unsigned char >(get_char_at_impl(end)))) {
+            return end - index;
+        }
+    }
+    // Only the first letter of a literal is case-insensitive, as in parse_string
+    for (const char* literal : {"true", "false", "null"}) {
+        size_t length = std::strlen(literal);
+        if (std::tolower(static_cast< unsigned char >(first)) != literal[0]) {
+            continue;
+        }
+        size_t k = 1;
+        while (k < length && get_char_at_impl(i + k) == literal[k]) {
+            k += 1;
+        }
+        if (k == length) {
+            return i + length - index;
+        }
+    }
+
+    // Containers and unquoted strings, a quote opens a string only where a key or a value starts
+    size_t depth = 0;
+    bool value_start = true;
+    while (!ended(i)) {
+        char ch = get_char_at_impl(i);
+        if (value_start && depth > 0 && quote_length(i)) {
+            skip_string(i);
+            value_start = false;
+            continue;
+        }
+        if (ch == '{' || ch == '[') {
+            depth += 1;
+            value_start = true;
+        } else if (ch == '}' || ch == ']') {
+            if (depth == 0) {
+                return i - index;
+            }
+            depth -= 1;
+            if (depth == 0) {
+                return i + 1 - index;
+            }
+            value_start = false;
+        } else if (ch == ',' && depth == 0) {
+            return i - index;
+        } else if (ch == ',' || ch == ':') {
+            value_start = true;
+        } else if (!is_space(ch)) {
+            value_start = false;
+        }
+        i += 1;
+    }
+    return n - index;
+}
+
+bool JSONParser::charge_backtrack(size_t bytes) {
+    auto* wrapper = std::get_if< StringFileWrapper >(&json_str_variant);
+    if (wrapper && wrapper->streamed() && wrapper->bytes_read() > budget_counted) {
+        backtrack_budget += BACKTRACK_RATIO * (wrapper->bytes_read() - budget_counted);
+        budget_counted = wrapper->bytes_read();
+    }
+    if (bytes > backtrack_budget) {
+        reached_end = true;
+        log("The backtracking budget is spent, keeping what was parsed instead of rolling back");
+        return false;
+    }
+    backtrack_budget -= bytes;
+    return true;
+}
+
+void JSONParser::remember_key(size_t start_index, std::string_view key) {
+    resolved_keys[start_index] = ResolvedKey{context.depth(), context.hash(), std::string(key), index};
+}
+
+const ResolvedKey* JSONParser::resolved_key() const {
+    if (resolved_keys.empty()) {
+        return nullptr;
+    }
+    auto it = resolved_keys.find(index);
+    if (it == resolved_keys.end() || it->second.context_depth != context.depth() ||
+        it->second.context_hash != context.hash()) {
+        return nullptr;
+    }
+    return &it->second;
+}
+
 void JSONParser::_log(const std::string& text) {
     size_t window = 10;
     size_t start = (index > window) ? index - window : 0;
@@ -208,51 +554,49 @@ void JSONParser::_log(const std::string& text) {
 
     std::map< std::string, std::string > log_entry;
     log_entry["text"] = text;
-    log_entry["context"] = context_str;
-    logger.push_back(log_entry);
+    log_entry["context"] = std::move(context_str);
+    logger.push_back(std::move(log_entry));
 }
 
-char JSONParser::get_char_at_impl(size_t pos) {
-    if (std::holds_alternative< std::string >(json_str_variant)) {
-        const std::string& str = std::get< std::string >(json_str_variant);
-        if (pos < str.length()) {
-            return str[pos];
+char JSONParser::get_wrapper_char_at(size_t pos) {
+    StringFileWrapper& wrapper = std::get< StringFileWrapper >(json_str_variant);
+    if (pos < wrapper.size()) {
+        std::string char_str = wrapper[pos];
+        if (char_str.empty()) {
+            reached_end = true;
+            return '\0';
         }
-        return '\0';
-    } else {
-        StringFileWrapper& wrapper = std::get< StringFileWrapper >(json_str_variant);
-        if (pos < wrapper.size()) {
-            std::string char_str = wrapper[pos];
-            return char_str.empty() ? '\0' : char_str[0];
-        }
-        return '\0';
-    }
-}
-
-size_t JSONParser::get_length() const {
-    if (std::holds_alternative< std::string >(json_str_variant)) {
-        return std::get< std::string >(json_str_variant).length();
-    } else {
-        return std::get< StringFileWrapper >(json_str_variant).size();
+        return char_str[0];
     }
+    reached_end = true;
+    return '\0';
 }
 
 std::vector< JSONReturnType > JSONParser::parse_array() {
-    return ::parse_array(*this);
+    JSONReturnType value = ::parse_array< JSONReturnType >(*this);
+    return std::move(value.get< JSONReturnType::VectorType >());
 }
 
 JSONReturnType JSONParser::parse_comment() {
-    return ::parse_comment(*this);
+    return ::parse_comment< JSONReturnType >(*this);
 }
 
 JSONReturnType JSONParser::parse_number() {
-    return ::parse_number(*this);
+    return ::parse_number< JSONReturnType >(*this);
 }
 
 JSONReturnType JSONParser::parse_object() {
-    return ::parse_object(*this);
+    return ::parse_object< JSONReturnType >(*this);
 }
 
 JSONReturnType::StringType JSONParser::parse_string() {
-    return ::parse_string(*this);
+    return ::parse_string< JSONReturnType >(*this);
+}
+
+JSONReturnType JSONParser::parse_typed() {
+    return ::parse_typed< JSONReturnType >(*this);
+}
+
+JSONReturnType JSONParser::parse_iterative() {
+    return ::parse_iterative< JSONReturnType >(*this);
 }
\ No newline at end of file
@@ -3,125 +3,354 @@
 
 #include "json_context.hpp"
 #include "object_comparer.hpp"
+#include "projection.hpp"
+#include "schema.hpp"
+#include "trace.hpp"
+#include "utf8.hpp"
 #include "string_file_wrapper.hpp"
 
+#include <atomic>
+#include <cctype>
+#include <chrono>
 #include <cstddef>
+#include <cstdio>
 #include <functional>
 #include <map>
 #include <memory>
+#include <memory_resource>
+#include <limits>
 #include <optional>
 #include <set>
 #include <stdexcept>
 #include <string>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
 #include <variant>
 #include <vector>
 
-struct JSONReturnType {
-    using MapType = std::map< std::string, JSONReturnType >;
-    using VectorType = std::vector< JSONReturnType >;
-    using StringType = std::string;
+#if defined(__GNUC__)
+#define JSON_REPAIR_FORCE_INLINE inline __attribute__((always_inline))
+#else
+#define JSON_REPAIR_FORCE_INLINE inline
+#endif
+
+// Read-only view of contiguous elements, std::span is C++20
+template < typename T > class ConstSpan {
+public:
+    ConstSpan() : pointer(nullptr), length(0) {}
+    ConstSpan(const T* pointer, size_t length) : pointer(pointer), length(length) {}
+
+    const T* data() const { return pointer; }
+    size_t size() const { return length; }
+    bool empty() const { return length == 0; }
+    const T& operator[](size_t index) const { return pointer[index]; }
+    const T* begin() const { return pointer; }
+    const T* end() const { return pointer + length; }
+
+private:
+    const T* pointer;
+    size_t length;
+};
+
+// Allocator is std::allocator for JSONReturnType and std::pmr::polymorphic_allocator for
+// PmrJSONReturnType, whose containers and strings live in the resource they were built from.
+template < template < typename > class Allocator > struct BasicJSONReturnType {
+    template < typename T > using AllocatorType = Allocator< T >;
+    using StringType = std::basic_string< char, std::char_traits< char >, Allocator< char > >;
+    using MapType = std::map< StringType,
+                              BasicJSONReturnType,
+                              std::less< StringType >,
+                              Allocator< std::pair< const StringType, BasicJSONReturnType > > >;
+    using VectorType = std::vector< BasicJSONReturnType, Allocator< BasicJSONReturnType > >;
     using DoubleType = double;
     using IntType = int;
     using BoolType = bool;
     using NullType = std::nullptr_t;
+    // Array of numbers stored contiguously. It is also a VectorType: the const get<>() and
+    // operator[] read an ordinary array of its numbers, built on first use and published
+    // atomically so a shared value can be read from any thread, and the non-const ones turn it
+    // into that array.
+    class PackedType : public std::vector< DoubleType, Allocator< DoubleType > > {
+    public:
+        using Numbers = std::vector< DoubleType, Allocator< DoubleType > >;
+        using Numbers::Numbers;
+
+        PackedType() = default;
+        PackedType(const PackedType& other) : Numbers(other) {}
+        PackedType(PackedType&& other) noexcept : Numbers(std::move(other)), view(other.view.exchange(nullptr)) {}
+
+        PackedType& operator=(const PackedType& other) {
+            Numbers::operator=(other);
+            forget_view();
+            return *this;
+        }
 
-    using Data =
-        std::variant< MapType, VectorType, StringType, DoubleType, IntType, BoolType, NullType >;
+        PackedType& operator=(PackedType&& other) {
+            Numbers::operator=(std::move(other));
+            forget_view();
+            other.forget_view();
+            return *this;
+        }
+
+        ~PackedType() { delete view.load(std::memory_order_acquire); }
+
+        const VectorType& as_vector() const {
+            VectorType* current = view.load(std::memory_order_acquire);
+            if (!current) {
+                auto* built =
+                    new VectorType(this->begin(), this->end(), typename VectorType::allocator_type(this->get_allocator()));
+                if (view.compare_exchange_strong(current, built, std::memory_order_acq_rel)) {
+                    current = built;
+                } else {
+                    delete built;
+                }
+            }
+            return *current;
+        }
+
+        // The numbers are about to change, a view built from them would be stale
+        void forget_view() { delete view.exchange(nullptr); }
+
+    private:
+        mutable std::atomic< VectorType* > view{nullptr};
+    };
+
+    using Data = std::variant< MapType, VectorType, StringType, DoubleType, IntType, BoolType, NullType, PackedType >;
 
 protected:
     Data data;
+    // Structural hash, computed by the constructors and assignments from the hashes of the
+    // children, so a parsed value gets it bottom-up as it is built. Reset to 0 by get<>() and
+    // operator[], which can modify in place, and computed again by the next hash(). The parents
+    // of a value modified through a reference kept from an earlier access are not reset.
+    mutable size_t hash_cache = 0;
+
+    static size_t combine(size_t seed, size_t value) {
+        return seed ^ (value + 0x9e3779b97f4a7c15ULL + (seed << 6) + (seed >> 2));
+    }
+
+    static size_t finish(size_t seed) { return seed == 0 ? 1 : seed; }
+
+    // Hash of a DoubleType value, 0.0 == -0.0 so both hash alike
+    static size_t hash_double(DoubleType value) {
+        return finish(combine(Data(value).index(), std::hash< DoubleType >()(value == 0 ? 0.0 : value)));
+    }
+
+    size_t compute_hash() const {
+        if (auto* d = std::get_if< DoubleType >(&data)) {
+            return hash_double(*d);
+        }
+        size_t seed = data.index();
+        if (auto* map = std::get_if< MapType >(&data)) {
+            for (const auto& [key, value] : *map) {
+                seed = combine(seed, std::hash< std::string_view >()(key));
+                seed = combine(seed, value.hash());
+            }
+        } else if (auto* vec = std::get_if< VectorType >(&data)) {
+            for (const auto& item : *vec) {
+                seed = combine(seed, item.hash());
+            }
+        } else if (auto* packed = std::get_if< PackedType >(&data)) {
+            // Same as the unpacked array, the two compare equal
+            seed = Data(std::in_place_type< VectorType >).index();
+            for (DoubleType value : *packed) {
+                seed = combine(seed, hash_double(value));
+            }
+        } else if (auto* str = std::get_if< StringType >(&data)) {
+            seed = combine(seed, std::hash< std::string_view >()(*str));
+        } else if (auto* i = std::get_if< IntType >(&data)) {
+            seed = combine(seed, std::hash< IntType >()(*i));
+        } else if (auto* b = std::get_if< BoolType >(&data)) {
+            seed = combine(seed, *b);
+        }
+        return finish(seed);
+    }
+
+    void rehash() { hash_cache = compute_hash(); }
+
+    void unpack() {
+        if (auto* packed = std::get_if< PackedType >(&data)) {
+            VectorType vec(typename VectorType::allocator_type(packed->get_allocator()));
+            vec.reserve(packed->size());
+            for (DoubleType value : *packed) {
+                vec.emplace_back(value);
+            }
+            data = std::move(vec);
+        }
+    }
+
+    static bool same_elements(const PackedType& packed, const VectorType& vec) {
+        if (packed.size() != vec.size()) {
+            return false;
+        }
+        for (size_t i = 0; i < packed.size(); ++i) {
+            if (vec[i] != packed[i]) {
+                return false;
+            }
+        }
+        return true;
+    }
 
 public:
-    JSONReturnType() : data(NullType()) {}
-    JSONReturnType(Data data) : data(std::move(data)) {}
-    JSONReturnType(const JSONReturnType& other) = default;
-    JSONReturnType(JSONReturnType&& other) = default;
+    BasicJSONReturnType() : data(NullType()) { rehash(); }
+    BasicJSONReturnType(Data data) : data(std::move(data)) { rehash(); }
+    BasicJSONReturnType(const BasicJSONReturnType& other) = default;
+    BasicJSONReturnType(BasicJSONReturnType&& other) noexcept(std::is_nothrow_move_constructible_v< Data >)
+        : data(std::move(other.data)), hash_cache(other.hash_cache) {
+        other.hash_cache = 0;
+    }
+
+    BasicJSONReturnType(const VectorType& vec) : data(vec) { rehash(); }
 
-    JSONReturnType(const VectorType& vec) : data(vec) {}
+    BasicJSONReturnType(VectorType&& vec) : data(std::move(vec)) { rehash(); }
 
-    JSONReturnType(VectorType&& vec) : data(std::move(vec)) {}
+    BasicJSONReturnType(const StringType& in_data) : data(in_data) { rehash(); }
 
-    JSONReturnType(const StringType& in_data) : data(in_data) {}
+    BasicJSONReturnType(StringType&& in_data) : data(std::move(in_data)) { rehash(); }
 
-    JSONReturnType(StringType&& in_data) : data(std::move(in_data)) {}
+    BasicJSONReturnType(const DoubleType& in_data) : data(in_data) { rehash(); }
 
-    JSONReturnType(const DoubleType& in_data) : data(in_data) {}
+    BasicJSONReturnType(const MapType& in_data) : data(in_data) { rehash(); }
 
-    JSONReturnType(const MapType& in_data) : data(in_data) {}
+    BasicJSONReturnType(MapType&& in_data) : data(std::move(in_data)) { rehash(); }
 
-    JSONReturnType(MapType&& in_data) : data(std::move(in_data)) {}
+    BasicJSONReturnType(PackedType&& in_data) : data(std::move(in_data)) { rehash(); }
 
     // Assignment operators with type-specific behavior
-    JSONReturnType& operator=(const JSONReturnType& other) {
+    BasicJSONReturnType& operator=(const BasicJSONReturnType& other) {
         if (this != &other) {
             data = other.data;
+            hash_cache = other.hash_cache;
         }
         return *this;
     }
 
-    JSONReturnType& operator=(JSONReturnType&& other) noexcept {
+    BasicJSONReturnType& operator=(BasicJSONReturnType&& other) noexcept {
         if (this != &other) {
             data = std::move(other.data);
+            hash_cache = other.hash_cache;
+            other.hash_cache = 0;
         }
         return *this;
     }
 
     // Assignment operators for each variant type
-    JSONReturnType& operator=(const MapType& map) {
+    BasicJSONReturnType& operator=(const MapType& map) {
         data = map;
+        rehash();
         return *this;
     }
 
-    JSONReturnType& operator=(MapType&& map) {
+    BasicJSONReturnType& operator=(MapType&& map) {
         data = std::move(map);
+        rehash();
         return *this;
     }
 
-    JSONReturnType& operator=(const VectorType& vec) {
+    BasicJSONReturnType& operator=(const VectorType& vec) {
         data = vec;
+        rehash();
         return *this;
     }
 
-    JSONReturnType& operator=(VectorType&& vec) {
+    BasicJSONReturnType& operator=(VectorType&& vec) {
         data = std::move(vec);
+        rehash();
         return *this;
     }
 
-    JSONReturnType& operator=(const StringType& str) {
+    BasicJSONReturnType& operator=(const StringType& str) {
         data = str;
+        rehash();
         return *this;
     }
 
-    JSONReturnType& operator=(StringType&& str) {
+    BasicJSONReturnType& operator=(StringType&& str) {
         data = std::move(str);
+        rehash();
         return *this;
     }
 
-    JSONReturnType& operator=(DoubleType d) {
+    BasicJSONReturnType& operator=(DoubleType d) {
         data = d;
+        rehash();
         return *this;
     }
 
-    JSONReturnType& operator=(IntType i) {
-        data = static_cast< DoubleType >(i); // Convert int to double to avoid ambiguity
+    BasicJSONReturnType& operator=(IntType i) {
+        data = static_cast< DoubleType >(i);
+        rehash(); // Convert int to double to avoid ambiguity
         return *this;
     }
 
-    JSONReturnType& operator=(BoolType b) {
+    BasicJSONReturnType& operator=(BoolType b) {
         data = b;
+        rehash();
         return *this;
     }
 
-    JSONReturnType& operator=(NullType n) {
+    BasicJSONReturnType& operator=(NullType n) {
         data = n;
+        rehash();
         return *this;
     }
 
+    // Allocator drawing from resource, std::allocator ignores it
+    template < typename T > static Allocator< T > allocator(std::pmr::memory_resource* resource) {
+        if constexpr (std::is_constructible_v< Allocator< T >, std::pmr::memory_resource* >) {
+            return Allocator< T >(resource);
+        } else {
+            return Allocator< T >();
+        }
+    }
+
+    static StringType make_string(std::string_view text, std::pmr::memory_resource* resource) {
+        return StringType(text.data(), text.size(), allocator< char >(resource));
+    }
+
+    static MapType make_map(std::pmr::memory_resource* resource) {
+        return MapType(allocator< typename MapType::value_type >(resource));
+    }
+
+    static VectorType make_vector(std::pmr::memory_resource* resource) {
+        return VectorType(allocator< BasicJSONReturnType >(resource));
+    }
+
+    static PackedType make_packed(std::pmr::memory_resource* resource) {
+        return PackedType(allocator< DoubleType >(resource));
+    }
+
+    static std::string dump_string(std::string_view str) {
+        std::string result = "\"";
+        result.reserve(str.size() + 2);
+        for (char c : str) {
+            switch (c) {
+            case '"': result += "\\\""; break;
+            case '\\': result += "\\\\"; break;
+            case '\n': result += "\\n"; break;
+            case '\r': result += "\\r"; break;
+            case '\t': result += "\\t"; break;
+            case '\b': result += "\\b"; break;
+            case '\f': result += "\\f"; break;
+            default:
+                if (static_cast< unsigned char >(c) < 0x20) {
+                    char escaped[7];
+                    std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+                    result += escaped;
+                } else {
+                    result += c;
+                }
+            }
+        }
+        result += '"';
+        return result;
+    }
+
     std::string dump(int indent = -1) const {
+        JSON_REPAIR_TRACE("dump", nullptr);
         if (std::holds_alternative< StringType >(data)) {
-            // Properly escape string for JSON
-            std::string str = std::get< StringType >(data);
-            return "\"" + str + "\"";
+            return dump_string(std::get< StringType >(data));
         } else if (std::holds_alternative< DoubleType >(data)) {
             return std::to_string(std::get< DoubleType >(data));
         } else if (std::holds_alternative< IntType >(data)) {
@@ -139,7 +368,7 @@ public:
                     result += ",";
                 if (indent >= 0)
                     result += "\n" + std::string(indent + 2, ' ');
-                result += "\"" + key + "\":" + (indent >= 0 ? " " : "") +
+                result += dump_string(key) + ":" + (indent >= 0 ? " " : "") +
                           value.dump(indent >= 0 ? indent + 2 : -1);
                 first = false;
             }
@@ -163,6 +392,22 @@ public:
                 result += "\n" + std::string(indent, ' ');
             result += "]";
             return result;
+        } else if (std::holds_alternative< PackedType >(data)) {
+            std::string result = "[";
+            const auto& packed = std::get< PackedType >(data);
+            bool first = true;
+            for (DoubleType value : packed) {
+                if (!first)
+                    result += ",";
+                if (indent >= 0)
+                    result += "\n" + std::string(indent + 2, ' ');
+                result += std::to_string(value);
+                first = false;
+            }
+            if (indent >= 0 && !packed.empty())
+                result += "\n" + std::string(indent, ' ');
+            result += "]";
+            return result;
         } else {
             throw std::runtime_error("Unknown JSON type");
         }
@@ -170,27 +415,91 @@ public:
 
     bool empty() const { return std::holds_alternative< NullType >(data); }
 
-    ~JSONReturnType() = default;
+    ~BasicJSONReturnType() = default;
+
+    template < typename T > bool is() const {
+        if constexpr (std::is_same_v< T, VectorType >) {
+            return std::holds_alternative< VectorType >(data) || std::holds_alternative< PackedType >(data);
+        }
+        return std::holds_alternative< T >(data);
+    }
+
+    template < typename T > T& get() {
+        if constexpr (std::is_same_v< T, VectorType >) {
+            unpack();
+        } else if constexpr (std::is_same_v< T, PackedType >) {
+            std::get< PackedType >(data).forget_view();
+        }
+        hash_cache = 0;
+        return std::get< T >(data);
+    }
+
+    // A packed array reads as the ordinary array of its numbers
+    template < typename T > const T& get() const {
+        if constexpr (std::is_same_v< T, VectorType >) {
+            if (auto* packed = std::get_if< PackedType >(&data)) {
+                return packed->as_vector();
+            }
+        }
+        return std::get< T >(data);
+    }
 
-    template < typename T > bool is() const { return std::holds_alternative< T >(data); }
+    // Elements of a packed array without unpacking it, empty for any other value
+    template < typename T > ConstSpan< T > as_span() const {
+        static_assert(std::is_same_v< T, DoubleType >, "arrays are only packed as doubles");
+        if (auto* packed = std::get_if< PackedType >(&data)) {
+            return ConstSpan< T >(packed->data(), packed->size());
+        }
+        return ConstSpan< T >();
+    }
 
-    template < typename T > T& get() { return std::get< T >(data); }
+    // Structural hash, equal values hash alike. Parsed values carry it from construction, so
+    // comparing the hashes of two of them is O(1) and only writes after a non-const access.
+    size_t hash() const {
+        if (hash_cache == 0) {
+            hash_cache = compute_hash();
+        }
+        return hash_cache;
+    }
 
-    template < typename T > const T& get() const { return std::get< T >(data); }
+    // Computes the hash of this value and of every nested value again. Const access to the value
+    // then never writes, so it can be shared between threads.
+    void freeze() {
+        if (auto* map = std::get_if< MapType >(&data)) {
+            for (auto& entry : *map) {
+                entry.second.freeze();
+            }
+        } else if (auto* vec = std::get_if< VectorType >(&data)) {
+            for (auto& item : *vec) {
+                item.freeze();
+            }
+        }
+        rehash();
+    }
 
-    // Comparison operators
-    bool operator==(const JSONReturnType& other) const { return data == other.data; }
+    // Comparison operators, a packed array equals the ordinary array of the same numbers. The
+    // cached hashes are not compared, they miss a child modified through an earlier reference.
+    bool operator==(const BasicJSONReturnType& other) const {
+        if (auto* packed = std::get_if< PackedType >(&data)) {
+            if (auto* vec = std::get_if< VectorType >(&other.data)) {
+                return same_elements(*packed, *vec);
+            }
+        } else if (auto* other_packed = std::get_if< PackedType >(&other.data)) {
+            if (auto* vec = std::get_if< VectorType >(&data)) {
+                return same_elements(*other_packed, *vec);
+            }
+        }
+        return data == other.data;
+    }
 
-    bool operator!=(const JSONReturnType& other) const { return data != other.data; }
+    bool operator!=(const BasicJSONReturnType& other) const { return !(*this == other); }
 
     // Comparison operators for each variant type
     bool operator!=(const MapType& map) const {
         return !std::holds_alternative< MapType >(data) || std::get< MapType >(data) != map;
     }
 
-    bool operator!=(const VectorType& vec) const {
-        return !std::holds_alternative< VectorType >(data) || std::get< VectorType >(data) != vec;
-    }
+    bool operator!=(const VectorType& vec) const { return !(*this == vec); }
 
     bool operator!=(const StringType& str) const {
         return !std::holds_alternative< StringType >(data) || std::get< StringType >(data) != str;
@@ -217,6 +526,9 @@ public:
     }
 
     bool operator==(const VectorType& vec) const {
+        if (auto* packed = std::get_if< PackedType >(&data)) {
+            return same_elements(*packed, vec);
+        }
         return std::holds_alternative< VectorType >(data) && std::get< VectorType >(data) == vec;
     }
 
@@ -240,18 +552,21 @@ public:
     bool operator==(NullType) const { return std::holds_alternative< NullType >(data); }
 
     // Subscript operators for accessing map and vector elements
-    JSONReturnType& operator[](const std::string& key) {
+    BasicJSONReturnType& operator[](const StringType& key) {
+        hash_cache = 0;
         if (!std::holds_alternative< MapType >(data)) {
             data = MapType{};
         }
         return std::get< MapType >(data)[key];
     }
 
-    const JSONReturnType& operator[](const std::string& key) const {
+    const BasicJSONReturnType& operator[](const StringType& key) const {
         return std::get< MapType >(data).at(key);
     }
 
-    JSONReturnType& operator[](size_t index) {
+    BasicJSONReturnType& operator[](size_t index) {
+        unpack();
+        hash_cache = 0;
         if (!std::holds_alternative< VectorType >(data)) {
             data = VectorType{};
         }
@@ -261,11 +576,57 @@ public:
         return std::get< VectorType >(data)[index];
     }
 
-    const JSONReturnType& operator[](size_t index) const {
-        return std::get< VectorType >(data).at(index);
-    }
+    const BasicJSONReturnType& operator[](size_t index) const { return get< VectorType >().at(index); }
+};
+
+using JSONReturnType = BasicJSONReturnType< std::allocator >;
+using PmrJSONReturnType = BasicJSONReturnType< std::pmr::polymorphic_allocator >;
+
+namespace std {
+template < template < typename > class Allocator > struct hash< BasicJSONReturnType< Allocator > > {
+    size_t operator()(const BasicJSONReturnType< Allocator >& value) const { return value.hash(); }
+};
+} // namespace std
+
+// Limits for one parse, the parser stops reading once one is reached and closes what is open
+struct ParseLimits {
+    std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max();
+    // Characters read, a character is read more than once when the parser looks ahead
+    size_t max_bytes = std::numeric_limits< size_t >::max();
+    // Values stored in objects and arrays
+    size_t max_nodes = std::numeric_limits< size_t >::max();
+};
+
+enum class LimitExceeded { NONE, DEADLINE, BYTES, NODES };
+
+// Value repaired before the parser stopped, the whole document when exceeded is NONE
+struct LimitedParse {
+    JSONReturnType value;
+    LimitExceeded exceeded;
+    size_t bytes_examined;
+    size_t nodes;
+    // Input offset where the parser stopped
+    size_t index;
+
+    bool complete() const { return exceeded == LimitExceeded::NONE; }
+};
+
+// Object key parsed before a duplicate key rollback, reused when the same offset is parsed as a key
+// again in the same context. The context is kept as its depth and hash, a copy of it would make
+// the rollbacks quadratic in the input length.
+struct ResolvedKey {
+    size_t context_depth;
+    uint64_t context_hash;
+    std::string key;
+    size_t end_index;
 };
 
+// Locals of a suspended parse_object, parse_array or parse_typed call, see parse_iterative.hpp
+template < typename Value > struct ParseFrame;
+
+// Repaired values shared between parsers, see result_cache.hpp
+class ResultCache;
+
 class JSONParser {
 public:
     // Split the parse methods into separate files because this one was like 3000 lines
@@ -274,29 +635,88 @@ public:
     JSONReturnType::VectorType parse_array();
     JSONReturnType parse_number();
     JSONReturnType::StringType parse_string();
+    JSONReturnType parse_typed();
+    JSONReturnType parse_iterative();
 
     JSONParser(const std::string& json_str,
                bool logging = false,
                size_t json_fd_chunk_length = 0,
-               bool stream_stable = false);
+               bool stream_stable = false,
+               std::shared_ptr< const Projection > projection = nullptr,
+               std::shared_ptr< const CompiledSchema > schema = nullptr);
 
     JSONParser(StringFileWrapper& json_fd_wrapper,
                bool logging = false,
                size_t json_fd_chunk_length = 0,
-               bool stream_stable = false);
+               bool stream_stable = false,
+               std::shared_ptr< const Projection > projection = nullptr,
+               std::shared_ptr< const CompiledSchema > schema = nullptr);
+
+    ~JSONParser();
+
+    // Starts over on new input. The options, limits and the capacity of the input, context,
+    // scratch and log buffers are kept, so a long-lived parser mostly allocates its output.
+    void reset(std::string_view json_str);
+    // Input received in pieces: append adds bytes after the current input and grows the backtracking
+    // budget with it, discard drops the first count bytes and moves index back by as much.
+    // Both need the input held in memory.
+    void append(std::string_view bytes);
+    void discard(size_t count);
 
     JSONReturnType parse();
+    // Same as parse(), with every string and container of the result allocated from resource
+    PmrJSONReturnType parse(std::pmr::memory_resource* resource);
     std::pair< JSONReturnType, std::vector< std::map< std::string, std::string > > >
     parse_with_logs();
+    LimitedParse parse_with_limits();
 
     JSONReturnType parse_json();
 
+    static constexpr size_t DEFAULT_MAX_DEPTH = 512;
+    static constexpr size_t BACKTRACK_RATIO = 4;
+
     char get_char_at(int count = 0);
+    std::string get_range(size_t start, size_t stop);
+    size_t get_length() const;
 
     void skip_whitespaces();
     size_t scroll_whitespaces(size_t idx = 0);
     size_t skip_to_character(char character, size_t idx = 0);
     size_t skip_to_character(const std::vector< char >& characters, size_t idx = 0);
+    size_t skip_value(size_t idx = 0);
+
+    // The input when it is held in memory, empty when it is read through a StringFileWrapper
+    std::string_view get_view() const;
+
+    void set_limits(const ParseLimits& new_limits);
+    bool has_limits() const;
+    // Counts a value stored in an object or an array against limits.max_nodes
+    void count_node();
+
+    // Takes bytes from the backtracking budget before a rewind, false when it is spent
+    bool charge_backtrack(size_t bytes);
+    void remember_key(size_t start_index, std::string_view key);
+    // Sets key and moves past it when the key at the current index was already resolved
+    template < typename String > bool recall_key(String& key) {
+        const ResolvedKey* resolved = resolved_key();
+        if (!resolved) {
+            return false;
+        }
+        key.assign(resolved->key);
+        index = resolved->end_index;
+        return true;
+    }
+
+    void log(const char* text) {
+        if (logging) {
+            _log(text);
+        }
+    }
+    void log(const std::string& text) {
+        if (logging) {
+            _log(text);
+        }
+    }
 
     size_t index;
     JsonContext context;
@@ -304,14 +724,122 @@ public:
     bool logging;
     std::vector< std::map< std::string, std::string > > logger;
     bool stream_stable;
-    std::function< void(const std::string&) > log;
+    std::shared_ptr< const Projection > projection;
+    // Keys and indices leading to the value being parsed, only tracked with a projection
+    Projection::Path path;
+    std::shared_ptr< const CompiledSchema > schema;
+    // Schema node of the value being parsed, CompiledSchema::ANY when there is nothing to check
+    size_t schema_node;
+    // parse() uses the explicit-stack engine unless this is false
+    bool iterative;
+    // Strings are validated as UTF-8 and repaired by this policy unless it is KEEP
+    Utf8Policy utf8_policy;
+    // Deeper containers are kept as their source text by the iterative engine. Destroying or
+    // dumping the result still recurses, so this also bounds the stack used by those.
+    size_t max_depth;
+    // Bytes the parser may still rewind, BACKTRACK_RATIO times the input length to start with.
+    // Once spent, empty objects are not reparsed as arrays and duplicate keys do not close
+    // objects, so the total work stays linear in the input length.
+    size_t backtrack_budget;
+    std::unordered_map< size_t, ResolvedKey > resolved_keys;
+    ParseLimits limits;
+    LimitExceeded limit_exceeded;
+    size_t bytes_examined;
+    size_t nodes;
+    // Reused between calls: the stack of the iterative engine and the parse_string accumulator
+    std::vector< ParseFrame< JSONReturnType > > frames;
+    std::string scratch;
+    // Set when the parse depended on where the input ends: a read at or past the end, a scan that
+    // ran into it, or a rewind refused for lack of budget, which grows with the input. A value
+    // parsed without setting it is the same whatever bytes follow.
+    bool reached_end;
+    // Where parse(resource) builds its result, the parse functions take it from here
+    std::pmr::memory_resource* resource;
+    // parse() returns a copy of the cached value when the same input was parsed with the same
+    // options, and caches what it parses
+    std::shared_ptr< ResultCache > cache;
 
 private:
+    template < typename Value > Value parse_values();
+    const ResolvedKey* resolved_key() const;
     void _log(const std::string& text);
+    // Called every LIMIT_CHECK_INTERVAL reads, false once a limit is reached
+    bool within_limits();
+
+    static constexpr size_t LIMIT_CHECK_INTERVAL = 4096;
+    // charge_read calls within_limits when bytes_examined reaches this
+    size_t next_limit_check;
+    // Counts one read against the limits, false once one is reached. get_char_at and the scans
+    // that read past index call it for every character.
+    bool charge_read();
+    // Bytes of a decompressed input already added to backtrack_budget. Its length is not known
+    // up front, so the budget grows as it is read, as it does for appended input.
+    size_t budget_counted;
 
     // Helper to get current character based on the variant type
     char get_char_at_impl(size_t pos);
-    size_t get_length() const;
+    // The StringFileWrapper case of get_char_at_impl, out of line
+    char get_wrapper_char_at(size_t pos);
 };
 
+// Called for every byte, so defined here to be inlined into the parse functions of every
+// translation unit
+JSON_REPAIR_FORCE_INLINE size_t JSONParser::get_length() const {
+    if (std::holds_alternative< std::string >(json_str_variant)) {
+        return std::get< std::string >(json_str_variant).length();
+    } else {
+        return std::get< StringFileWrapper >(json_str_variant).size();
+    }
+}
+
+JSON_REPAIR_FORCE_INLINE std::string_view JSONParser::get_view() const {
+    if (std::holds_alternative< std::string >(json_str_variant)) {
+        return std::get< std::string >(json_str_variant);
+    }
+    return std::string_view();
+}
+
+JSON_REPAIR_FORCE_INLINE char JSONParser::get_char_at_impl(size_t pos) {
+    if (std::holds_alternative< std::string >(json_str_variant)) {
+        const std::string& str = std::get< std::string >(json_str_variant);
+        if (pos < str.length()) {
+            return str[pos];
+        }
+        reached_end = true;
+        return '\0';
+    }
+    return get_wrapper_char_at(pos);
+}
+
+JSON_REPAIR_FORCE_INLINE bool JSONParser::charge_read() {
+    return ++bytes_examined < next_limit_check || within_limits();
+}
+
+JSON_REPAIR_FORCE_INLINE char JSONParser::get_char_at(int count) {
+    if (!charge_read()) {
+        return '\0';
+    }
+    size_t pos = index + count;
+    if (pos >= get_length()) {
+        reached_end = true;
+        return '\0';
+    }
+    return get_char_at_impl(pos);
+}
+
+JSON_REPAIR_FORCE_INLINE void JSONParser::skip_whitespaces() {
+    try {
+        char current_char = charge_read() ? get_char_at_impl(index) : '\0';
+        while (std::isspace(current_char)) {
+            index += 1;
+            current_char = charge_read() ? get_char_at_impl(index) : '\0';
+        }
+    } catch (...) {
+        // Handle index out of bounds
+    }
+}
+
+// parse_json for either value type, the parse functions recurse through it
+template < typename Value > Value parse_json(JSONParser& parser);
+
 #endif
\ No newline at end of file
@@ -0,0 +1,325 @@
+#include "parallel_repair.hpp"
+#include "constants.hpp"
+#include "parse_iterative.hpp"
+#include "parse_number.hpp"
+#include "parser_pool.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+namespace {
+
+bool is_digit(char c) {
+    return c >= '0' && c <= '9';
+}
+
+bool is_parser_space(char c) {
+    return std::isspace(static_cast< unsigned char >(c));
+}
+
+// Numbers read by the packed scan of an array from the start of a segment
+struct SegmentScan {
+    bool done = false;
+    JSONReturnType::PackedType numbers;
+    // Where the scan stopped, the start of the next segment when it read numbers up to it
+    size_t stop = 0;
+};
+
+// Members parsed from an index until one ends at or after the cut of a later segment
+struct SegmentParse {
+    bool done = false;
+    size_t from = 0;
+    // The parse did not depend on the bytes after its window, and stopped before a member with
+    // the container in the state it starts a segment in
+    bool exact = false;
+    bool closed = false;
+    // Where the next member starts, or the closing bracket or input end when closed
+    size_t stop = 0;
+    // Bytes taken from the backtracking budget
+    size_t backtracked = 0;
+    JSONReturnType members;
+};
+
+struct Segment {
+    // Top-level comma before the members, the opening bracket for the first segment
+    size_t cut;
+    // Where the container goes on after that comma
+    size_t start;
+    SegmentScan scan;
+    SegmentParse parse;
+};
+
+// Where the container goes on after the member before the comma at cut: end_element skips the
+// spaces and commas that follow, end_member the comma and the spaces after it
+size_t member_start(std::string_view text, size_t cut, char opener) {
+    size_t i = cut + 1;
+    while (i < text.size() && (is_parser_space(text[i]) || (opener == '[' && text[i] == ','))) {
+        ++i;
+    }
+    return i;
+}
+
+// Segments of the members of the container opened at open, cut at top-level commas. Strings are
+// told apart as in valid JSON, a cut in the middle of a repaired value only costs a fix-up.
+// In an object, parse_number reads on past a comma followed by a number character, so the cuts are
+// only made before a space, a string or a container.
+std::vector< Segment > split(std::string_view text, size_t open, size_t segment_bytes, size_t& close) {
+    char opener = text[open];
+    std::vector< Segment > segments{Segment{open, open + 1, {}, {}}};
+    size_t depth = 1;
+    close = std::string_view::npos;
+    for (size_t i = open + 1; i < text.size(); ++i) {
+        char c = text[i];
+        if (c == '"') {
+            // The closing quote is the first one after an even run of backslashes
+            for (size_t escapes = 1; escapes % 2 == 1;) {
+                const void* quote = std::memchr(text.data() + i + 1, '"', text.size() - i - 1);
+                if (!quote) {
+                    i = text.size();
+                    break;
+                }
+                i = static_cast< const char* >(quote) - text.data();
+                for (escapes = 0; text[i - 1 - escapes] == '\\'; ++escapes) {
+                }
+            }
+        } else if (c == '{' || c == '[') {
+            ++depth;
+        } else if (c == '}' || c == ']') {
+            if (--depth == 0) {
+                close = i;
+                break;
+            }
+        } else if (c == ',' && depth == 1 && i - segments.back().start >= segment_bytes && i + 1 < text.size() &&
+                   (is_space(text[i + 1]) || text[i + 1] == '"' || text[i + 1] == '{' || text[i + 1] == '[')) {
+            segments.push_back(Segment{i, member_start(text, i, opener), {}, {}});
+        }
+    }
+    return segments;
+}
+
+// Cut that ends segment s, npos for the last one, which runs to the closing bracket
+size_t segment_end(const std::vector< Segment >& segments, size_t s) {
+    return s + 1 < segments.size() ? segments[s + 1].cut : std::string_view::npos;
+}
+
+// Input a parser of segments up to last reads: the first byte of the next segment, which the skip
+// after a member looks at, or the rest of the input
+size_t window_end(std::string_view text, const std::vector< Segment >& segments, size_t last) {
+    return last + 1 < segments.size() ? std::min(text.size(), segments[last + 1].start + 1) : text.size();
+}
+
+// Packed scan of segment s, on its bytes only
+void scan_segment(std::string_view text, const std::vector< Segment >& segments, size_t s, SegmentScan& scan) {
+    size_t from = segments[s].start;
+    size_t end = s + 1 < segments.size() ? segments[s + 1].start : text.size();
+    auto parser = ParserPool::acquire(text.substr(from, end - from));
+    scan_packed_numbers(*parser, scan.numbers);
+    scan.stop = from + parser->index;
+    scan.done = true;
+}
+
+// Members from the member start at, until one ends at or after stop, read from text up to
+// window_end with budget bytes of backtracking
+void parse_segment(std::string_view text, char opener, size_t at, size_t stop, size_t window_end, size_t budget,
+                   SegmentParse& parse) {
+    auto parser = ParserPool::acquire(text.substr(at, window_end - at));
+    parser->backtrack_budget = budget;
+    size_t members_end = stop == std::string_view::npos ? stop : stop - at;
+    ParsedMembers< JSONReturnType > parsed = parse_members< JSONReturnType >(*parser, opener, members_end);
+    bool clean = parsed.closed;
+    if (!clean) {
+        // A key remembered by a rollback is read again by the next member
+        bool pending = std::any_of(parser->resolved_keys.begin(), parser->resolved_keys.end(),
+                                   [&](const auto& key) { return key.first >= parser->index; });
+        clean = !pending && parser->context.depth() == (opener == '[' ? 1u : 0u);
+    }
+    parse.from = at;
+    parse.exact = clean && (!parser->reached_end || window_end == text.size());
+    parse.closed = parsed.closed;
+    parse.stop = at + parser->index;
+    parse.backtracked = budget - parser->backtrack_budget;
+    parse.members = std::move(parsed.members);
+    parse.done = true;
+}
+
+// The members from at parsed as in place, on the calling thread with the budget left. The window
+// takes in twice as many segments each time the parse depends on where it ends.
+void parse_exact(std::string_view text, char opener, const std::vector< Segment >& segments, size_t s, size_t at,
+                 size_t budget, SegmentParse& parse) {
+    for (size_t last = s;; last = std::min(segments.size() - 1, 2 * last - s + 1)) {
+        parse_segment(text, opener, at, segment_end(segments, last), window_end(text, segments, last), budget, parse);
+        if (parse.exact) {
+            return;
+        }
+    }
+}
+
+// The members of a container of the same kind as target, appended to it
+void append(JSONReturnType& target, JSONReturnType&& members) {
+    if (target.is< JSONReturnType::MapType >()) {
+        auto& map = target.get< JSONReturnType::MapType >();
+        auto& more = members.get< JSONReturnType::MapType >();
+        // Later members win, as they do in one object
+        while (!more.empty()) {
+            auto node = more.extract(more.begin());
+            auto found = map.find(node.key());
+            if (found != map.end()) {
+                found->second = std::move(node.mapped());
+            } else {
+                map.insert(std::move(node));
+            }
+        }
+    } else {
+        auto& vec = target.get< JSONReturnType::VectorType >();
+        for (auto& value : members.get< JSONReturnType::VectorType >()) {
+            vec.push_back(std::move(value));
+        }
+    }
+}
+
+void lower_to(std::atomic< size_t >& bound, size_t value) {
+    size_t current = bound.load();
+    while (value < current && !bound.compare_exchange_weak(current, value)) {
+    }
+}
+
+} // namespace
+
+JSONReturnType parse_parallel(const std::string& input, const ParallelOptions& options) {
+    auto sequential = [&]() { return ParserPool::acquire(input)->parse(); };
+    std::string_view text(input);
+    size_t open = skip_spaces(text, 0);
+    if (open >= text.size() || (text[open] != '[' && text[open] != '{')) {
+        return sequential();
+    }
+    char opener = text[open];
+    size_t close;
+    std::vector< Segment > segments = split(text, open, options.segment_bytes, close);
+    if (segments.size() < 2 ||
+        (close != std::string_view::npos && skip_spaces(text, close + 1) < text.size())) {
+        return sequential();
+    }
+    size_t budget = JSONParser::BACKTRACK_RATIO * text.size();
+
+    // Every segment is parsed as if the container went on at its start after a member, with the
+    // whole budget. The merge below only keeps the parses that start where the previous one stopped.
+    // Segments after one that closes the container are not parsed, and the numbers of an array are
+    // only parsed as members once a segment before them is known to hold something else.
+    std::atomic< size_t > next{0};
+    std::atomic< size_t > last{segments.size() - 1};
+    std::atomic< size_t > not_numbers{opener == '[' ? segments.size() : 0};
+    auto work = [&]() {
+        for (size_t s = next++; s < segments.size(); s = next++) {
+            if (s > last) {
+                continue;
+            }
+            Segment& segment = segments[s];
+            size_t at = segment.start;
+            try {
+                if (s < not_numbers && (s == 0 || text[at] == '-' || is_digit(text[at]))) {
+                    scan_segment(text, segments, s, segment.scan);
+                    if (s + 1 < segments.size() && segment.scan.stop == segments[s + 1].start) {
+                        if (s < not_numbers) {
+                            continue;
+                        }
+                    } else {
+                        lower_to(not_numbers, s);
+                    }
+                    if (s == 0) {
+                        at = segment.scan.stop;
+                    }
+                }
+                parse_segment(text, opener, at, segment_end(segments, s), window_end(text, segments, s), budget,
+                              segment.parse);
+            } catch (...) {
+                // Parsed again on the calling thread, where it throws as it does in place
+                continue;
+            }
+            if (segment.parse.closed && segment.parse.exact) {
+                lower_to(last, s);
+            }
+        }
+    };
+    unsigned threads = options.threads ? options.threads : std::max(1u, std::thread::hardware_concurrency());
+    std::vector< std::thread > workers;
+    for (unsigned t = 1; t < std::min< size_t >(threads, segments.size()); ++t) {
+        workers.emplace_back(work);
+    }
+    work();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+
+    // The parses chained from the opening bracket. Where a parse stopped somewhere else than at the
+    // start of the next segment, or depended on its window, the container is parsed as in place
+    // from there until the next segment boundary it reaches.
+    JSONReturnType result = opener == '{' ? JSONReturnType(JSONReturnType::MapType())
+                                          : JSONReturnType(JSONReturnType::VectorType());
+    if (opener == '[') {
+        // Most members parsed are kept, moving them once
+        size_t members = 0;
+        for (const Segment& segment : segments) {
+            if (segment.parse.done) {
+                members += segment.parse.members.get< JSONReturnType::VectorType >().size();
+            }
+        }
+        result.get< JSONReturnType::VectorType >().reserve(members);
+    }
+    JSONReturnType::PackedType numbers;
+    bool packed = opener == '[';
+    size_t spent = 0;
+    size_t at = segments[0].start;
+    size_t s = 0;
+    while (true) {
+        Segment& segment = segments[s];
+        if (packed) {
+            if (!segment.scan.done) {
+                scan_segment(text, segments, s, segment.scan);
+            }
+            numbers.insert(numbers.end(), segment.scan.numbers.begin(), segment.scan.numbers.end());
+            if (s + 1 < segments.size() && segment.scan.stop == segments[s + 1].start) {
+                at = segments[++s].start;
+                continue;
+            }
+            at = segment.scan.stop;
+            if (at < text.size() && text[at] == ']' && !numbers.empty()) {
+                result = std::move(numbers);
+                break;
+            }
+            packed = false;
+            auto& vec = result.get< JSONReturnType::VectorType >();
+            vec.reserve(numbers.size());
+            for (double number : numbers) {
+                vec.emplace_back(number);
+            }
+        }
+        SegmentParse fixed;
+        SegmentParse* parse = &segment.parse;
+        if (!parse->done || parse->from != at || !parse->exact || spent + parse->backtracked > budget) {
+            parse_exact(text, opener, segments, s, at, budget - spent, fixed);
+            parse = &fixed;
+        }
+        append(result, std::move(parse->members));
+        spent += parse->backtracked;
+        at = parse->stop;
+        if (parse->closed) {
+            break;
+        }
+        while (s + 1 < segments.size() && at >= segments[s + 1].cut) {
+            ++s;
+        }
+    }
+
+    // The closing bracket, or the end of the input, is at index at. What follows is parsed as more
+    // top-level values, and an object with no members is parsed again as an array.
+    if ((at < text.size() && skip_spaces(text, at + 1) < text.size()) ||
+        (result.is< JSONReturnType::MapType >() && result.get< JSONReturnType::MapType >().empty() &&
+         at - open > 2)) {
+        return sequential();
+    }
+    return result;
+}
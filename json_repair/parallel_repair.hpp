@@ -0,0 +1,25 @@
+#ifndef PARALLEL_REPAIR_HPP
+#define PARALLEL_REPAIR_HPP
+
+#include "json_parser.hpp"
+
+#include <cstddef>
+#include <string>
+
+struct ParallelOptions {
+    // Worker threads, 0 for std::thread::hardware_concurrency()
+    unsigned threads = 0;
+    // Segments are cut at the first top-level comma after this many bytes
+    size_t segment_bytes = 1 << 20;
+};
+
+// Same value as JSONParser(input).parse(), with the members of one top-level array or object
+// repaired on several threads. The input is cut into segments at the top-level commas found by a
+// structural scan, and each segment is repaired on its own as if the container went on at its start
+// after a member. A segment is kept when the one before it stopped at its start without depending on
+// the bytes after it. Where a repair moved the boundary, as an unterminated string does, the
+// container is repaired as in place from there until it stops at the start of a later segment.
+// Trailing values and an empty object parsed again as an array fall back to the sequential parse.
+JSONReturnType parse_parallel(const std::string& input, const ParallelOptions& options = ParallelOptions());
+
+#endif
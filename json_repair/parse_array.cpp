@@ -1,34 +1,82 @@
 #include "parse_array.hpp"
 #include "constants.hpp"
 #include "object_comparer.hpp"
+#include "parse_number.hpp"
+#include "parse_object.hpp"
+#include "parse_string.hpp"
+#include "parse_typed.hpp"
 #include <cctype>
 
-std::vector<JSONReturnType> parse_array(JSONParser& parser) {
-    std::vector<JSONReturnType> arr;
+template < typename Value > Value parse_array(JSONParser& parser) {
+    JSON_REPAIR_TRACE("parse_array", &parser.index);
+    typename Value::VectorType arr = Value::make_vector(parser.resource);
     parser.context.set(ContextValues::ARRAY);
+    typename Value::PackedType packed = Value::make_packed(parser.resource);
+    if (scan_packed_numbers(parser, packed)) {
+        parser.index += 1;
+        parser.context.reset();
+        return packed;
+    }
+    arr.reserve(packed.size());
+    for (double number : packed) {
+        arr.emplace_back(number);
+    }
     char current_char = parser.get_char_at();
+    size_t projected_out = 0;
+    size_t array_node = parser.schema_node;
     while (current_char && current_char != ']' && current_char != '}') {
         parser.skip_whitespaces();
-        JSONReturnType value = std::string("");
+        if (parser.projection) {
+            parser.path.push_back(std::to_string(arr.size() + projected_out));
+            if (!parser.projection->keep(parser.path)) {
+                parser.path.pop_back();
+                char next_char = parser.get_char_at();
+                if (next_char && next_char != ']' && next_char != '}') {
+                    parser.index += parser.skip_value();
+                    projected_out += 1;
+                }
+                current_char = parser.get_char_at();
+                while (current_char && current_char != ']' && (std::isspace(current_char) || current_char == ',')) {
+                    parser.index += 1;
+                    current_char = parser.get_char_at();
+                }
+                continue;
+            }
+        }
+        if (parser.schema) {
+            parser.schema_node = parser.schema->items(array_node);
+        }
+        size_t value_index = parser.index;
+        Value value = Value::make_string("", parser.resource);
         if (std::find(STRING_DELIMITERS.begin(), STRING_DELIMITERS.end(), std::string(1, current_char)) != STRING_DELIMITERS.end()) {
             size_t i = 1;
             i = parser.skip_to_character(current_char, i);
             i = parser.scroll_whitespaces(i + 1);
             if (parser.get_char_at(i) == ':') {
-                value = parser.parse_object();
+                value = parse_object< Value >(parser);
+            } else if (parser.schema_node != CompiledSchema::ANY) {
+                value = parse_typed< Value >(parser);
             } else {
-                value = parser.parse_string();
+                value = parse_string< Value >(parser);
             }
         } else {
-            value = parser.parse_json();
+            value = parse_json< Value >(parser);
+        }
+        if (parser.projection) {
+            parser.path.pop_back();
         }
+        parser.schema_node = array_node;
 
-        if (ObjectComparer::is_strictly_empty(value)) {
+        if (parser.index == value_index && parser.get_char_at()) {
+            parser.log("While parsing an array, the value did not consume anything, skipping a character");
+            parser.index += 1;
+        } else if (ObjectComparer::is_strictly_empty(value)) {
             parser.index += 1;
         } else if (value == "..." && parser.get_char_at(-1) == '.') {
             parser.log("While parsing an array, found a stray '...'; ignoring it");
         } else {
-            arr.push_back(value);
+            arr.push_back(std::move(value));
+            parser.count_node();
         }
 
         current_char = parser.get_char_at();
@@ -45,4 +93,7 @@ std::vector<JSONReturnType> parse_array(JSONParser& parser) {
     parser.index += 1;
     parser.context.reset();
     return arr;
-}
\ No newline at end of file
+}
+
+template JSONReturnType parse_array< JSONReturnType >(JSONParser& parser);
+template PmrJSONReturnType parse_array< PmrJSONReturnType >(JSONParser& parser);
\ No newline at end of file
@@ -3,6 +3,7 @@
 
 #include "json_parser.hpp"
 
-std::vector<JSONReturnType> parse_array(JSONParser& parser);
+// Instantiated for JSONReturnType and PmrJSONReturnType
+template < typename Value > Value parse_array(JSONParser& parser);
 
-#endif
\ No newline at end of file
+#endif
@@ -3,69 +3,78 @@
 #include <cctype>
 #include <algorithm>
 
-JSONReturnType parse_comment(JSONParser& parser) {
+void skip_comment(JSONParser& parser) {
     char current_char = parser.get_char_at();
-    std::vector<char> termination_characters = {'\n', '\r'};
+    std::string termination_characters = "\n\r";
     
-    if (std::find(parser.context.getContext().begin(), parser.context.getContext().end(), ContextValues::ARRAY) != parser.context.getContext().end()) {
-        termination_characters.push_back(']');
+    if (parser.context.contains(ContextValues::ARRAY)) {
+        termination_characters += ']';
     }
-    if (std::find(parser.context.getContext().begin(), parser.context.getContext().end(), ContextValues::OBJECT_VALUE) != parser.context.getContext().end()) {
-        termination_characters.push_back('}');
+    if (parser.context.contains(ContextValues::OBJECT_VALUE)) {
+        termination_characters += '}';
     }
-    if (std::find(parser.context.getContext().begin(), parser.context.getContext().end(), ContextValues::OBJECT_KEY) != parser.context.getContext().end()) {
-        termination_characters.push_back(':');
+    if (parser.context.contains(ContextValues::OBJECT_KEY)) {
+        termination_characters += ':';
     }
     
+    // The comment text is only kept for the log
+    size_t start_index = parser.index;
     if (current_char == '#') {
-        std::string comment = "";
-        while (current_char && 
-               std::find(termination_characters.begin(), termination_characters.end(), current_char) == termination_characters.end()) {
-            comment += current_char;
+        while (current_char && termination_characters.find(current_char) == std::string::npos) {
             parser.index += 1;
             current_char = parser.get_char_at();
         }
-        parser.log("Found line comment: " + comment + ", ignoring");
+        if (parser.logging) {
+            parser.log("Found line comment: " + parser.get_range(start_index, parser.index) + ", ignoring");
+        }
     }
     else if (current_char == '/') {
         char next_char = parser.get_char_at(1);
         if (next_char == '/') {
-            std::string comment = "//";
             parser.index += 2;
             current_char = parser.get_char_at();
-            while (current_char && 
-                   std::find(termination_characters.begin(), termination_characters.end(), current_char) == termination_characters.end()) {
-                comment += current_char;
+            while (current_char && termination_characters.find(current_char) == std::string::npos) {
                 parser.index += 1;
                 current_char = parser.get_char_at();
             }
-            parser.log("Found line comment: " + comment + ", ignoring");
+            if (parser.logging) {
+                parser.log("Found line comment: " + parser.get_range(start_index, parser.index) + ", ignoring");
+            }
         }
         else if (next_char == '*') {
-            std::string comment = "/*";
             parser.index += 2;
+            char previous_char = '*';
             while (true) {
                 current_char = parser.get_char_at();
                 if (!current_char) {
                     parser.log("Reached end-of-string while parsing block comment; unclosed block comment.");
                     break;
                 }
-                comment += current_char;
                 parser.index += 1;
-                if (comment.length() >= 2 && comment.substr(comment.length() - 2) == "*/") {
+                if (previous_char == '*' && current_char == '/') {
                     break;
                 }
+                previous_char = current_char;
+            }
+            if (parser.logging) {
+                parser.log("Found block comment: " + parser.get_range(start_index, parser.index) + ", ignoring");
             }
-            parser.log("Found block comment: " + comment + ", ignoring");
         }
         else {
             parser.index += 1;
         }
     }
-    
+}
+
+template < typename Value > Value parse_comment(JSONParser& parser) {
+    JSON_REPAIR_TRACE("parse_comment", &parser.index);
+    skip_comment(parser);
     if (parser.context.isEmpty()) {
-        return parser.parse_json();
+        return parse_json< Value >(parser);
     } else {
-        return std::string("");
+        return Value::make_string("", parser.resource);
     }
-}
\ No newline at end of file
+}
+
+template JSONReturnType parse_comment< JSONReturnType >(JSONParser& parser);
+template PmrJSONReturnType parse_comment< PmrJSONReturnType >(JSONParser& parser);
\ No newline at end of file
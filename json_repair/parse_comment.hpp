@@ -3,6 +3,8 @@
 
 #include "json_parser.hpp"
 
-JSONReturnType parse_comment(JSONParser& parser);
+// Skips the comment at the current index without parsing what follows it
+void skip_comment(JSONParser& parser);
+template < typename Value > Value parse_comment(JSONParser& parser);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,473 @@
+#include "parse_iterative.hpp"
+#include "constants.hpp"
+#include "object_comparer.hpp"
+#include "parse_comment.hpp"
+#include "parse_number.hpp"
+#include "parse_object.hpp"
+#include "parse_string.hpp"
+#include "parse_typed.hpp"
+#include <algorithm>
+#include <cctype>
+
+namespace {
+
+template < typename Value > class IterativeParser {
+    using Frame = ParseFrame< Value >;
+
+public:
+    // Borrows the stack of the parser, so its capacity survives between parses. A stack of
+    // PmrJSONReturnType frames is allocated from the parser resource instead.
+    explicit IterativeParser(JSONParser& parser)
+        : parser(parser),
+          stack(Value::template allocator< Frame >(parser.resource)),
+          depth(0),
+          has_result(false),
+          members(false),
+          members_end(std::string_view::npos),
+          members_done(false),
+          members_closed(false) {
+        if constexpr (std::is_same_v< Value, JSONReturnType >) {
+            stack.swap(parser.frames);
+            stack.clear();
+        }
+        stack.reserve(std::min< size_t >(parser.max_depth, 64) + 1);
+    }
+
+    ~IterativeParser() {
+        if constexpr (std::is_same_v< Value, JSONReturnType >) {
+            stack.clear();
+            stack.swap(parser.frames);
+        }
+    }
+
+    Value run() {
+        begin_value();
+        while (!has_result || !stack.empty()) {
+            step();
+        }
+        return std::move(result);
+    }
+
+    // parse_members, the container is the frame at the bottom of the stack
+    ParsedMembers< Value > run_members(char opener, size_t stop) {
+        members = true;
+        members_end = stop;
+        if (opener == '{') {
+            push_object();
+        } else {
+            Frame frame(parser.resource);
+            frame.kind = Frame::ARRAY;
+            frame.node = parser.schema_node;
+            JSON_REPAIR_TRACE_OPEN(frame.trace, "parse_array", parser.index);
+            parser.context.set(ContextValues::ARRAY);
+            frame.current_char = parser.get_char_at();
+            stack.push_back(std::move(frame));
+            depth += 1;
+        }
+        while (!members_done) {
+            step();
+        }
+        Frame& frame = stack.front();
+        if (frame.kind == Frame::OBJECT) {
+            return ParsedMembers< Value >{std::move(frame.obj), members_closed};
+        }
+        return ParsedMembers< Value >{std::move(frame.arr), members_closed};
+    }
+
+private:
+    // Hands the pending result to the frame on top, or goes on with that frame
+    void step() {
+        if (has_result) {
+            has_result = false;
+            receive(std::move(result));
+        } else if (stack.back().kind == Frame::OBJECT) {
+            step_object();
+        } else {
+            step_array();
+        }
+    }
+
+    // The frame at the bottom of the stack is the container of parse_members
+    bool at_members() const { return members && stack.size() == 1; }
+
+    void end_members(bool closed) {
+        JSON_REPAIR_TRACE_CLOSE(stack.back().trace, parser.index);
+        members_done = true;
+        members_closed = closed;
+    }
+
+    void deliver(Value value) {
+        result = std::move(value);
+        has_result = true;
+    }
+
+    void finish(Value value) {
+        JSON_REPAIR_TRACE_CLOSE(stack.back().trace, parser.index);
+        if (stack.back().kind != Frame::TYPED) {
+            depth -= 1;
+        }
+        stack.pop_back();
+        deliver(std::move(value));
+    }
+
+    bool can_nest() { return depth < parser.max_depth; }
+
+    // The container at the current index is too deep, keep it unrepaired
+    void deliver_source() {
+        parser.log("Reached the maximum nesting depth, keeping the nested value as a string");
+        size_t start_index = parser.index;
+        parser.index += parser.skip_value();
+        deliver(Value::make_string(parser.get_range(start_index, parser.index), parser.resource));
+    }
+
+    void push_object() {
+        Frame frame(parser.resource);
+        frame.kind = Frame::OBJECT;
+        frame.start_index = parser.index;
+        frame.node = parser.schema_node;
+        JSON_REPAIR_TRACE_OPEN(frame.trace, "parse_object", parser.index);
+        stack.push_back(std::move(frame));
+        depth += 1;
+    }
+
+    void push_array() {
+        Frame frame(parser.resource);
+        frame.kind = Frame::ARRAY;
+        frame.node = parser.schema_node;
+        JSON_REPAIR_TRACE_OPEN(frame.trace, "parse_array", parser.index);
+        parser.context.set(ContextValues::ARRAY);
+        typename Value::PackedType packed = Value::make_packed(parser.resource);
+        if (scan_packed_numbers(parser, packed)) {
+            parser.index += 1;
+            parser.context.reset();
+            JSON_REPAIR_TRACE_CLOSE(frame.trace, parser.index);
+            return deliver(std::move(packed));
+        }
+        frame.arr.reserve(packed.size());
+        for (double number : packed) {
+            frame.arr.emplace_back(number);
+        }
+        frame.current_char = parser.get_char_at();
+        stack.push_back(std::move(frame));
+        depth += 1;
+    }
+
+    // parse_json
+    void begin_value() {
+        while (true) {
+            char current_char = parser.get_char_at();
+            if (current_char == '\0') {
+                return deliver(Value::make_string("", parser.resource));
+            } else if (parser.schema_node != CompiledSchema::ANY && !parser.context.isEmpty() &&
+                       (current_char == '{' || current_char == '[' || current_char == '-' ||
+                        current_char == '.' || std::isalnum(static_cast< unsigned char >(current_char)) ||
+                        is_string_delimiter(current_char))) {
+                return begin_typed();
+            } else if (current_char == '{' || current_char == '[') {
+                if (!can_nest()) {
+                    return deliver_source();
+                }
+                parser.index += 1;
+                return current_char == '{' ? push_object() : push_array();
+            } else if (!parser.context.isEmpty() && (is_string_delimiter(current_char) || std::isalpha(current_char))) {
+                return deliver(parse_string< Value >(parser));
+            } else if (!parser.context.isEmpty() &&
+                       (std::isdigit(current_char) || current_char == '-' || current_char == '.')) {
+                return deliver(parse_number< Value >(parser));
+            } else if (current_char == '#' || current_char == '/') {
+                skip_comment(parser);
+                if (!parser.context.isEmpty()) {
+                    return deliver(Value::make_string("", parser.resource));
+                }
+            } else {
+                parser.index += 1;
+            }
+        }
+    }
+
+    // parse_typed, scalars never recurse so only containers get a frame
+    void begin_typed() {
+        char current_char = parser.get_char_at();
+        if (current_char != '{' && current_char != '[') {
+            return deliver(parse_typed< Value >(parser));
+        }
+        if (!can_nest()) {
+            return deliver_source();
+        }
+        Frame frame(parser.resource);
+        frame.kind = Frame::TYPED;
+        frame.start_index = parser.index;
+        frame.types = parser.schema->node(parser.schema_node).types;
+        JSON_REPAIR_TRACE_OPEN(frame.trace, "parse_typed", parser.index);
+        stack.push_back(std::move(frame));
+        parser.index += 1;
+        current_char == '{' ? push_object() : push_array();
+    }
+
+    void receive(Value value) {
+        Frame& frame = stack.back();
+        if (frame.kind == Frame::TYPED) {
+            finish(coerce_typed< Value >(parser, std::move(value), frame.types, frame.start_index));
+        } else if (frame.kind == Frame::ARRAY) {
+            end_element(std::move(value));
+        } else if (frame.merging) {
+            merge_pairs(frame.obj, value.template get< typename Value::MapType >());
+            finish(std::move(frame.obj));
+        } else {
+            end_member(std::move(value));
+        }
+    }
+
+    void end_member(Value value) {
+        Frame& frame = stack.back();
+        parser.schema_node = frame.node;
+        if (parser.projection) {
+            parser.path.pop_back();
+        }
+        parser.context.reset();
+        frame.obj.insert_or_assign(std::move(frame.key), std::move(value));
+        parser.count_node();
+
+        if (parser.get_char_at() == ',' || parser.get_char_at() == '\'' || parser.get_char_at() == '"') {
+            parser.index += 1;
+        }
+
+        parser.skip_whitespaces();
+    }
+
+    // parse_object from the top of its loop, until it needs a value or returns
+    void step_object() {
+        Frame& frame = stack.back();
+        while (parser.get_char_at() != '}' && parser.get_char_at() != '\0') {
+            if (parser.index >= members_end && at_members()) {
+                return end_members(false);
+            }
+            parser.skip_whitespaces();
+
+            if (parser.get_char_at() == ':') {
+                parser.log("While parsing an object we found a : before a key, ignoring");
+                parser.index += 1;
+            }
+
+            parser.context.set(ContextValues::OBJECT_KEY);
+
+            size_t rollback_index = parser.index;
+
+            typename Value::StringType key = Value::make_string("", parser.resource);
+            while (parser.get_char_at() != '\0') {
+                rollback_index = parser.index;
+                if (!parser.recall_key(key)) {
+                    key = parse_string< Value >(parser);
+                }
+                if (key.empty()) {
+                    parser.skip_whitespaces();
+                }
+                if (!key.empty() || (key.empty() && (parser.get_char_at() == ':' || parser.get_char_at() == '}'))) {
+                    break;
+                }
+            }
+
+            if (parser.context.contains(ContextValues::ARRAY) && frame.obj.find(key) != frame.obj.end() &&
+                parser.charge_backtrack(parser.index - rollback_index + 1)) {
+                parser.log("While parsing an object we found a duplicate key, closing the object here and rolling back the index");
+                parser.remember_key(rollback_index, key);
+                parser.index = rollback_index - 1;
+                break;
+            }
+
+            parser.skip_whitespaces();
+
+            if (parser.get_char_at() == '}' || parser.get_char_at() == '\0') {
+                continue;
+            }
+
+            parser.skip_whitespaces();
+
+            if (parser.get_char_at() != ':') {
+                parser.log("While parsing an object we missed a : after a key");
+            }
+
+            parser.index += 1;
+            parser.context.reset();
+            parser.context.set(ContextValues::OBJECT_VALUE);
+            parser.skip_whitespaces();
+
+            if (parser.projection) {
+                parser.path.emplace_back(key);
+                if (!parser.projection->keep(parser.path)) {
+                    if (parser.get_char_at() != ',' && parser.get_char_at() != '}') {
+                        parser.index += parser.skip_value();
+                    }
+                    parser.path.pop_back();
+                    parser.context.reset();
+                    frame.projected_out = true;
+                    if (parser.get_char_at() == ',') {
+                        parser.index += 1;
+                    }
+                    parser.skip_whitespaces();
+                    continue;
+                }
+            }
+
+            if (parser.schema) {
+                parser.schema_node = parser.schema->property(frame.node, key);
+            }
+            frame.key = std::move(key);
+            if (parser.get_char_at() == ',' || parser.get_char_at() == '}') {
+                parser.log("While parsing an object value we found a stray , ignoring it");
+                end_member(Value::make_string("", parser.resource));
+                continue;
+            }
+            // May push a frame, frame is not used after this
+            return begin_value();
+        }
+
+        if (at_members()) {
+            return end_members(true);
+        }
+        parser.index += 1;
+
+        if (frame.obj.empty() && !frame.projected_out && parser.index - frame.start_index > 2 &&
+            parser.charge_backtrack(parser.index - frame.start_index)) {
+            parser.log("Parsed object is empty, we will try to parse this as an array instead");
+            parser.index = frame.start_index;
+            JSON_REPAIR_TRACE_CLOSE(frame.trace, parser.index);
+            // parse_object returns parse_array, the array takes over the frame
+            stack.pop_back();
+            depth -= 1;
+            return push_array();
+        }
+
+        if (!parser.context.isEmpty()) {
+            return finish(std::move(frame.obj));
+        }
+
+        parser.skip_whitespaces();
+        if (parser.get_char_at() != ',') {
+            return finish(std::move(frame.obj));
+        }
+        parser.index += 1;
+        parser.skip_whitespaces();
+        if (!is_string_delimiter(parser.get_char_at())) {
+            return finish(std::move(frame.obj));
+        }
+        parser.log("Found a comma and string delimiter after object closing brace, checking for additional key-value pairs");
+        if (!can_nest()) {
+            parser.log("Reached the maximum nesting depth, not merging the additional key-value pairs");
+            return finish(std::move(frame.obj));
+        }
+        frame.merging = true;
+        push_object();
+    }
+
+    void end_element(Value value) {
+        Frame& frame = stack.back();
+        if (parser.projection) {
+            parser.path.pop_back();
+        }
+        parser.schema_node = frame.node;
+
+        if (parser.index == frame.value_index && parser.get_char_at()) {
+            parser.log("While parsing an array, the value did not consume anything, skipping a character");
+            parser.index += 1;
+        } else if (ObjectComparer::is_strictly_empty(value)) {
+            parser.index += 1;
+        } else if (value == "..." && parser.get_char_at(-1) == '.') {
+            parser.log("While parsing an array, found a stray '...'; ignoring it");
+        } else {
+            frame.arr.push_back(std::move(value));
+            parser.count_node();
+        }
+
+        frame.current_char = parser.get_char_at();
+        while (frame.current_char && frame.current_char != ']' &&
+               (std::isspace(frame.current_char) || frame.current_char == ',')) {
+            parser.index += 1;
+            frame.current_char = parser.get_char_at();
+        }
+    }
+
+    // parse_array from the top of its loop, until it needs a value or returns
+    void step_array() {
+        Frame& frame = stack.back();
+        while (frame.current_char && frame.current_char != ']' && frame.current_char != '}') {
+            if (parser.index >= members_end && at_members()) {
+                return end_members(false);
+            }
+            parser.skip_whitespaces();
+            if (parser.projection) {
+                parser.path.push_back(std::to_string(frame.arr.size() + frame.projected_count));
+                if (!parser.projection->keep(parser.path)) {
+                    parser.path.pop_back();
+                    char next_char = parser.get_char_at();
+                    if (next_char && next_char != ']' && next_char != '}') {
+                        parser.index += parser.skip_value();
+                        frame.projected_count += 1;
+                    }
+                    frame.current_char = parser.get_char_at();
+                    while (frame.current_char && frame.current_char != ']' &&
+                           (std::isspace(frame.current_char) || frame.current_char == ',')) {
+                        parser.index += 1;
+                        frame.current_char = parser.get_char_at();
+                    }
+                    continue;
+                }
+            }
+            if (parser.schema) {
+                parser.schema_node = parser.schema->items(frame.node);
+            }
+            frame.value_index = parser.index;
+            if (!is_string_delimiter(frame.current_char)) {
+                return begin_value();
+            }
+            size_t i = parser.skip_to_character(frame.current_char, 1);
+            i = parser.scroll_whitespaces(i + 1);
+            if (parser.get_char_at(i) == ':' && can_nest()) {
+                return push_object();
+            } else if (parser.schema_node != CompiledSchema::ANY) {
+                return begin_typed();
+            }
+            end_element(parse_string< Value >(parser));
+        }
+
+        if (at_members()) {
+            return end_members(true);
+        }
+        if (frame.current_char != ']') {
+            parser.log("While parsing an array we missed the closing ], ignoring it");
+        }
+
+        parser.index += 1;
+        parser.context.reset();
+        finish(std::move(frame.arr));
+    }
+
+    JSONParser& parser;
+    std::vector< Frame, typename Value::template AllocatorType< Frame > > stack;
+    // OBJECT and ARRAY frames on the stack
+    size_t depth;
+    Value result;
+    bool has_result;
+    // Running parse_members, which stops between two members of its container from members_end
+    bool members;
+    size_t members_end;
+    bool members_done;
+    bool members_closed;
+};
+
+} // namespace
+
+template < typename Value > Value parse_iterative(JSONParser& parser) {
+    JSON_REPAIR_TRACE("parse_iterative", &parser.index);
+    return IterativeParser< Value >(parser).run();
+}
+
+template JSONReturnType parse_iterative< JSONReturnType >(JSONParser& parser);
+template PmrJSONReturnType parse_iterative< PmrJSONReturnType >(JSONParser& parser);
+
+template < typename Value > ParsedMembers< Value > parse_members(JSONParser& parser, char opener, size_t stop) {
+    JSON_REPAIR_TRACE("parse_members", &parser.index);
+    return IterativeParser< Value >(parser).run_members(opener, stop);
+}
+
+template ParsedMembers< JSONReturnType > parse_members< JSONReturnType >(JSONParser& parser, char opener, size_t stop);
@@ -0,0 +1,54 @@
+#ifndef PARSE_ITERATIVE_HPP
+#define PARSE_ITERATIVE_HPP
+
+#include "json_parser.hpp"
+
+// Locals of a suspended parse_object, parse_array or parse_typed call
+template < typename Value > struct ParseFrame {
+    enum Kind { OBJECT, ARRAY, TYPED };
+
+    explicit ParseFrame(std::pmr::memory_resource* resource)
+        : obj(Value::make_map(resource)), key(Value::make_string("", resource)), arr(Value::make_vector(resource)) {}
+
+    Kind kind;
+    // Index after the opening bracket, or where parse_typed started
+    size_t start_index = 0;
+    // Schema node of the container
+    size_t node = CompiledSchema::ANY;
+
+    typename Value::MapType obj;
+    typename Value::StringType key;
+    bool projected_out = false;
+    // Waiting for the object parsed from the pairs after the closing brace
+    bool merging = false;
+
+    typename Value::VectorType arr;
+    char current_char = '\0';
+    size_t value_index = 0;
+    size_t projected_count = 0;
+
+    unsigned types = 0;
+
+    JSON_REPAIR_TRACE_MARK(trace);
+};
+
+// Same result as parse_json, but parse_object, parse_array, the containers of parse_typed, the
+// trailing pairs merge and top-level comments are suspended on an explicit stack instead of the
+// call stack. Containers nested deeper than parser.max_depth are kept as their source text.
+template < typename Value > Value parse_iterative(JSONParser& parser);
+
+// Members parsed by parse_members
+template < typename Value > struct ParsedMembers {
+    // A VectorType or a MapType, as the container builds it
+    Value members;
+    // The container ended, parser.index is at its closing bracket or at the end of the input
+    bool closed;
+};
+
+// Members of the array or object opened by opener, parsed as parse_iterative parses them in place
+// from the member start at parser.index, or from the first member when it is right after the
+// bracket of an object. Stops between two members once parser.index reaches stop, and before the
+// closing bracket, which is left to the caller. The packed scan of a new array is not done.
+template < typename Value > ParsedMembers< Value > parse_members(JSONParser& parser, char opener, size_t stop);
+
+#endif
@@ -1,9 +1,60 @@
 #include "parse_number.hpp"
 #include "constants.hpp"
+#include "parse_string.hpp"
 #include <cctype>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
 #include <sstream>
 
-JSONReturnType parse_number(JSONParser& parser) {
+namespace {
+
+// Length of the number at the start of text if it is -?[0-9]+(\.[0-9]+)?([eE]-?[0-9]+)? and is
+// followed by a separator, 0 otherwise. '+' is not a number character for parse_number.
+size_t plain_number_length(std::string_view text, bool& integer) {
+    size_t i = 0;
+    auto digits = [&text, &i]() {
+        size_t start = i;
+        while (i < text.size() && std::isdigit(static_cast< unsigned char >(text[i]))) {
+            i += 1;
+        }
+        return i > start;
+    };
+    if (i < text.size() && text[i] == '-') {
+        i += 1;
+    }
+    if (!digits()) {
+        return 0;
+    }
+    integer = true;
+    if (i < text.size() && text[i] == '.') {
+        i += 1;
+        if (!digits()) {
+            return 0;
+        }
+        integer = false;
+    }
+    if (i < text.size() && (text[i] == 'e' || text[i] == 'E')) {
+        i += 1;
+        if (i < text.size() && text[i] == '-') {
+            i += 1;
+        }
+        if (!digits()) {
+            return 0;
+        }
+        integer = false;
+    }
+    if (i == text.size() || !(std::isspace(text[i]) || text[i] == ',' || text[i] == ']')) {
+        return 0;
+    }
+    return i;
+}
+
+}  // namespace
+
+template < typename Value > Value parse_number(JSONParser& parser) {
+    JSON_REPAIR_TRACE("parse_number", &parser.index);
     std::string number_str = "";
     char current_char = parser.get_char_at();
     bool is_array = (parser.context.getCurrent() == ContextValues::ARRAY);
@@ -24,28 +75,96 @@ JSONReturnType parse_number(JSONParser& parser) {
         parser.index -= 1;
     } else if (current_char && std::isalpha(current_char)) {
         parser.index -= number_str.length();
-        return parser.parse_string();
+        return parse_string< Value >(parser);
     }
     
     if (number_str.find(',') != std::string::npos) {
-        return number_str;
+        return Value::make_string(number_str, parser.resource);
     }
     
     if (number_str.find('.') != std::string::npos || 
         number_str.find('e') != std::string::npos || 
         number_str.find('E') != std::string::npos) {
-        try {
-            double value = std::stod(number_str);
-            return value;
-        } catch (const std::exception&) {
-            return number_str;
+        // std::stod without the exception and its heap-allocated message: a valid prefix is
+        // enough, no conversion or a value out of range keeps the text
+        errno = 0;
+        char* end = nullptr;
+        double value = std::strtod(number_str.c_str(), &end);
+        if (end == number_str.c_str() || errno == ERANGE) {
+            return Value::make_string(number_str, parser.resource);
         }
+        return value;
     } else {
-        try {
-            int value = std::stoi(number_str);
-            return value;
-        } catch (const std::exception&) {
-            return number_str;
+        // Same for std::stoi
+        errno = 0;
+        char* end = nullptr;
+        long value = std::strtol(number_str.c_str(), &end, 10);
+        if (end == number_str.c_str() || errno == ERANGE || value < std::numeric_limits< int >::min() ||
+            value > std::numeric_limits< int >::max()) {
+            return Value::make_string(number_str, parser.resource);
         }
+        return static_cast< int >(value);
     }
-}
\ No newline at end of file
+}
+
+template JSONReturnType parse_number< JSONReturnType >(JSONParser& parser);
+template PmrJSONReturnType parse_number< PmrJSONReturnType >(JSONParser& parser);
+
+template < typename Packed > bool scan_packed_numbers(JSONParser& parser, Packed& packed) {
+    std::string_view text = parser.get_view();
+    if (text.empty() || parser.projection || parser.schema || parser.has_limits()) {
+        return false;
+    }
+    size_t start_index = parser.index;
+    size_t i = parser.index;
+    bool closed = false;
+    while (true) {
+        while (i < text.size() && std::isspace(text[i])) {
+            i += 1;
+        }
+        if (i < text.size() && text[i] == ']') {
+            closed = !packed.empty();
+            break;
+        }
+        bool integer = false;
+        size_t length = plain_number_length(text.substr(i), integer);
+        if (i + length >= text.size()) {
+            parser.reached_end = true;
+        }
+        char buffer[64];
+        if (length == 0 || length >= sizeof(buffer)) {
+            break;
+        }
+        std::memcpy(buffer, text.data() + i, length);
+        buffer[length] = '\0';
+        // Same conversions as parse_number, which keeps the text when they fail
+        errno = 0;
+        double value = 0;
+        if (integer) {
+            long integer_value = std::strtol(buffer, nullptr, 10);
+            if (errno == ERANGE || integer_value < std::numeric_limits< int >::min() ||
+                integer_value > std::numeric_limits< int >::max()) {
+                break;
+            }
+            value = static_cast< int >(integer_value);
+        } else {
+            value = std::strtod(buffer, nullptr);
+            if (errno == ERANGE) {
+                break;
+            }
+        }
+        packed.push_back(value);
+        parser.count_node();
+
+        i += length;
+        while (i < text.size() && text[i] != ']' && (std::isspace(text[i]) || text[i] == ',')) {
+            i += 1;
+        }
+        parser.index = i;
+    }
+    parser.bytes_examined += parser.index - start_index;
+    return closed;
+}
+
+template bool scan_packed_numbers(JSONParser& parser, JSONReturnType::PackedType& packed);
+template bool scan_packed_numbers(JSONParser& parser, PmrJSONReturnType::PackedType& packed);
\ No newline at end of file
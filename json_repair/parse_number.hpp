@@ -3,6 +3,13 @@
 
 #include "json_parser.hpp"
 
-JSONReturnType parse_number(JSONParser& parser);
+template < typename Value > Value parse_number(JSONParser& parser);
 
-#endif
\ No newline at end of file
+// Fast path of parse_array for arrays of plain numbers. Reads the numbers separated by commas and
+// whitespace from the current index into packed, as parse_number would return them, and returns
+// true when it stops at the closing ]. Otherwise the index is left after the last number read and
+// the element loop goes on from there. Only runs on input held in memory, without a projection,
+// a schema or limits.
+template < typename Packed > bool scan_packed_numbers(JSONParser& parser, Packed& packed);
+
+#endif
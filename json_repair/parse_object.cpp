@@ -1,11 +1,16 @@
 #include "parse_object.hpp"
 #include "constants.hpp"
 #include "object_comparer.hpp"
+#include "parse_array.hpp"
+#include "parse_string.hpp"
 #include <cctype>
 
-JSONReturnType parse_object(JSONParser& parser) {
-    std::map<std::string, JSONReturnType> obj;
+template < typename Value > Value parse_object(JSONParser& parser) {
+    JSON_REPAIR_TRACE("parse_object", &parser.index);
+    typename Value::MapType obj = Value::make_map(parser.resource);
     size_t start_index = parser.index;
+    bool projected_out = false;
+    size_t object_node = parser.schema_node;
     
     while (parser.get_char_at() != '}' && parser.get_char_at() != '\0') {
         parser.skip_whitespaces();
@@ -19,14 +24,16 @@ JSONReturnType parse_object(JSONParser& parser) {
 
         size_t rollback_index = parser.index;
 
-        std::string key = "";
+        typename Value::StringType key = Value::make_string("", parser.resource);
         while (parser.get_char_at() != '\0') {
             rollback_index = parser.index;
             if (parser.get_char_at() == '[' && key.empty()) {
                 // Complex array merging logic skipped for brevity
             }
             
-            key = parser.parse_string();
+            if (!parser.recall_key(key)) {
+                key = parse_string< Value >(parser);
+            }
             if (key.empty()) {
                 parser.skip_whitespaces();
             }
@@ -35,9 +42,10 @@ JSONReturnType parse_object(JSONParser& parser) {
             }
         }
         
-        auto context_it = std::find(parser.context.getContext().begin(), parser.context.getContext().end(), ContextValues::ARRAY);
-        if (context_it != parser.context.getContext().end() && obj.find(key) != obj.end()) {
+        if (parser.context.contains(ContextValues::ARRAY) && obj.find(key) != obj.end() &&
+            parser.charge_backtrack(parser.index - rollback_index + 1)) {
             parser.log("While parsing an object we found a duplicate key, closing the object here and rolling back the index");
+            parser.remember_key(rollback_index, key);
             parser.index = rollback_index - 1;
             break;
         }
@@ -59,15 +67,40 @@ JSONReturnType parse_object(JSONParser& parser) {
         parser.context.set(ContextValues::OBJECT_VALUE);
         parser.skip_whitespaces();
         
-        JSONReturnType value = std::string("");
+        if (parser.projection) {
+            parser.path.emplace_back(key);
+            if (!parser.projection->keep(parser.path)) {
+                if (parser.get_char_at() != ',' && parser.get_char_at() != '}') {
+                    parser.index += parser.skip_value();
+                }
+                parser.path.pop_back();
+                parser.context.reset();
+                projected_out = true;
+                if (parser.get_char_at() == ',') {
+                    parser.index += 1;
+                }
+                parser.skip_whitespaces();
+                continue;
+            }
+        }
+
+        if (parser.schema) {
+            parser.schema_node = parser.schema->property(object_node, key);
+        }
+        Value value = Value::make_string("", parser.resource);
         if (parser.get_char_at() == ',' || parser.get_char_at() == '}') {
             parser.log("While parsing an object value we found a stray , ignoring it");
         } else {
-            value = parser.parse_json();
+            value = parse_json< Value >(parser);
         }
+        parser.schema_node = object_node;
 
+        if (parser.projection) {
+            parser.path.pop_back();
+        }
         parser.context.reset();
-        obj[key] = value;
+        obj.insert_or_assign(std::move(key), std::move(value));
+        parser.count_node();
 
         if (parser.get_char_at() == ',' || parser.get_char_at() == '\'' || parser.get_char_at() == '"') {
             parser.index += 1;
@@ -78,10 +111,11 @@ JSONReturnType parse_object(JSONParser& parser) {
 
     parser.index += 1;
 
-    if (obj.empty() && parser.index - start_index > 2) {
+    if (obj.empty() && !projected_out && parser.index - start_index > 2 &&
+        parser.charge_backtrack(parser.index - start_index)) {
         parser.log("Parsed object is empty, we will try to parse this as an array instead");
         parser.index = start_index;
-        return parser.parse_array();
+        return parse_array< Value >(parser);
     }
 
     if (!parser.context.isEmpty()) {
@@ -99,10 +133,11 @@ JSONReturnType parse_object(JSONParser& parser) {
     }
     parser.log("Found a comma and string delimiter after object closing brace, checking for additional key-value pairs");
     
-    auto additional_obj = parse_object(parser).get<JSONReturnType::MapType>();
-    for (const auto& [k, v] : additional_obj) {
-        obj[k] = v;
-    }
+    auto additional_obj = parse_object< Value >(parser);
+    merge_pairs(obj, additional_obj.template get< typename Value::MapType >());
 
     return obj;
-}
\ No newline at end of file
+}
+
+template JSONReturnType parse_object< JSONReturnType >(JSONParser& parser);
+template PmrJSONReturnType parse_object< PmrJSONReturnType >(JSONParser& parser);
\ No newline at end of file
@@ -3,6 +3,18 @@
 
 #include "json_parser.hpp"
 
-JSONReturnType parse_object(JSONParser& parser);
+// Instantiated for JSONReturnType and PmrJSONReturnType
+template < typename Value > Value parse_object(JSONParser& parser);
 
-#endif
\ No newline at end of file
+// Moves the nodes of from into obj without reallocating them, the value in from wins on a
+// duplicate key. Both maps are built by the same parser so their allocators compare equal.
+template < typename Map > void merge_pairs(Map& obj, Map& from) {
+    while (!from.empty()) {
+        auto result = obj.insert(from.extract(from.begin()));
+        if (!result.inserted) {
+            result.position->second = std::move(result.node.mapped());
+        }
+    }
+}
+
+#endif
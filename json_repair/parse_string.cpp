@@ -3,10 +3,65 @@
 #include "parse_comment.hpp"
 #include "constants.hpp"
 #include "json_context.hpp"
+#include "utf8.hpp"
 #include <cctype>
 #include <algorithm>
 
-std::string parse_string(JSONParser& parser) {
+namespace {
+
+// Value of the 4 hex digits from offset, or -1
+long hex4(JSONParser& parser, int offset) {
+    long value = 0;
+    for (int k = 0; k < 4; ++k) {
+        char c = parser.get_char_at(offset + k);
+        int digit = c >= '0' && c <= '9' ? c - '0'
+                    : c >= 'a' && c <= 'f' ? c - 'a' + 10
+                    : c >= 'A' && c <= 'F' ? c - 'A' + 10
+                                           : -1;
+        if (digit < 0) {
+            return -1;
+        }
+        value = value * 16 + digit;
+    }
+    return value;
+}
+
+// Decodes the \u escape whose u is at the current index, with the low half of a surrogate pair
+// when it follows. False leaves it as text: no 4 hex digits, or an unpaired surrogate kept by the
+// policy.
+bool decode_unicode_escape(JSONParser& parser, std::string& acc) {
+    long unit = hex4(parser, 1);
+    if (unit < 0) {
+        return false;
+    }
+    size_t length = 5;
+    long code_point = unit;
+    if (unit >= 0xD800 && unit <= 0xDFFF) {
+        long low = unit <= 0xDBFF && parser.get_char_at(5) == '\\' && parser.get_char_at(6) == 'u' ? hex4(parser, 7) : -1;
+        if (low >= 0xDC00 && low <= 0xDFFF) {
+            code_point = 0x10000 + ((unit - 0xD800) << 10) + (low - 0xDC00);
+            length = 11;
+        } else if (parser.utf8_policy == Utf8Policy::KEEP || parser.utf8_policy == Utf8Policy::ESCAPE) {
+            return false;
+        } else {
+            parser.log("Found an unpaired surrogate escape, repairing it");
+            code_point = -1;
+        }
+    }
+    acc.pop_back();
+    if (code_point >= 0) {
+        append_utf8(acc, static_cast< uint32_t >(code_point));
+    } else if (parser.utf8_policy == Utf8Policy::REPLACE) {
+        append_utf8(acc, 0xFFFD);
+    }
+    parser.index += length;
+    return true;
+}
+
+} // namespace
+
+void scan_string(JSONParser& parser) {
+    JSON_REPAIR_TRACE("parse_string", &parser.index);
     auto _append_literal_char = [&parser](std::string acc, char current_char) -> std::pair<std::string, char> {
         acc += current_char;
         parser.index += 1;
@@ -19,10 +74,12 @@ std::string parse_string(JSONParser& parser) {
     char lstring_delimiter = '"';
     char rstring_delimiter = '"';
 
+    parser.scratch.clear();
     char current_char = parser.get_char_at();
     if (current_char == '#' || current_char == '/') {
-        // return parser.parse_comment();
-        return "";
+        // Skipped here rather than by the caller, an object key loop would retry this index forever
+        skip_comment(parser);
+        return;
     }
     
     while (current_char && 
@@ -33,7 +90,7 @@ std::string parse_string(JSONParser& parser) {
     }
 
     if (!current_char) {
-        return "";
+        return;
     }
 
     if (current_char == '\'') {
@@ -48,19 +105,22 @@ std::string parse_string(JSONParser& parser) {
                 // Check if it's "true"
                 if (parser.get_char_at(1) == 'r' && parser.get_char_at(2) == 'u' && parser.get_char_at(3) == 'e') {
                     parser.index += 4;
-                    return "true";
+                    parser.scratch = "true";
+                    return;
                 }
             } else if (std::tolower(current_char) == 'f') {
                 // Check if it's "false"
                 if (parser.get_char_at(1) == 'a' && parser.get_char_at(2) == 'l' && parser.get_char_at(3) == 's' && parser.get_char_at(4) == 'e') {
                     parser.index += 5;
-                    return "false";
+                    parser.scratch = "false";
+                    return;
                 }
             } else if (std::tolower(current_char) == 'n') {
                 // Check if it's "null"
                 if (parser.get_char_at(1) == 'u' && parser.get_char_at(2) == 'l' && parser.get_char_at(3) == 'l') {
                     parser.index += 4;
-                    return "null";
+                    parser.scratch = "null";
+                    return;
                 }
             }
         }
@@ -82,10 +142,10 @@ std::string parse_string(JSONParser& parser) {
             (parser.context.getCurrent() == ContextValues::OBJECT_VALUE && 
              (parser.get_char_at(1) == ',' || parser.get_char_at(1) == '}'))) {
             parser.index += 1;
-            return "";
+            return;
         } else if (parser.get_char_at(1) == lstring_delimiter) {
             parser.log("While parsing a string, we found a doubled quote and then a quote again, ignoring it");
-            return "";
+            return;
         }
         size_t i = parser.skip_to_character(rstring_delimiter, 1);
         char next_c = parser.get_char_at(i);
@@ -100,7 +160,7 @@ std::string parse_string(JSONParser& parser) {
                 next_c == '{' || next_c == '[') {
                 parser.log("While parsing a string, we found a doubled quote but also another quote afterwards, ignoring it");
                 parser.index += 1;
-                return "";
+                return;
             } else if (!(next_c == ',' || next_c == '}' || next_c == ']')) {
                 parser.log("While parsing a string, we found a doubled quote but it was a mistake, removing one quote");
                 parser.index += 1;
@@ -108,7 +168,7 @@ std::string parse_string(JSONParser& parser) {
         }
     }
 
-    std::string string_acc = "";
+    std::string& string_acc = parser.scratch;
 
     current_char = parser.get_char_at();
     bool unmatched_delimiter = false;
@@ -134,6 +194,13 @@ std::string parse_string(JSONParser& parser) {
             string_acc.pop_back();
         }
         
+        if (current_char == 'u' && !string_acc.empty() && string_acc.back() == '\\' &&
+            decode_unicode_escape(parser, string_acc)) {
+            parser.log("Found a unicode escape sequence, normalizing it");
+            current_char = parser.get_char_at();
+            continue;
+        }
+
         if (current_char && !string_acc.empty() && string_acc.back() == '\\') {
             parser.log("Found a stray escape sequence, normalizing it");
             if (current_char == rstring_delimiter || current_char == 't' || 
@@ -163,31 +230,12 @@ std::string parse_string(JSONParser& parser) {
             }
         }
         
-        if (current_char == rstring_delimiter && !string_acc.empty() && string_acc.back() != '\\') {
-            if (doubled_quotes && parser.get_char_at(1) == rstring_delimiter) {
-                parser.log("While parsing a string, we found a doubled quote, ignoring it");
-                parser.index += 1;
-            } else {
-                // Check if eventually there is a rstring delimiter, otherwise we bail
-                size_t i = 1;
-                char next_c = parser.get_char_at(i);
-                bool check_comma_in_object_value = true;
-                while (next_c && next_c != rstring_delimiter && next_c != lstring_delimiter) {
-                    if (check_comma_in_object_value && std::isalpha(next_c)) {
-                        check_comma_in_object_value = false;
-                    }
-                    if ((std::find(parser.context.getContext().begin(), parser.context.getContext().end(), ContextValues::OBJECT_KEY) != parser.context.getContext().end() && (next_c == ':' || next_c == '}')) ||
-                        (std::find(parser.context.getContext().begin(), parser.context.getContext().end(), ContextValues::OBJECT_VALUE) != parser.context.getContext().end() && next_c == '}') ||
-                        (std::find(parser.context.getContext().begin(), parser.context.getContext().end(), ContextValues::ARRAY) != parser.context.getContext().end() && (next_c == ']' || next_c == ',')) ||
-                        (check_comma_in_object_value && 
-                         parser.context.getCurrent() == ContextValues::OBJECT_VALUE && 
-                         next_c == ',')) {
-                        break;
-                    }
-                    i += 1;
-                    next_c = parser.get_char_at(i);
-                }
-            }
+        // The quote always closes the string. The python version scans ahead for a later delimiter
+        // here, the result was never used in this port and the scan made long inputs quadratic
+        if (current_char == rstring_delimiter && !string_acc.empty() && string_acc.back() != '\\' &&
+            doubled_quotes && parser.get_char_at(1) == rstring_delimiter) {
+            parser.log("While parsing a string, we found a doubled quote, ignoring it");
+            parser.index += 1;
         }
     }
     
@@ -195,7 +243,8 @@ std::string parse_string(JSONParser& parser) {
         parser.log("While parsing a string, handling an extreme corner case in which the LLM added a comment instead of valid string, invalidate the string and return an empty value");
         parser.skip_whitespaces();
         if (parser.get_char_at() != ':' && parser.get_char_at() != ',') {
-            return "";
+            string_acc.clear();
+            return;
         }
     }
 
@@ -216,5 +265,7 @@ std::string parse_string(JSONParser& parser) {
         }
     }
 
-    return string_acc;
+    if (parser.utf8_policy != Utf8Policy::KEEP && repair_utf8(string_acc, parser.utf8_policy) > 0) {
+        parser.log("While parsing a string, we found invalid UTF-8, repairing it");
+    }
 }
\ No newline at end of file
@@ -3,6 +3,12 @@
 
 #include "json_parser.hpp"
 
-std::string parse_string(JSONParser& parser);
+// Repairs the string at the current index into parser.scratch
+void scan_string(JSONParser& parser);
 
-#endif
\ No newline at end of file
+template < typename Value > typename Value::StringType parse_string(JSONParser& parser) {
+    scan_string(parser);
+    return Value::make_string(parser.scratch, parser.resource);
+}
+
+#endif
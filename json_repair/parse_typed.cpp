@@ -0,0 +1,148 @@
+#include "parse_typed.hpp"
+#include "constants.hpp"
+#include "parse_array.hpp"
+#include "parse_number.hpp"
+#include "parse_object.hpp"
+#include "parse_string.hpp"
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cstdlib>
+
+namespace {
+
+std::string lowercase(std::string text) {
+    std::transform(text.begin(), text.end(), text.begin(), [](unsigned char c) { return std::tolower(c); });
+    return text;
+}
+
+std::string_view trim(std::string_view text) {
+    size_t start = 0;
+    size_t end = text.size();
+    while (start < end && std::isspace(static_cast<unsigned char>(text[start]))) {
+        start += 1;
+    }
+    while (end > start && std::isspace(static_cast<unsigned char>(text[end - 1]))) {
+        end -= 1;
+    }
+    return text.substr(start, end - start);
+}
+
+// Unquoted value, read up to the structural character that closes it in the current context
+std::string parse_literal(JSONParser& parser) {
+    bool in_array = parser.context.getCurrent() == ContextValues::ARRAY;
+    std::string literal;
+    char current_char = parser.get_char_at();
+    while (current_char && current_char != ',' && current_char != '\n' &&
+           current_char != (in_array ? ']' : '}')) {
+        literal += current_char;
+        parser.index += 1;
+        current_char = parser.get_char_at();
+    }
+    return std::string(trim(literal));
+}
+
+template < typename Value > Value coerce_literal(JSONParser& parser, std::string_view literal, unsigned types) {
+    std::string lowered = lowercase(std::string(literal));
+    if ((types & CompiledSchema::BOOLEAN) && (lowered == "true" || lowered == "false")) {
+        return typename Value::Data(std::in_place_type<typename Value::BoolType>, lowered == "true");
+    }
+    // Arrays drop null elements as empty values, so null is only produced for object members
+    if ((types & CompiledSchema::NULL_VALUE) && (lowered == "null" || lowered == "none") &&
+        parser.context.getCurrent() != ContextValues::ARRAY) {
+        return Value();
+    }
+    if (!literal.empty() && (types & (CompiledSchema::INTEGER | CompiledSchema::NUMBER))) {
+        std::string text(literal);
+        const char* text_end = text.c_str() + text.size();
+        char* end = nullptr;
+        errno = 0;
+        if (text.find_first_of(".eE") == std::string::npos) {
+            long long value = std::strtoll(text.c_str(), &end, 10);
+            if (end == text_end) {
+                // Numbers are doubles as parse_number reads them, so digits past the range of
+                // long long are read as one too
+                return errno == ERANGE ? std::strtod(text.c_str(), nullptr) : static_cast< double >(value);
+            }
+        } else if (types & CompiledSchema::NUMBER) {
+            double value = std::strtod(text.c_str(), &end);
+            if (end == text_end && errno != ERANGE) {
+                return value;
+            }
+        }
+    }
+    return Value::make_string(literal, parser.resource);
+}
+
+}  // namespace
+
+template < typename Value > Value coerce_typed(JSONParser& parser, Value value, unsigned types, size_t start_index) {
+    if (value.template is<typename Value::StringType>()) {
+        if (types & CompiledSchema::STRING) {
+            return value;
+        }
+        return coerce_literal< Value >(parser, trim(value.template get<typename Value::StringType>()), types);
+    }
+    if (value.template is<typename Value::DoubleType>()) {
+        if (types & (CompiledSchema::NUMBER | CompiledSchema::INTEGER)) {
+            return value;
+        }
+        if (types & CompiledSchema::STRING) {
+            return Value::make_string(trim(parser.get_range(start_index, parser.index)), parser.resource);
+        }
+        if (types & CompiledSchema::BOOLEAN) {
+            return typename Value::Data(std::in_place_type<typename Value::BoolType>,
+                                        value.template get<typename Value::DoubleType>() != 0);
+        }
+        return value;
+    }
+    bool container_allowed = value.template is<typename Value::MapType>() ? (types & CompiledSchema::OBJECT)
+                                                                           : (types & CompiledSchema::ARRAY);
+    if (!container_allowed && (types & CompiledSchema::STRING) &&
+        (value.template is<typename Value::MapType>() || value.template is<typename Value::VectorType>())) {
+        parser.log("While parsing a value, the schema expects a string, dumping the container");
+        return Value::make_string(value.dump(), parser.resource);
+    }
+    return value;
+}
+
+template < typename Value > Value parse_typed(JSONParser& parser) {
+    JSON_REPAIR_TRACE("parse_typed", &parser.index);
+    unsigned types = parser.schema->node(parser.schema_node).types;
+    char current_char = parser.get_char_at();
+    size_t start_index = parser.index;
+
+    if (current_char == '{') {
+        parser.index += 1;
+        return coerce_typed< Value >(parser, parse_object< Value >(parser), types, start_index);
+    } else if (current_char == '[') {
+        parser.index += 1;
+        return coerce_typed< Value >(parser, parse_array< Value >(parser), types, start_index);
+    }
+
+    bool quoted = std::find(STRING_DELIMITERS.begin(), STRING_DELIMITERS.end(), std::string(1, current_char)) != STRING_DELIMITERS.end();
+    unsigned scalar_types = types & ~CompiledSchema::NULL_VALUE;
+    if (!quoted && (scalar_types == CompiledSchema::STRING || scalar_types == CompiledSchema::BOOLEAN)) {
+        // The type is known, so there is no need to probe for numbers or literals
+        std::string literal = parse_literal(parser);
+        if (scalar_types == CompiledSchema::STRING) {
+            return coerce_literal< Value >(parser, literal, types & CompiledSchema::NULL_VALUE);
+        }
+        return coerce_literal< Value >(parser, literal, types);
+    }
+
+    Value value;
+    if (quoted || std::isalpha(static_cast< unsigned char >(current_char))) {
+        value = parse_string< Value >(parser);
+    } else {
+        value = parse_number< Value >(parser);
+    }
+    return coerce_typed< Value >(parser, std::move(value), types, start_index);
+}
+
+template JSONReturnType parse_typed< JSONReturnType >(JSONParser& parser);
+template PmrJSONReturnType parse_typed< PmrJSONReturnType >(JSONParser& parser);
+template JSONReturnType coerce_typed< JSONReturnType >(JSONParser& parser, JSONReturnType value, unsigned types,
+                                                       size_t start_index);
+template PmrJSONReturnType coerce_typed< PmrJSONReturnType >(JSONParser& parser, PmrJSONReturnType value,
+                                                             unsigned types, size_t start_index);
@@ -0,0 +1,11 @@
+#ifndef PARSE_TYPED_HPP
+#define PARSE_TYPED_HPP
+
+#include "json_parser.hpp"
+
+// Parses the value at the current index as the type the schema expects there
+template < typename Value > Value parse_typed(JSONParser& parser);
+// Converts a value parsed from start_index to one of the schema types when it can
+template < typename Value > Value coerce_typed(JSONParser& parser, Value value, unsigned types, size_t start_index);
+
+#endif
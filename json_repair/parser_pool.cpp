@@ -0,0 +1,53 @@
+#include "parser_pool.hpp"
+
+ParserPool::Lease& ParserPool::Lease::operator=(Lease&& other) {
+    if (this != &other) {
+        if (parser) {
+            ParserPool::release(std::move(parser));
+        }
+        parser = std::move(other.parser);
+    }
+    return *this;
+}
+
+ParserPool::Lease::~Lease() {
+    if (parser) {
+        ParserPool::release(std::move(parser));
+    }
+}
+
+std::vector< std::unique_ptr< JSONParser > >& ParserPool::idle() {
+    thread_local std::vector< std::unique_ptr< JSONParser > > parsers;
+    return parsers;
+}
+
+ParserPool::Lease ParserPool::acquire(std::string_view input, bool logging) {
+    auto& parsers = idle();
+    if (parsers.empty()) {
+        return Lease(std::make_unique< JSONParser >(std::string(input), logging));
+    }
+    std::unique_ptr< JSONParser > parser = std::move(parsers.back());
+    parsers.pop_back();
+    parser->logging = logging;
+    parser->reset(input);
+    return Lease(std::move(parser));
+}
+
+void ParserPool::release(std::unique_ptr< JSONParser > parser) {
+    auto& parsers = idle();
+    if (parsers.size() >= MAX_IDLE) {
+        return;
+    }
+    // Back to the defaults of a new parser, the buffers are kept
+    parser->stream_stable = false;
+    parser->projection = nullptr;
+    parser->schema = nullptr;
+    parser->iterative = true;
+    parser->utf8_policy = Utf8Policy::KEEP;
+    parser->max_depth = JSONParser::DEFAULT_MAX_DEPTH;
+    parser->limits = ParseLimits();
+    parser->resource = std::pmr::get_default_resource();
+    parser->cache = nullptr;
+    parser->reset("");
+    parsers.push_back(std::move(parser));
+}
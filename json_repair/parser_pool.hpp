@@ -0,0 +1,47 @@
+#ifndef PARSER_POOL_HPP
+#define PARSER_POOL_HPP
+
+#include "json_parser.hpp"
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Per-thread free list of parsers. A parser returned to the pool keeps the capacity of its
+// buffers, so repairing many small documents on one thread stops allocating anything but the
+// repaired values.
+class ParserPool {
+public:
+    // Returns the parser to the pool of the thread that destroys or reassigns it, which is not
+    // necessarily the thread that acquired it
+    class Lease {
+    public:
+        Lease(Lease&& other) = default;
+        // Releases the parser held before taking the other one
+        Lease& operator=(Lease&& other);
+        ~Lease();
+
+        JSONParser& operator*() const { return *parser; }
+        JSONParser* operator->() const { return parser.get(); }
+
+    private:
+        friend class ParserPool;
+        explicit Lease(std::unique_ptr< JSONParser > parser) : parser(std::move(parser)) {}
+
+        std::unique_ptr< JSONParser > parser;
+    };
+
+    // A parser reset on input with the default options
+    static Lease acquire(std::string_view input, bool logging = false);
+
+    // Idle parsers kept per thread, the others are freed
+    static constexpr size_t MAX_IDLE = 4;
+
+private:
+    static std::vector< std::unique_ptr< JSONParser > >& idle();
+    static void release(std::unique_ptr< JSONParser > parser);
+};
+
+#endif
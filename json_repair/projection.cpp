@@ -0,0 +1,55 @@
+#include "projection.hpp"
+
+Projection::Projection(const std::vector< std::string >& pointers) : nodes(1) {
+    for (const auto& pointer : pointers) {
+        size_t node = 0;
+        size_t start = 0;
+        while (start < pointer.size()) {
+            size_t end = pointer.find('/', start + 1);
+            if (end == std::string::npos) {
+                end = pointer.size();
+            }
+            std::string token;
+            for (size_t i = start + 1; i < end; ++i) {
+                if (pointer[i] == '~' && i + 1 < end && (pointer[i + 1] == '0' || pointer[i + 1] == '1')) {
+                    token += pointer[i + 1] == '0' ? '~' : '/';
+                    i += 1;
+                } else {
+                    token += pointer[i];
+                }
+            }
+
+            auto it = nodes[node].children.find(token);
+            if (it == nodes[node].children.end()) {
+                nodes.emplace_back();
+                it = nodes[node].children.emplace(token, nodes.size() - 1).first;
+            }
+            node = it->second;
+            start = end;
+        }
+        nodes[node].terminal = true;
+    }
+}
+
+Projection::Projection(Predicate predicate) : predicate(std::move(predicate)) {}
+
+bool Projection::keep(const Path& path) const {
+    if (predicate) {
+        return predicate(path);
+    }
+    return keep_from(0, path, 0);
+}
+
+bool Projection::keep_from(size_t node, const Path& path, size_t depth) const {
+    // A path is kept when it leads to a selected value or lies inside one
+    if (nodes[node].terminal || depth == path.size()) {
+        return true;
+    }
+    const auto& children = nodes[node].children;
+    auto it = children.find(path[depth]);
+    if (it != children.end() && keep_from(it->second, path, depth + 1)) {
+        return true;
+    }
+    it = children.find("*");
+    return it != children.end() && keep_from(it->second, path, depth + 1);
+}
@@ -0,0 +1,35 @@
+#ifndef PROJECTION_HPP
+#define PROJECTION_HPP
+
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+// Selects the subtrees the parser materializes, everything else is skipped at scan speed.
+// Paths are the object keys and array indices (as strings) leading to a value.
+class Projection {
+public:
+    using Path = std::vector< std::string >;
+    using Predicate = std::function< bool(const Path&) >;
+
+    // RFC 6901 pointers such as "/tool_calls/0/name"; a "*" token matches any key or index
+    explicit Projection(const std::vector< std::string >& pointers);
+    // Called for every member and element, returning false skips that subtree
+    explicit Projection(Predicate predicate);
+
+    bool keep(const Path& path) const;
+
+private:
+    struct Node {
+        std::map< std::string, size_t > children;
+        bool terminal = false;
+    };
+
+    bool keep_from(size_t node, const Path& path, size_t depth) const;
+
+    std::vector< Node > nodes;
+    Predicate predicate;
+};
+
+#endif
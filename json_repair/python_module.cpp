@@ -0,0 +1,246 @@
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+
+#include "json_parser.hpp"
+#include "parser_pool.hpp"
+
+#include <exception>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// The json_repair_cpp extension module. Inputs are read in place from str (its UTF-8 form) or any
+// object exporting a buffer, parsed with the GIL released, and converted to Python objects
+// straight from the parsed values.
+
+namespace {
+
+// Bytes of a str or a buffer, valid until release(). A str is referenced until then, the GIL is
+// released while the bytes are parsed and another thread may drop it from its container.
+class Input {
+public:
+    bool acquire(PyObject* object) {
+        if (PyUnicode_Check(object)) {
+            Py_ssize_t size;
+            const char* data = PyUnicode_AsUTF8AndSize(object, &size);
+            if (!data) {
+                return false;
+            }
+            Py_INCREF(object);
+            str = object;
+            bytes = std::string_view(data, size);
+            return true;
+        }
+        if (PyObject_GetBuffer(object, &buffer, PyBUF_SIMPLE) < 0) {
+            PyErr_Format(PyExc_TypeError, "expected str or a bytes-like object, not %.100s",
+                         Py_TYPE(object)->tp_name);
+            return false;
+        }
+        has_buffer = true;
+        bytes = std::string_view(static_cast< const char* >(buffer.buf), buffer.len);
+        return true;
+    }
+
+    void release() {
+        Py_CLEAR(str);
+        if (has_buffer) {
+            PyBuffer_Release(&buffer);
+            has_buffer = false;
+        }
+    }
+
+    std::string_view bytes;
+
+private:
+    PyObject* str = nullptr;
+    Py_buffer buffer;
+    bool has_buffer = false;
+};
+
+// Result of one input, repaired without the GIL
+struct Repaired {
+    JSONReturnType value;
+    std::string text;
+    std::string error;
+};
+
+void repair(std::string_view input, bool stream_stable, bool dump, Repaired& result) {
+    try {
+        auto parser = ParserPool::acquire(input);
+        parser->stream_stable = stream_stable;
+        result.value = parser->parse();
+        if (dump) {
+            result.text = result.value.dump();
+        }
+    } catch (const std::exception& e) {
+        result.error = e.what();
+    }
+}
+
+PyObject* to_string(const JSONReturnType::StringType& str) {
+    // Strings are repaired byte by byte, broken UTF-8 is kept readable
+    return PyUnicode_DecodeUTF8(str.data(), str.size(), "replace");
+}
+
+PyObject* to_python(const JSONReturnType& value) {
+    if (value.is< JSONReturnType::MapType >()) {
+        PyObject* dict = PyDict_New();
+        if (!dict) {
+            return nullptr;
+        }
+        for (const auto& [key, item] : value.get< JSONReturnType::MapType >()) {
+            PyObject* py_key = to_string(key);
+            PyObject* py_item = py_key ? to_python(item) : nullptr;
+            int status = py_item ? PyDict_SetItem(dict, py_key, py_item) : -1;
+            Py_XDECREF(py_key);
+            Py_XDECREF(py_item);
+            if (status < 0) {
+                Py_DECREF(dict);
+                return nullptr;
+            }
+        }
+        return dict;
+    } else if (value.is< JSONReturnType::PackedType >()) {
+        auto packed = value.as_span< double >();
+        PyObject* list = PyList_New(packed.size());
+        for (size_t i = 0; list && i < packed.size(); ++i) {
+            PyObject* item = PyFloat_FromDouble(packed[i]);
+            if (!item) {
+                Py_CLEAR(list);
+                break;
+            }
+            PyList_SET_ITEM(list, i, item);
+        }
+        return list;
+    } else if (value.is< JSONReturnType::VectorType >()) {
+        const auto& vec = value.get< JSONReturnType::VectorType >();
+        PyObject* list = PyList_New(vec.size());
+        for (size_t i = 0; list && i < vec.size(); ++i) {
+            PyObject* item = to_python(vec[i]);
+            if (!item) {
+                Py_CLEAR(list);
+                break;
+            }
+            PyList_SET_ITEM(list, i, item);
+        }
+        return list;
+    } else if (value.is< JSONReturnType::StringType >()) {
+        return to_string(value.get< JSONReturnType::StringType >());
+    } else if (value.is< JSONReturnType::DoubleType >()) {
+        return PyFloat_FromDouble(value.get< JSONReturnType::DoubleType >());
+    } else if (value.is< JSONReturnType::IntType >()) {
+        return PyLong_FromLong(value.get< JSONReturnType::IntType >());
+    } else if (value.is< JSONReturnType::BoolType >()) {
+        return PyBool_FromLong(value.get< JSONReturnType::BoolType >());
+    }
+    Py_RETURN_NONE;
+}
+
+PyObject* to_result(const Repaired& repaired, bool dump) {
+    if (!repaired.error.empty()) {
+        PyErr_SetString(PyExc_ValueError, repaired.error.c_str());
+        return nullptr;
+    }
+    if (dump) {
+        return PyUnicode_DecodeUTF8(repaired.text.data(), repaired.text.size(), "replace");
+    }
+    return to_python(repaired.value);
+}
+
+PyObject* repair_one(PyObject* args, PyObject* kwargs, bool dump) {
+    static const char* keywords[] = {"data", "stream_stable", nullptr};
+    PyObject* data;
+    int stream_stable = 0;
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "O|p", const_cast< char** >(keywords), &data, &stream_stable)) {
+        return nullptr;
+    }
+    Input input;
+    if (!input.acquire(data)) {
+        return nullptr;
+    }
+    Repaired repaired;
+    Py_BEGIN_ALLOW_THREADS
+    repair(input.bytes, stream_stable, dump, repaired);
+    Py_END_ALLOW_THREADS
+    input.release();
+    return to_result(repaired, dump);
+}
+
+PyObject* loads(PyObject*, PyObject* args, PyObject* kwargs) {
+    return repair_one(args, kwargs, false);
+}
+
+PyObject* repair_json(PyObject*, PyObject* args, PyObject* kwargs) {
+    return repair_one(args, kwargs, true);
+}
+
+PyObject* repair_batch(PyObject*, PyObject* args, PyObject* kwargs) {
+    static const char* keywords[] = {"inputs", "return_objects", "stream_stable", nullptr};
+    PyObject* items;
+    int return_objects = 0;
+    int stream_stable = 0;
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "O|pp", const_cast< char** >(keywords), &items, &return_objects,
+                                     &stream_stable)) {
+        return nullptr;
+    }
+    PyObject* sequence = PySequence_Fast(items, "repair_batch expects a sequence of inputs");
+    if (!sequence) {
+        return nullptr;
+    }
+    Py_ssize_t count = PySequence_Fast_GET_SIZE(sequence);
+    std::vector< Input > inputs(count);
+    bool acquired = true;
+    for (Py_ssize_t i = 0; acquired && i < count; ++i) {
+        acquired = inputs[i].acquire(PySequence_Fast_GET_ITEM(sequence, i));
+    }
+    std::vector< Repaired > repaired(acquired ? count : 0);
+    bool dump = !return_objects;
+    if (acquired) {
+        // One release of the GIL for the whole batch
+        Py_BEGIN_ALLOW_THREADS
+        for (Py_ssize_t i = 0; i < count; ++i) {
+            repair(inputs[i].bytes, stream_stable, dump, repaired[i]);
+        }
+        Py_END_ALLOW_THREADS
+    }
+    for (auto& input : inputs) {
+        input.release();
+    }
+    Py_DECREF(sequence);
+    if (!acquired) {
+        return nullptr;
+    }
+    PyObject* list = PyList_New(count);
+    for (Py_ssize_t i = 0; list && i < count; ++i) {
+        PyObject* item = to_result(repaired[i], dump);
+        if (!item) {
+            Py_CLEAR(list);
+            break;
+        }
+        PyList_SET_ITEM(list, i, item);
+    }
+    return list;
+}
+
+PyMethodDef methods[] = {
+    {"loads", reinterpret_cast< PyCFunction >(reinterpret_cast< void (*)() >(loads)), METH_VARARGS | METH_KEYWORDS,
+     "loads(data, stream_stable=False)\n--\n\nRepairs data, a str or a bytes-like object, and returns the value."},
+    {"repair_json", reinterpret_cast< PyCFunction >(reinterpret_cast< void (*)() >(repair_json)),
+     METH_VARARGS | METH_KEYWORDS,
+     "repair_json(data, stream_stable=False)\n--\n\nRepairs data and returns the repaired JSON text."},
+    {"repair_batch", reinterpret_cast< PyCFunction >(reinterpret_cast< void (*)() >(repair_batch)),
+     METH_VARARGS | METH_KEYWORDS,
+     "repair_batch(inputs, return_objects=False, stream_stable=False)\n--\n\n"
+     "Repairs a sequence of inputs with the GIL released once, returning their JSON texts or values."},
+    {nullptr, nullptr, 0, nullptr},
+};
+
+PyModuleDef module = {
+    PyModuleDef_HEAD_INIT, "json_repair_cpp", "Repairs broken JSON with the json_repair C++ parser.", -1, methods,
+};
+
+} // namespace
+
+PyMODINIT_FUNC PyInit_json_repair_cpp() {
+    return PyModule_Create(&module);
+}
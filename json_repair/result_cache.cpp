@@ -0,0 +1,201 @@
+#include "result_cache.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+constexpr uint64_t PRIME1 = 0x9E3779B185EBCA87ULL;
+constexpr uint64_t PRIME2 = 0xC2B2AE3D27D4EB4FULL;
+
+uint64_t rotl(uint64_t value, int bits) {
+    return (value << bits) | (value >> (64 - bits));
+}
+
+uint64_t fmix(uint64_t value) {
+    value ^= value >> 33;
+    value *= 0xFF51AFD7ED558CCDULL;
+    value ^= value >> 33;
+    value *= 0xC4CEB9FE1A85EC53ULL;
+    value ^= value >> 33;
+    return value;
+}
+
+// Two 64-bit lanes over 16 bytes at a time
+ResultCache::Key hash128(std::string_view bytes, uint64_t seed) {
+    uint64_t a = seed ^ PRIME1;
+    uint64_t b = seed ^ PRIME2 ^ bytes.size();
+    auto mix = [&](const char* block) {
+        uint64_t w1, w2;
+        std::memcpy(&w1, block, 8);
+        std::memcpy(&w2, block + 8, 8);
+        a = rotl(a ^ (w1 * PRIME2), 31) * PRIME1;
+        b = rotl(b ^ (w2 * PRIME1), 27) * PRIME2;
+        a += b;
+    };
+    size_t i = 0;
+    for (; i + 16 <= bytes.size(); i += 16) {
+        mix(bytes.data() + i);
+    }
+    char tail[16] = {};
+    std::memcpy(tail, bytes.data() + i, bytes.size() - i);
+    mix(tail);
+    return ResultCache::Key{fmix(a + b), fmix(b ^ rotl(a, 17))};
+}
+
+// Estimated memory of a value, the nodes and the heap blocks of its strings and containers
+size_t footprint(const JSONReturnType& value) {
+    size_t bytes = sizeof(JSONReturnType);
+    auto string_bytes = [](const JSONReturnType::StringType& str) {
+        return str.capacity() > 15 ? str.capacity() + 1 : 0;
+    };
+    if (value.is< JSONReturnType::PackedType >()) {
+        bytes += value.get< JSONReturnType::PackedType >().capacity() * sizeof(double);
+    } else if (value.is< JSONReturnType::VectorType >()) {
+        const auto& vec = value.get< JSONReturnType::VectorType >();
+        bytes += (vec.capacity() - vec.size()) * sizeof(JSONReturnType);
+        for (const auto& item : vec) {
+            bytes += footprint(item);
+        }
+    } else if (value.is< JSONReturnType::MapType >()) {
+        for (const auto& [key, item] : value.get< JSONReturnType::MapType >()) {
+            // Tree node links and color
+            bytes += 4 * sizeof(void*) + sizeof(key) + string_bytes(key) + footprint(item);
+        }
+    } else if (value.is< JSONReturnType::StringType >()) {
+        bytes += string_bytes(value.get< JSONReturnType::StringType >());
+    }
+    return bytes;
+}
+
+} // namespace
+
+ResultCache::ResultCache(const CacheOptions& options)
+    : options(options), hits(0), misses(0), evictions(0), expirations(0) {
+    size_t count = std::max< size_t >(1, options.shards);
+    shard_bytes = options.max_bytes / count;
+    for (size_t i = 0; i < count; ++i) {
+        shards.push_back(std::make_unique< Shard >());
+    }
+}
+
+ResultCache::Key ResultCache::key(std::string_view input, bool stream_stable, size_t max_depth,
+                                  Utf8Policy utf8_policy, bool iterative) {
+    return hash128(input, (max_depth << 4) | (iterative ? 8 : 0) | (static_cast< uint64_t >(utf8_policy) << 1) |
+                              (stream_stable ? 1 : 0));
+}
+
+ResultCache::Entry* ResultCache::lookup(Shard& shard, const Key& key) {
+    auto found = shard.index.find(key);
+    if (found == shard.index.end()) {
+        return nullptr;
+    }
+    auto entry = found->second;
+    if (options.ttl != std::chrono::steady_clock::duration::zero() &&
+        entry->expires <= std::chrono::steady_clock::now()) {
+        shard.bytes -= entry->bytes;
+        shard.index.erase(found);
+        shard.entries.erase(entry);
+        expirations += 1;
+        return nullptr;
+    }
+    shard.entries.splice(shard.entries.begin(), shard.entries, entry);
+    return &*entry;
+}
+
+void ResultCache::evict(Shard& shard) {
+    // The newest entry stays even when it is larger than the shard
+    while (shard.bytes > shard_bytes && shard.entries.size() > 1) {
+        const Entry& oldest = shard.entries.back();
+        shard.bytes -= oldest.bytes;
+        shard.index.erase(oldest.key);
+        shard.entries.pop_back();
+        evictions += 1;
+    }
+}
+
+std::shared_ptr< const JSONReturnType > ResultCache::find(const Key& key) {
+    Shard& s = shard(key);
+    std::lock_guard< std::mutex > lock(s.mutex);
+    if (Entry* entry = lookup(s, key)) {
+        hits += 1;
+        return entry->value;
+    }
+    misses += 1;
+    return nullptr;
+}
+
+std::shared_ptr< const JSONReturnType > ResultCache::insert(const Key& key, JSONReturnType value) {
+    // Frozen, sized and allocated outside the lock
+    value.freeze();
+    size_t bytes = sizeof(Entry) + footprint(value);
+    auto shared = std::make_shared< const JSONReturnType >(std::move(value));
+    Shard& s = shard(key);
+    std::lock_guard< std::mutex > lock(s.mutex);
+    if (Entry* entry = lookup(s, key)) {
+        return entry->value;
+    }
+    s.entries.push_front(Entry{key, shared, nullptr, bytes, std::chrono::steady_clock::now() + options.ttl});
+    s.index[key] = s.entries.begin();
+    s.bytes += bytes;
+    evict(s);
+    return shared;
+}
+
+std::shared_ptr< const JSONReturnType > ResultCache::parse(const std::string& input, bool stream_stable) {
+    Key k = key(input, stream_stable, JSONParser::DEFAULT_MAX_DEPTH);
+    if (auto value = find(k)) {
+        return value;
+    }
+    JSONParser parser(input, false, 0, stream_stable);
+    return insert(k, parser.parse());
+}
+
+std::shared_ptr< const std::string > ResultCache::repair(const std::string& input, bool stream_stable) {
+    Key k = key(input, stream_stable, JSONParser::DEFAULT_MAX_DEPTH);
+    Shard& s = shard(k);
+    {
+        std::lock_guard< std::mutex > lock(s.mutex);
+        Entry* entry = lookup(s, k);
+        if (entry && entry->text) {
+            hits += 1;
+            return entry->text;
+        }
+    }
+    std::shared_ptr< const JSONReturnType > value = parse(input, stream_stable);
+    auto text = std::make_shared< const std::string >(value->dump());
+    std::lock_guard< std::mutex > lock(s.mutex);
+    Entry* entry = lookup(s, k);
+    if (!entry) {
+        return text;
+    }
+    if (!entry->text) {
+        entry->text = text;
+        entry->bytes += text->capacity();
+        s.bytes += text->capacity();
+        text = entry->text;
+        // The entry is at the front and stays
+        evict(s);
+        return text;
+    }
+    return entry->text;
+}
+
+CacheStats ResultCache::stats() const {
+    CacheStats result{hits, misses, evictions, expirations, 0, 0};
+    for (const auto& s : shards) {
+        std::lock_guard< std::mutex > lock(s->mutex);
+        result.entries += s->entries.size();
+        result.bytes += s->bytes;
+    }
+    return result;
+}
+
+void ResultCache::clear() {
+    for (auto& s : shards) {
+        std::lock_guard< std::mutex > lock(s->mutex);
+        s->entries.clear();
+        s->index.clear();
+        s->bytes = 0;
+    }
+}
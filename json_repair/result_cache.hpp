@@ -0,0 +1,103 @@
+#ifndef RESULT_CACHE_HPP
+#define RESULT_CACHE_HPP
+
+#include "json_parser.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+struct CacheOptions {
+    // Estimated size of the cached values and texts, split evenly between the shards
+    size_t max_bytes = 64 << 20;
+    // Entries older than this are parsed again, zero keeps them until they are evicted
+    std::chrono::steady_clock::duration ttl = std::chrono::steady_clock::duration::zero();
+    size_t shards = 16;
+};
+
+struct CacheStats {
+    size_t hits;
+    size_t misses;
+    size_t evictions;
+    size_t expirations;
+    size_t entries;
+    size_t bytes;
+};
+
+// Repaired values shared between threads, keyed by a 128-bit hash of the input and the options
+// that change the result. Every shard is an LRU list behind its own mutex. Values are frozen
+// before they are cached, so const access to them never writes and callers share them between
+// threads through the returned pointers.
+// A JSONParser with a cache set looks its input up there in parse(), unless it logs or has a
+// projection, a schema, limits or a file input.
+class ResultCache {
+public:
+    struct Key {
+        uint64_t low;
+        uint64_t high;
+
+        bool operator==(const Key& other) const { return low == other.low && high == other.high; }
+    };
+
+    explicit ResultCache(const CacheOptions& options = CacheOptions());
+
+    // The engines differ past max_depth, iterative is part of the key
+    static Key key(std::string_view input, bool stream_stable, size_t max_depth,
+                   Utf8Policy utf8_policy = Utf8Policy::KEEP, bool iterative = true);
+
+    std::shared_ptr< const JSONReturnType > find(const Key& key);
+    // Keeps the value already cached for key, if any, and returns the one cached
+    std::shared_ptr< const JSONReturnType > insert(const Key& key, JSONReturnType value);
+
+    // parse() of input with the default options, parsed and cached on a miss
+    std::shared_ptr< const JSONReturnType > parse(const std::string& input, bool stream_stable = false);
+    // dump() of the same value, kept with it
+    std::shared_ptr< const std::string > repair(const std::string& input, bool stream_stable = false);
+
+    CacheStats stats() const;
+    void clear();
+
+private:
+    struct Entry {
+        Key key;
+        std::shared_ptr< const JSONReturnType > value;
+        std::shared_ptr< const std::string > text;
+        size_t bytes;
+        std::chrono::steady_clock::time_point expires;
+    };
+
+    struct KeyHash {
+        size_t operator()(const Key& key) const { return static_cast< size_t >(key.low); }
+    };
+
+    struct Shard {
+        std::mutex mutex;
+        // Most recently used first
+        std::list< Entry > entries;
+        std::unordered_map< Key, std::list< Entry >::iterator, KeyHash > index;
+        size_t bytes = 0;
+    };
+
+    Shard& shard(const Key& key) { return *shards[key.high % shards.size()]; }
+    // The live entry for key moved to the front, nullptr when missing or expired
+    Entry* lookup(Shard& shard, const Key& key);
+    void evict(Shard& shard);
+
+    CacheOptions options;
+    size_t shard_bytes;
+    std::vector< std::unique_ptr< Shard > > shards;
+    std::atomic< size_t > hits;
+    std::atomic< size_t > misses;
+    std::atomic< size_t > evictions;
+    std::atomic< size_t > expirations;
+};
+
+#endif
@@ -0,0 +1,186 @@
+#include "schema.hpp"
+
+#include "json_parser.hpp"
+
+#include <algorithm>
+
+namespace {
+
+unsigned type_from_name(const std::string& name) {
+    if (name == "object") {
+        return CompiledSchema::OBJECT;
+    } else if (name == "array") {
+        return CompiledSchema::ARRAY;
+    } else if (name == "string") {
+        return CompiledSchema::STRING;
+    } else if (name == "number") {
+        return CompiledSchema::NUMBER | CompiledSchema::INTEGER;
+    } else if (name == "integer") {
+        return CompiledSchema::INTEGER;
+    } else if (name == "boolean") {
+        return CompiledSchema::BOOLEAN;
+    } else if (name == "null") {
+        return CompiledSchema::NULL_VALUE;
+    }
+    return CompiledSchema::ANY_TYPE;
+}
+
+const JSONReturnType* resolve_ref(const std::string& ref, const JSONReturnType& document) {
+    if (ref.empty() || ref[0] != '#') {
+        return nullptr;
+    }
+    const JSONReturnType* current = &document;
+    size_t start = 1;
+    while (start < ref.size()) {
+        size_t end = ref.find('/', start + 1);
+        if (end == std::string::npos) {
+            end = ref.size();
+        }
+        std::string token = ref.substr(start + 1, end - start - 1);
+        if (!current->is< JSONReturnType::MapType >()) {
+            return nullptr;
+        }
+        const auto& map = current->get< JSONReturnType::MapType >();
+        auto it = map.find(token);
+        if (it == map.end()) {
+            return nullptr;
+        }
+        current = &it->second;
+        start = end;
+    }
+    return current;
+}
+
+} // namespace
+
+std::shared_ptr< const CompiledSchema > CompiledSchema::compile(const JSONReturnType& schema) {
+    std::shared_ptr< CompiledSchema > compiled(new CompiledSchema());
+    compiled->nodes.emplace_back();
+    compiled->root_node = compiled->compile_node(schema, schema);
+    compiled->refs.clear();
+    return compiled;
+}
+
+std::shared_ptr< const CompiledSchema > CompiledSchema::compile(const std::string& schema_text) {
+    JSONParser parser(schema_text);
+    return compile(parser.parse());
+}
+
+size_t CompiledSchema::property(size_t index, std::string_view key) const {
+    const auto& properties = nodes[index].properties;
+    auto it = std::lower_bound(properties.begin(), properties.end(), key,
+                               [](const std::pair< std::string, size_t >& property,
+                                  std::string_view value) { return property.first < value; });
+    if (it != properties.end() && it->first == key) {
+        return it->second;
+    }
+    return nodes[index].additional_properties;
+}
+
+size_t CompiledSchema::compile_node(const JSONReturnType& schema, const JSONReturnType& document) {
+    if (!schema.is< JSONReturnType::MapType >()) {
+        return ANY;
+    }
+    const auto& map = schema.get< JSONReturnType::MapType >();
+
+    auto ref_it = map.find("$ref");
+    if (ref_it != map.end() && ref_it->second.is< JSONReturnType::StringType >()) {
+        const auto& ref = ref_it->second.get< JSONReturnType::StringType >();
+        auto known = refs.find(ref);
+        if (known != refs.end()) {
+            return known->second;
+        }
+        const JSONReturnType* target = resolve_ref(ref, document);
+        if (!target) {
+            return ANY;
+        }
+        // Registered before compiling so recursive definitions point back to this node
+        size_t index = nodes.size();
+        nodes.emplace_back();
+        refs[ref] = index;
+        size_t compiled = compile_node(*target, document);
+        merge_into(index, compiled);
+        return index;
+    }
+
+    size_t index = nodes.size();
+    nodes.emplace_back();
+    unsigned types = 0;
+
+    auto type_it = map.find("type");
+    if (type_it != map.end()) {
+        if (type_it->second.is< JSONReturnType::StringType >()) {
+            types |= type_from_name(type_it->second.get< JSONReturnType::StringType >());
+        } else if (type_it->second.is< JSONReturnType::VectorType >()) {
+            for (const auto& name : type_it->second.get< JSONReturnType::VectorType >()) {
+                if (name.is< JSONReturnType::StringType >()) {
+                    types |= type_from_name(name.get< JSONReturnType::StringType >());
+                }
+            }
+        }
+    }
+
+    auto properties_it = map.find("properties");
+    if (properties_it != map.end() && properties_it->second.is< JSONReturnType::MapType >()) {
+        if (type_it == map.end()) {
+            types |= OBJECT;
+        }
+        for (const auto& [key, value] : properties_it->second.get< JSONReturnType::MapType >()) {
+            size_t child = compile_node(value, document);
+            nodes[index].properties.emplace_back(key, child);
+        }
+    }
+
+    auto additional_it = map.find("additionalProperties");
+    if (additional_it != map.end()) {
+        nodes[index].additional_properties = compile_node(additional_it->second, document);
+    }
+
+    auto items_it = map.find("items");
+    if (items_it != map.end()) {
+        if (type_it == map.end()) {
+            types |= ARRAY;
+        }
+        nodes[index].items = compile_node(items_it->second, document);
+    }
+
+    for (const char* combinator : {"anyOf", "oneOf", "allOf"}) {
+        auto it = map.find(combinator);
+        if (it == map.end() || !it->second.is< JSONReturnType::VectorType >()) {
+            continue;
+        }
+        for (const auto& alternative : it->second.get< JSONReturnType::VectorType >()) {
+            size_t compiled = compile_node(alternative, document);
+            if (type_it == map.end()) {
+                types |= nodes[compiled].types;
+            }
+            merge_into(index, compiled);
+        }
+    }
+
+    nodes[index].types = types ? types : ANY_TYPE;
+    return index;
+}
+
+void CompiledSchema::merge_into(size_t target, size_t source) {
+    if (source == ANY) {
+        nodes[target].types = ANY_TYPE;
+        return;
+    }
+    Node merged = nodes[target];
+    const Node& from = nodes[source];
+    merged.types = (merged.types == ANY_TYPE ? 0 : merged.types) | from.types;
+    for (const auto& property : from.properties) {
+        auto it = std::lower_bound(merged.properties.begin(), merged.properties.end(), property);
+        if (it == merged.properties.end() || it->first != property.first) {
+            merged.properties.insert(it, property);
+        }
+    }
+    if (merged.additional_properties == ANY) {
+        merged.additional_properties = from.additional_properties;
+    }
+    if (merged.items == ANY) {
+        merged.items = from.items;
+    }
+    nodes[target] = std::move(merged);
+}
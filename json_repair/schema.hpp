@@ -0,0 +1,60 @@
+#ifndef SCHEMA_HPP
+#define SCHEMA_HPP
+
+#include <map>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+template < template < typename > class Allocator > struct BasicJSONReturnType;
+using JSONReturnType = BasicJSONReturnType< std::allocator >;
+
+// JSON Schema compiled once into an immutable table of nodes that can be shared between parsers
+// and threads. Only what drives the repair is kept: types, properties, additionalProperties,
+// items, anyOf/oneOf/allOf (merged) and local $ref.
+class CompiledSchema {
+public:
+    enum Type : unsigned {
+        OBJECT = 1 << 0,
+        ARRAY = 1 << 1,
+        STRING = 1 << 2,
+        NUMBER = 1 << 3,
+        INTEGER = 1 << 4,
+        BOOLEAN = 1 << 5,
+        NULL_VALUE = 1 << 6,
+        ANY_TYPE = (1 << 7) - 1
+    };
+
+    // Node 0 accepts anything, the parser does not look at the schema there
+    static constexpr size_t ANY = 0;
+
+    struct Node {
+        unsigned types = ANY_TYPE;
+        // Sorted by key
+        std::vector< std::pair< std::string, size_t > > properties;
+        size_t additional_properties = ANY;
+        size_t items = ANY;
+    };
+
+    static std::shared_ptr< const CompiledSchema > compile(const JSONReturnType& schema);
+    static std::shared_ptr< const CompiledSchema > compile(const std::string& schema_text);
+
+    size_t root() const { return root_node; }
+    const Node& node(size_t index) const { return nodes[index]; }
+    size_t property(size_t index, std::string_view key) const;
+    size_t items(size_t index) const { return nodes[index].items; }
+
+private:
+    CompiledSchema() = default;
+
+    size_t compile_node(const JSONReturnType& schema, const JSONReturnType& document);
+    void merge_into(size_t target, size_t source);
+
+    std::vector< Node > nodes;
+    std::map< std::string, size_t > refs;
+    size_t root_node = ANY;
+};
+
+#endif
@@ -0,0 +1,468 @@
+#include "stream_repair.hpp"
+
+#include "constants.hpp"
+#include "object_comparer.hpp"
+
+#include <algorithm>
+#include <cctype>
+
+namespace {
+
+// -?(0|[1-9][0-9]*)(.[0-9]+)?([eE][+-]?[0-9]+)?
+bool is_json_number(const std::string& text) {
+    size_t i = 0;
+    size_t n = text.size();
+    auto digits = [&]() {
+        size_t start = i;
+        while (i < n && std::isdigit(static_cast< unsigned char >(text[i]))) {
+            i += 1;
+        }
+        return i - start;
+    };
+    if (i < n && text[i] == '-') {
+        i += 1;
+    }
+    if (i < n && text[i] == '0') {
+        i += 1;
+    } else if (digits() == 0) {
+        return false;
+    }
+    if (i < n && text[i] == '.') {
+        i += 1;
+        if (digits() == 0) {
+            return false;
+        }
+    }
+    if (i < n && (text[i] == 'e' || text[i] == 'E')) {
+        i += 1;
+        if (i < n && (text[i] == '+' || text[i] == '-')) {
+            i += 1;
+        }
+        if (digits() == 0) {
+            return false;
+        }
+    }
+    return i == n;
+}
+
+} // namespace
+
+StreamRepair::StreamRepair(JSONParser& parser, RepairSink& sink)
+    : parser(parser),
+      sink(sink),
+      progress_interval(0),
+      next_progress(0),
+      separator_pending(false),
+      separator_begin(0),
+      separator_end(0) {}
+
+void StreamRepair::set_progress(std::function< void(size_t, size_t) > callback, size_t interval) {
+    progress = std::move(callback);
+    progress_interval = std::max< size_t >(interval, 1);
+    next_progress = progress_interval;
+}
+
+size_t StreamRepair::run() {
+    size_t values = 0;
+    while (parser.index < parser.get_length() && parser.limit_exceeded == LimitExceeded::NONE) {
+        char current_char = parser.get_char_at();
+        if (current_char == '{' || current_char == '[') {
+            parser.context = JsonContext();
+            if (values > 0) {
+                sink.separate_values(parser.index);
+            }
+            size_t start_index = parser.index;
+            parser.index += 1;
+            if (current_char == '{') {
+                stream_object(start_index);
+            } else {
+                stream_array(start_index);
+            }
+            values += 1;
+        } else if (current_char == '#' || current_char == '/') {
+            skip_top_level_comment();
+        } else {
+            parser.index += 1;
+        }
+    }
+    if (values == 0) {
+        write(JSONReturnType::dump_string(""), parser.index, parser.index);
+    }
+    if (progress) {
+        progress(parser.get_length(), parser.get_length());
+    }
+    return values;
+}
+
+void StreamRepair::write(const std::string& text, size_t source_begin, size_t source_end) {
+    if (separator_pending) {
+        separator_pending = false;
+        if (separator_begin == separator_end) {
+            sink.write(",", source_begin, source_begin);
+        } else {
+            sink.write(",", separator_begin, separator_end);
+        }
+    }
+    sink.write(text, source_begin, source_end);
+    if (progress && parser.index >= next_progress) {
+        progress(parser.index, parser.get_length());
+        next_progress = parser.index + progress_interval;
+    }
+}
+
+void StreamRepair::set_separator(size_t comma_index) {
+    separator_pending = true;
+    separator_begin = comma_index;
+    separator_end = comma_index == std::string::npos ? comma_index : comma_index + 1;
+}
+
+void StreamRepair::skip_top_level_comment() {
+    // Same as parse_comment with an empty context, without parsing the next value
+    char current_char = parser.get_char_at();
+    if (current_char == '/' && parser.get_char_at(1) == '*') {
+        parser.index += 2;
+        while (parser.get_char_at() && !(parser.get_char_at() == '*' && parser.get_char_at(1) == '/')) {
+            parser.index += 1;
+        }
+        parser.index = std::min(parser.index + 2, parser.get_length());
+        parser.log("Found block comment, ignoring");
+    } else if (current_char == '#' || parser.get_char_at(1) == '/') {
+        while (current_char && current_char != '\n' && current_char != '\r') {
+            parser.index += 1;
+            current_char = parser.get_char_at();
+        }
+        parser.log("Found line comment, ignoring");
+    } else {
+        parser.index += 1;
+    }
+}
+
+bool StreamRepair::stream_json() {
+    while (true) {
+        char current_char = parser.get_char_at();
+        if (current_char == '\0') {
+            write(JSONReturnType::dump_string(""), parser.index, parser.index);
+            return true;
+        } else if (current_char == '{' || current_char == '[') {
+            size_t start_index = parser.index;
+            parser.index += 1;
+            if (current_char == '{') {
+                stream_object(start_index);
+            } else {
+                stream_array(start_index);
+            }
+            return true;
+        } else if (!parser.context.isEmpty() &&
+                   (is_string_delimiter(current_char) || std::isalpha(current_char) ||
+                    std::isdigit(current_char) || current_char == '-' || current_char == '.')) {
+            return stream_scalar(parser.index);
+        } else if (current_char == '#' || current_char == '/') {
+            if (parser.context.isEmpty()) {
+                skip_top_level_comment();
+                continue;
+            }
+            size_t start_index = parser.index;
+            parser.parse_comment();
+            write(JSONReturnType::dump_string(""), start_index, parser.index);
+            return true;
+        } else {
+            parser.index += 1;
+        }
+    }
+}
+
+bool StreamRepair::stream_scalar(size_t start_index) {
+    char current_char = parser.get_char_at();
+    bool quoted = is_string_delimiter(current_char);
+
+    JSONReturnType value;
+    if (parser.schema_node != CompiledSchema::ANY) {
+        value = parser.parse_typed();
+    } else if (quoted || std::isalpha(current_char)) {
+        value = parser.parse_string();
+    } else {
+        value = parser.parse_number();
+    }
+
+    if (parser.context.getCurrent() == ContextValues::ARRAY) {
+        if (parser.index == start_index) {
+            parser.log("While parsing an array, the value did not consume anything, skipping a character");
+            parser.index += 1;
+            return false;
+        } else if (ObjectComparer::is_strictly_empty(value)) {
+            parser.index += 1;
+            return false;
+        } else if (value == "..." && parser.get_char_at(-1) == '.') {
+            parser.log("While parsing an array, found a stray '...'; ignoring it");
+            return false;
+        }
+    }
+
+    // Keep the source spelling of numbers and literals when it is already valid JSON
+    std::string text;
+    if (value.is< JSONReturnType::StringType >()) {
+        const auto& str = value.get< JSONReturnType::StringType >();
+        if (!quoted && (str == "true" || str == "false" || str == "null") &&
+            parser.get_range(start_index, parser.index) == str) {
+            text = str;
+        } else {
+            text = JSONReturnType::dump_string(str);
+        }
+    } else if (value.is< JSONReturnType::DoubleType >()) {
+        text = parser.get_range(start_index, parser.index);
+        if (!is_json_number(text)) {
+            text = value.dump();
+        }
+    } else {
+        text = value.dump();
+    }
+    write(text, start_index, parser.index);
+    return true;
+}
+
+void StreamRepair::stream_object(size_t brace_index) {
+    // Mirrors parse_object, brace_index is npos when parse_array found a key without braces
+    size_t start_index = parser.index;
+    size_t brace_begin = brace_index == std::string::npos ? start_index : brace_index;
+    size_t brace_end = brace_index == std::string::npos ? start_index : brace_index + 1;
+    size_t object_node = parser.schema_node;
+    bool opened = false;
+    bool projected_out = false;
+    bool rolled_back = false;
+    size_t count = 0;
+    size_t comma_index = std::string::npos;
+    // Only needed for the duplicate key check, which only happens inside arrays
+    std::set< std::string > keys;
+
+    while (true) {
+        while (parser.get_char_at() != '}' && parser.get_char_at() != '\0') {
+            parser.skip_whitespaces();
+
+            if (parser.get_char_at() == ':') {
+                parser.log("While parsing an object we found a : before a key, ignoring");
+                parser.index += 1;
+            }
+
+            parser.context.set(ContextValues::OBJECT_KEY);
+
+            size_t rollback_index = parser.index;
+            std::string key = "";
+            while (parser.get_char_at() != '\0') {
+                rollback_index = parser.index;
+                if (!parser.recall_key(key)) {
+                    key = parser.parse_string();
+                }
+                if (key.empty()) {
+                    parser.skip_whitespaces();
+                }
+                if (!key.empty() || (key.empty() && (parser.get_char_at() == ':' || parser.get_char_at() == '}'))) {
+                    break;
+                }
+            }
+            size_t key_end = parser.index;
+
+            bool check_duplicates = parser.context.contains(ContextValues::ARRAY);
+            if (check_duplicates && keys.count(key) && parser.charge_backtrack(parser.index - rollback_index + 1)) {
+                parser.log("While parsing an object we found a duplicate key, closing the object here and rolling back the index");
+                parser.remember_key(rollback_index, key);
+                parser.index = rollback_index - 1;
+                rolled_back = true;
+                break;
+            }
+
+            parser.skip_whitespaces();
+
+            if (parser.get_char_at() == '}' || parser.get_char_at() == '\0') {
+                continue;
+            }
+
+            parser.skip_whitespaces();
+
+            size_t colon_index = parser.index;
+            bool has_colon = parser.get_char_at() == ':';
+            if (!has_colon) {
+                parser.log("While parsing an object we missed a : after a key");
+            }
+
+            parser.index += 1;
+            parser.context.reset();
+            parser.context.set(ContextValues::OBJECT_VALUE);
+            parser.skip_whitespaces();
+
+            if (parser.projection) {
+                parser.path.push_back(key);
+                if (!parser.projection->keep(parser.path)) {
+                    if (parser.get_char_at() != ',' && parser.get_char_at() != '}') {
+                        parser.index += parser.skip_value();
+                    }
+                    parser.path.pop_back();
+                    parser.context.reset();
+                    projected_out = true;
+                    if (parser.get_char_at() == ',') {
+                        parser.index += 1;
+                    }
+                    parser.skip_whitespaces();
+                    continue;
+                }
+            }
+            if (parser.schema) {
+                parser.schema_node = parser.schema->property(object_node, key);
+            }
+
+            if (!opened) {
+                write("{", brace_begin, brace_end);
+                opened = true;
+            }
+            if (count > 0) {
+                set_separator(comma_index);
+            }
+            write(JSONReturnType::dump_string(key), rollback_index, key_end);
+            write(":", colon_index, has_colon ? colon_index + 1 : colon_index);
+
+            if (parser.get_char_at() == ',' || parser.get_char_at() == '}') {
+                parser.log("While parsing an object value we found a stray , ignoring it");
+                write(JSONReturnType::dump_string(""), parser.index, parser.index);
+            } else {
+                stream_json();
+            }
+
+            parser.schema_node = object_node;
+            if (parser.projection) {
+                parser.path.pop_back();
+            }
+            parser.context.reset();
+            if (check_duplicates) {
+                keys.insert(key);
+            }
+            count += 1;
+            parser.count_node();
+
+            comma_index = std::string::npos;
+            if (parser.get_char_at() == ',') {
+                comma_index = parser.index;
+                parser.index += 1;
+            } else if (parser.get_char_at() == '\'' || parser.get_char_at() == '"') {
+                parser.index += 1;
+            }
+
+            parser.skip_whitespaces();
+        }
+
+        size_t close_index = parser.index;
+        bool has_brace = !rolled_back && parser.get_char_at() == '}';
+        parser.index += 1;
+
+        if (count == 0 && !projected_out && parser.index - start_index > 2 &&
+            parser.charge_backtrack(parser.index - start_index)) {
+            parser.log("Parsed object is empty, we will try to parse this as an array instead");
+            parser.index = start_index;
+            stream_array(brace_index);
+            return;
+        }
+
+        if (parser.context.isEmpty()) {
+            parser.skip_whitespaces();
+            if (parser.get_char_at() == ',') {
+                parser.index += 1;
+                parser.skip_whitespaces();
+                if (is_string_delimiter(parser.get_char_at())) {
+                    parser.log("Found a comma and string delimiter after object closing brace, checking for additional key-value pairs");
+                    comma_index = std::string::npos;
+                    continue;
+                }
+            }
+        }
+
+        if (!opened) {
+            write("{", brace_begin, brace_end);
+        }
+        separator_pending = false;
+        write("}", close_index, has_brace ? close_index + 1 : close_index);
+        return;
+    }
+}
+
+void StreamRepair::stream_array(size_t bracket_index) {
+    // Mirrors parse_array, bracket_index may also be the { of an object parsed as an array
+    size_t start_index = parser.index;
+    if (bracket_index == std::string::npos) {
+        write("[", start_index, start_index);
+    } else {
+        write("[", bracket_index, bracket_index + 1);
+    }
+
+    parser.context.set(ContextValues::ARRAY);
+    size_t array_node = parser.schema_node;
+    size_t count = 0;
+    size_t projected_out = 0;
+    size_t comma_index = std::string::npos;
+    char current_char = parser.get_char_at();
+    while (current_char && current_char != ']' && current_char != '}') {
+        parser.skip_whitespaces();
+        if (parser.projection) {
+            parser.path.push_back(std::to_string(count + projected_out));
+            if (!parser.projection->keep(parser.path)) {
+                parser.path.pop_back();
+                char next_char = parser.get_char_at();
+                if (next_char && next_char != ']' && next_char != '}') {
+                    parser.index += parser.skip_value();
+                    projected_out += 1;
+                }
+                current_char = parser.get_char_at();
+                while (current_char && current_char != ']' && (std::isspace(current_char) || current_char == ',')) {
+                    parser.index += 1;
+                    current_char = parser.get_char_at();
+                }
+                continue;
+            }
+        }
+        if (parser.schema) {
+            parser.schema_node = parser.schema->items(array_node);
+        }
+        if (count > 0) {
+            set_separator(comma_index);
+        }
+
+        bool wrote = true;
+        if (is_string_delimiter(current_char)) {
+            size_t i = parser.skip_to_character(current_char, 1);
+            i = parser.scroll_whitespaces(i + 1);
+            if (parser.get_char_at(i) == ':') {
+                stream_object(std::string::npos);
+            } else {
+                wrote = stream_scalar(parser.index);
+            }
+        } else {
+            wrote = stream_json();
+        }
+
+        if (parser.projection) {
+            parser.path.pop_back();
+        }
+        parser.schema_node = array_node;
+        if (wrote) {
+            count += 1;
+            parser.count_node();
+        }
+
+        comma_index = std::string::npos;
+        current_char = parser.get_char_at();
+        while (current_char && current_char != ']' && (std::isspace(current_char) || current_char == ',')) {
+            if (current_char == ',') {
+                comma_index = parser.index;
+            }
+            parser.index += 1;
+            current_char = parser.get_char_at();
+        }
+    }
+
+    if (current_char != ']') {
+        parser.log("While parsing an array we missed the closing ], ignoring it");
+    }
+
+    separator_pending = false;
+    bool has_bracket = current_char == ']' || current_char == '}';
+    write("]", parser.index, has_bracket ? parser.index + 1 : parser.index);
+    parser.index += 1;
+    parser.context.reset();
+}
@@ -0,0 +1,77 @@
+#ifndef STREAM_REPAIR_HPP
+#define STREAM_REPAIR_HPP
+
+#include "json_parser.hpp"
+
+#include <cstddef>
+#include <functional>
+#include <ostream>
+#include <set>
+#include <string>
+
+// Receives the repaired document piece by piece
+class RepairSink {
+public:
+    virtual ~RepairSink() = default;
+
+    // text replaces the source bytes [source_begin, source_end), an empty range is an insertion
+    virtual void write(const std::string& text, size_t source_begin, size_t source_end) = 0;
+    // Called between two top-level values
+    virtual void separate_values(size_t source_position) { write("\n", source_position, source_position); }
+};
+
+class OstreamSink : public RepairSink {
+public:
+    explicit OstreamSink(std::ostream& out) : out(out), bytes_written(0) {}
+
+    void write(const std::string& text, size_t, size_t) override {
+        out.write(text.data(), text.size());
+        bytes_written += text.size();
+    }
+
+    size_t written() const { return bytes_written; }
+
+private:
+    std::ostream& out;
+    size_t bytes_written;
+};
+
+// Repairs the parser input into a sink without materializing containers. Memory is bounded by the
+// nesting depth, the largest scalar and the parser source (the StringFileWrapper window for files).
+// Differences with parse(): keys keep their source order and duplicates are not merged,
+// multiple top-level values are written one per line instead of being wrapped in an array, and
+// true, false and null written as such in the source stay literals where parse() returns the
+// strings "true", "false" and "null". Numbers keep their source spelling when it is valid JSON.
+class StreamRepair {
+public:
+    StreamRepair(JSONParser& parser, RepairSink& sink);
+
+    // callback(bytes_done, bytes_total) is called every interval bytes of input and at the end
+    void set_progress(std::function< void(size_t, size_t) > callback, size_t interval = 1 << 20);
+
+    // Returns the number of top-level values written
+    size_t run();
+
+private:
+    bool stream_json();
+    void stream_object(size_t brace_index);
+    void stream_array(size_t bracket_index);
+    bool stream_scalar(size_t start_index);
+
+    void write(const std::string& text, size_t source_begin, size_t source_end);
+    void set_separator(size_t comma_index);
+    void skip_top_level_comment();
+
+    JSONParser& parser;
+    RepairSink& sink;
+    std::function< void(size_t, size_t) > progress;
+    size_t progress_interval;
+    size_t next_progress;
+
+    // Separator written before the next value of the current container, if any
+    bool separator_pending;
+    size_t separator_begin;
+    size_t separator_end;
+};
+
+#endif
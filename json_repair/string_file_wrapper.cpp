@@ -1,76 +1,153 @@
 #include "string_file_wrapper.hpp"
+#include "decompressing_reader.hpp"
+#include "trace.hpp"
 #include <algorithm>
+#include <stdexcept>
 
-StringFileWrapper::StringFileWrapper(std::fstream& file_descriptor, size_t chunk_length) 
-    : fd(file_descriptor), length(0) {
+StringFileWrapper::StringFileWrapper(std::fstream& file_descriptor, size_t chunk_length, size_t max_buffers) 
+    : fd(&file_descriptor), reader(nullptr), next_chunk(0), read_length(0), reader_ended(false), length(0) {
     if (!chunk_length || chunk_length < 2) {
         chunk_length = 1000000; // 1MB default
     }
     this->buffer_length = chunk_length;
+    if (!max_buffers) {
+        max_buffers = std::max(static_cast<size_t>(2), static_cast<size_t>(2000000 / buffer_length));
+    }
+    this->max_buffers = max_buffers;
+}
+
+StringFileWrapper::StringFileWrapper(DecompressingReader& reader, size_t max_buffers)
+    : fd(nullptr), reader(&reader), next_chunk(0), read_length(0), reader_ended(false), length(0) {
+    this->buffer_length = reader.chunk_length();
+    if (!max_buffers) {
+        max_buffers = std::max(static_cast<size_t>(2), static_cast<size_t>(2000000 / buffer_length));
+    }
+    this->max_buffers = max_buffers;
+}
+
+void StringFileWrapper::evict() {
+    while (buffers.size() > max_buffers) {
+        buffers.erase(loaded.front());
+        loaded.pop_front();
+    }
 }
 
-std::string StringFileWrapper::get_buffer(size_t index) {
+const std::string& StringFileWrapper::read_buffer(size_t index) {
+    size_t offset = index * buffer_length;
+    JSON_REPAIR_TRACE("load_chunk", &offset);
+    if (index < next_chunk) {
+        // Rolled back past the window, decompressing again is the only way back
+        reader->rewind();
+        buffers.clear();
+        loaded.clear();
+        next_chunk = 0;
+        read_length = 0;
+        reader_ended = false;
+    }
+    while (next_chunk <= index && !reader_ended) {
+        std::string buffer;
+        if (!reader->read(buffer)) {
+            reader_ended = true;
+            length = read_length;
+            break;
+        }
+        read_length += buffer.size();
+        buffers.emplace(next_chunk, std::move(buffer));
+        loaded.push_back(next_chunk);
+        next_chunk += 1;
+        evict();
+    }
+    auto it = buffers.find(index);
+    return it == buffers.end() ? past_end : it->second;
+}
+
+const std::string& StringFileWrapper::get_buffer(size_t index) {
     auto it = buffers.find(index);
     if (it == buffers.end()) {
-        fd.seekg(index * buffer_length);
+        if (reader) {
+            return read_buffer(index);
+        }
+        size_t offset = index * buffer_length;
+        JSON_REPAIR_TRACE("load_chunk", &offset);
+        // A previous read may have hit the end of the file
+        fd->clear();
+        fd->seekg(index * buffer_length);
         std::string buffer;
         buffer.resize(buffer_length);
-        fd.read(&buffer[0], buffer_length);
-        size_t bytes_read = fd.gcount();
+        fd->read(&buffer[0], buffer_length);
+        size_t bytes_read = fd->gcount();
         buffer.resize(bytes_read);
-        buffers[index] = buffer;
-        
-        size_t max_buffers = std::max(static_cast<size_t>(2), static_cast<size_t>(2000000 / buffer_length));
-        if (buffers.size() > max_buffers) {
-            auto oldest_it = buffers.begin();
-            if (oldest_it->first != index) {
-                buffers.erase(oldest_it);
-            }
-        }
+        it = buffers.emplace(index, std::move(buffer)).first;
+        loaded.push_back(index);
+        evict();
     }
-    return buffers[index];
+    return it->second;
 }
 
 std::string StringFileWrapper::operator[](size_t index)  {
     size_t buffer_index = index / buffer_length;
-    std::string buffer = get_buffer(buffer_index);
+    const std::string& buffer = get_buffer(buffer_index);
+    if (index % buffer_length >= buffer.size()) {
+        return "";
+    }
     return std::string(1, buffer[index % buffer_length]);
 }
 
 std::string StringFileWrapper::get_range(size_t start, size_t stop)  {
-    size_t buffer_index = start / buffer_length;
-    size_t buffer_end = stop / buffer_length;
-    
-    if (buffer_index == buffer_end) {
-        std::string buffer = get_buffer(buffer_index);
-        return buffer.substr(start % buffer_length, stop - start);
-    } else {
-        std::string start_slice = get_buffer(buffer_index).substr(start % buffer_length);
-        std::string end_slice = get_buffer(buffer_end).substr(0, stop % buffer_length);
-        std::string result = start_slice;
-        
-        for (size_t i = buffer_index + 1; i < buffer_end; ++i) {
-            result += get_buffer(i);
+    std::string result;
+    while (start < stop) {
+        const std::string& buffer = get_buffer(start / buffer_length);
+        size_t offset = start % buffer_length;
+        if (offset >= buffer.size()) {
+            break;
         }
-        
-        result += end_slice;
-        return result;
+        size_t count = std::min(stop - start, buffer.size() - offset);
+        result.append(buffer, offset, count);
+        start += count;
     }
+    return result;
 }
 
 size_t StringFileWrapper::size() const {
+    if (reader) {
+        return reader_ended ? length : UNKNOWN_SIZE;
+    }
     if (length == 0) {
-        std::streampos current_position = fd.tellg();
-        fd.seekg(0, std::ios::end);
-        length = fd.tellg();
-        fd.seekg(current_position);
+        fd->clear();
+        std::streampos current_position = fd->tellg();
+        fd->seekg(0, std::ios::end);
+        length = fd->tellg();
+        fd->seekg(current_position);
     }
     return length;
 }
 
 void StringFileWrapper::write_at(size_t index, const std::string& value) {
-    std::streampos current_position = fd.tellg();
-    fd.seekp(index);
-    fd.write(value.c_str(), value.length());
-    fd.seekg(current_position);
+    if (reader) {
+        throw std::logic_error("A decompressed input cannot be written");
+    }
+    fd->clear();
+    std::streampos current_position = fd->tellg();
+    fd->seekp(index);
+    fd->write(value.c_str(), value.length());
+    fd->flush();
+    fd->seekg(current_position);
+
+    // Keep the loaded chunks and the cached length in sync with the file
+    for (size_t i = 0; i < value.length();) {
+        size_t position = index + i;
+        size_t offset = position % buffer_length;
+        size_t count = std::min(value.length() - i, buffer_length - offset);
+        auto it = buffers.find(position / buffer_length);
+        if (it != buffers.end()) {
+            if (it->second.size() < offset + count) {
+                it->second.resize(offset + count);
+            }
+            it->second.replace(offset, count, value, i, count);
+        }
+        i += count;
+    }
+    if (length != 0 && index + value.length() > length) {
+        length = index + value.length();
+    }
 }
\ No newline at end of file
@@ -1,25 +1,55 @@
 #ifndef STRING_FILE_WRAPPER_HPP
 #define STRING_FILE_WRAPPER_HPP
 
+#include <cstddef>
+#include <deque>
 #include <fstream>
 #include <string>
 #include <unordered_map>
 
+class DecompressingReader;
+
 class StringFileWrapper {
 private:
-    std::fstream& fd;
+    std::fstream* fd;
+    // Forward-only source read instead of fd. A chunk evicted before it is needed again is read
+    // again by rewinding the reader.
+    DecompressingReader* reader;
+    // Index of the chunk the reader returns next
+    size_t next_chunk;
+    size_t read_length;
+    bool reader_ended;
     mutable size_t length;
     std::unordered_map< size_t, std::string > buffers;
+    // Chunk indices in load order, the oldest one is evicted first
+    std::deque< size_t > loaded;
     size_t buffer_length;
+    size_t max_buffers;
 
 public:
-    StringFileWrapper(std::fstream& file_descriptor, size_t chunk_length);
+    // At most max_buffers chunks of chunk_length bytes are kept in memory (0 keeps about 2MB)
+    StringFileWrapper(std::fstream& file_descriptor, size_t chunk_length, size_t max_buffers = 0);
+    // Chunks are the reader's, the length is UNKNOWN_SIZE until its end is reached
+    explicit StringFileWrapper(DecompressingReader& reader, size_t max_buffers = 0);
+
+    // Larger than any input, and small enough for the parser to add to and multiply
+    static constexpr size_t UNKNOWN_SIZE = static_cast< size_t >(-1) / 16;
 
-    std::string get_buffer(size_t index);
+    const std::string& get_buffer(size_t index);
     std::string operator[](size_t index);
     std::string get_range(size_t start, size_t stop);
     size_t size() const;
+    // Read from a DecompressingReader, and how many bytes it returned so far
+    bool streamed() const { return reader != nullptr; }
+    size_t bytes_read() const { return read_length; }
     void write_at(size_t index, const std::string& value);
+
+private:
+    const std::string& read_buffer(size_t index);
+    // Keeps at most max_buffers chunks
+    void evict();
+
+    std::string past_end;
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,127 @@
+#include "trace.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+
+namespace {
+
+// Written by its thread, read by collect(). The lock is uncontended except while collecting.
+struct Ring {
+    std::mutex mutex;
+    std::vector< TraceEvent > events;
+    size_t next = 0;
+    bool wrapped = false;
+    uint32_t thread = 0;
+
+    void clear(size_t capacity) {
+        events.assign(capacity, TraceEvent());
+        next = 0;
+        wrapped = false;
+    }
+};
+
+struct Registry {
+    std::mutex mutex;
+    // Rings outlive their thread, so the events of finished workers are still collected
+    std::vector< std::shared_ptr< Ring > > rings;
+    size_t capacity = 1 << 16;
+};
+
+Registry& registry() {
+    static Registry instance;
+    return instance;
+}
+
+Ring& thread_ring() {
+    thread_local std::shared_ptr< Ring > ring = []() {
+        auto created = std::make_shared< Ring >();
+        Registry& all = registry();
+        std::lock_guard< std::mutex > lock(all.mutex);
+        created->thread = all.rings.size() + 1;
+        created->clear(all.capacity);
+        all.rings.push_back(created);
+        return created;
+    }();
+    return *ring;
+}
+
+} // namespace
+
+std::atomic< bool > Tracer::enabled{false};
+
+void Tracer::start(size_t capacity) {
+    // The ring of this thread is allocated now rather than inside its first scope
+    thread_ring();
+    Registry& all = registry();
+    std::lock_guard< std::mutex > lock(all.mutex);
+    all.capacity = std::max< size_t >(capacity, 1);
+    for (auto& ring : all.rings) {
+        std::lock_guard< std::mutex > ring_lock(ring->mutex);
+        ring->clear(all.capacity);
+    }
+    enabled = true;
+}
+
+void Tracer::stop() {
+    enabled = false;
+}
+
+std::vector< TraceEvent > Tracer::collect() {
+    std::vector< TraceEvent > events;
+    Registry& all = registry();
+    std::lock_guard< std::mutex > lock(all.mutex);
+    for (auto& ring : all.rings) {
+        std::lock_guard< std::mutex > ring_lock(ring->mutex);
+        size_t count = ring->wrapped ? ring->events.size() : ring->next;
+        events.insert(events.end(), ring->events.begin(), ring->events.begin() + count);
+        ring->next = 0;
+        ring->wrapped = false;
+    }
+    std::sort(events.begin(), events.end(), [](const TraceEvent& a, const TraceEvent& b) {
+        return a.start_ns != b.start_ns ? a.start_ns < b.start_ns : a.duration_ns > b.duration_ns;
+    });
+    return events;
+}
+
+void Tracer::record(const char* name, uint64_t start_ns, size_t begin_offset, size_t end_offset) {
+    uint64_t end_ns = now();
+    Ring& ring = thread_ring();
+    std::lock_guard< std::mutex > lock(ring.mutex);
+    ring.events[ring.next] = TraceEvent{name, start_ns, end_ns - start_ns, begin_offset, end_offset, ring.thread};
+    ring.next += 1;
+    if (ring.next == ring.events.size()) {
+        ring.next = 0;
+        ring.wrapped = true;
+    }
+}
+
+uint64_t Tracer::now() {
+    return std::chrono::duration_cast< std::chrono::nanoseconds >(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+std::string chrome_trace(const std::vector< TraceEvent >& events) {
+    uint64_t origin = events.empty() ? 0 : events.front().start_ns;
+    for (const auto& event : events) {
+        origin = std::min(origin, event.start_ns);
+    }
+    std::string out = "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+    char line[256];
+    for (size_t i = 0; i < events.size(); ++i) {
+        const TraceEvent& event = events[i];
+        // Complete events in microseconds, each carries its own duration so that an evicted
+        // parent leaves no unmatched begin or end
+        std::snprintf(line, sizeof(line),
+                      "%s\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f,"
+                      "\"args\":{\"begin\":%zu,\"end\":%zu}}",
+                      i ? "," : "", event.name, event.thread, (event.start_ns - origin) / 1e3,
+                      event.duration_ns / 1e3, event.begin_offset, event.end_offset);
+        out += line;
+    }
+    out += "\n]}\n";
+    return out;
+}
@@ -0,0 +1,119 @@
+#ifndef TRACE_HPP
+#define TRACE_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#ifdef JSON_REPAIR_TRACING
+#if defined(__has_include)
+#if __has_include(<sys/sdt.h>)
+#include <sys/sdt.h>
+#define JSON_REPAIR_USDT 1
+#endif
+#endif
+#endif
+
+// A parser scope that completed, offsets are the parser index at its start and end
+struct TraceEvent {
+    const char* name;
+    uint64_t start_ns;
+    uint64_t duration_ns;
+    size_t begin_offset;
+    size_t end_offset;
+    uint32_t thread;
+};
+
+// Keeps the last events of each thread in a ring buffer while started. The scopes are only
+// compiled in with JSON_REPAIR_TRACING, without it nothing is ever recorded.
+class Tracer {
+public:
+    // Clears the buffers, each keeps capacity events
+    static void start(size_t capacity = 1 << 16);
+    static void stop();
+    static bool active() { return enabled.load(std::memory_order_relaxed); }
+
+    // The events of every thread by start time, the buffers are cleared
+    static std::vector< TraceEvent > collect();
+
+    static void record(const char* name, uint64_t start_ns, size_t begin_offset, size_t end_offset);
+    static uint64_t now();
+
+private:
+    static std::atomic< bool > enabled;
+};
+
+// Chrome trace-event JSON of events, opened by chrome://tracing or Perfetto as a timeline
+std::string chrome_trace(const std::vector< TraceEvent >& events);
+
+#ifdef JSON_REPAIR_TRACING
+class TraceScope {
+public:
+    TraceScope(const char* name, const size_t* offset)
+        : name(name), offset(offset), begin(offset ? *offset : 0), start(Tracer::active() ? Tracer::now() : 0) {
+#ifdef JSON_REPAIR_USDT
+        DTRACE_PROBE2(json_repair, enter, name, begin);
+#endif
+    }
+
+    ~TraceScope() {
+        size_t end = offset ? *offset : 0;
+#ifdef JSON_REPAIR_USDT
+        DTRACE_PROBE3(json_repair, exit, name, begin, end);
+#endif
+        if (start != 0 && Tracer::active()) {
+            Tracer::record(name, start, begin, end);
+        }
+    }
+
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+
+private:
+    const char* name;
+    const size_t* offset;
+    size_t begin;
+    uint64_t start;
+};
+
+// Start of a scope that is not lexical, such as a frame of parse_iterative
+struct TraceMark {
+    void open(const char* scope, size_t offset) {
+        name = scope;
+        begin = offset;
+        start = Tracer::active() ? Tracer::now() : 0;
+#ifdef JSON_REPAIR_USDT
+        DTRACE_PROBE2(json_repair, enter, name, begin);
+#endif
+    }
+
+    void close(size_t offset) const {
+#ifdef JSON_REPAIR_USDT
+        DTRACE_PROBE3(json_repair, exit, name, begin, offset);
+#endif
+        if (start != 0 && Tracer::active()) {
+            Tracer::record(name, start, begin, offset);
+        }
+    }
+
+    const char* name = nullptr;
+    uint64_t start = 0;
+    size_t begin = 0;
+};
+
+// Traces the enclosing scope, offset points to the position read at its start and end or is null
+#define JSON_REPAIR_TRACE(name, offset) TraceScope json_repair_trace_scope(name, offset)
+// A TraceMark member, opened and closed by hand
+#define JSON_REPAIR_TRACE_MARK(member) TraceMark member
+#define JSON_REPAIR_TRACE_OPEN(mark, name, offset) (mark).open(name, offset)
+#define JSON_REPAIR_TRACE_CLOSE(mark, offset) (mark).close(offset)
+#else
+#define JSON_REPAIR_TRACE(name, offset) ((void)(offset))
+#define JSON_REPAIR_TRACE_MARK(member) static_assert(true, "")
+#define JSON_REPAIR_TRACE_OPEN(mark, name, offset) ((void)0)
+#define JSON_REPAIR_TRACE_CLOSE(mark, offset) ((void)0)
+#endif
+
+#endif
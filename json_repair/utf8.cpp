@@ -0,0 +1,136 @@
+#include "utf8.hpp"
+
+#include <cstdio>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace {
+
+// Length of the valid sequence at i, or 0 and in bad the length of its maximal invalid subpart,
+// which is replaced as one character
+size_t sequence_length(std::string_view text, size_t i, size_t& bad) {
+    unsigned char lead = text[i];
+    size_t length;
+    unsigned char low = 0x80;
+    unsigned char high = 0xBF;
+    if (lead < 0x80) {
+        return 1;
+    } else if (lead >= 0xC2 && lead <= 0xDF) {
+        length = 2;
+    } else if (lead >= 0xE0 && lead <= 0xEF) {
+        length = 3;
+        // No overlong forms and no encoded surrogates
+        low = lead == 0xE0 ? 0xA0 : 0x80;
+        high = lead == 0xED ? 0x9F : 0xBF;
+    } else if (lead >= 0xF0 && lead <= 0xF4) {
+        length = 4;
+        low = lead == 0xF0 ? 0x90 : 0x80;
+        high = lead == 0xF4 ? 0x8F : 0xBF;
+    } else {
+        bad = 1;
+        return 0;
+    }
+    for (size_t k = 1; k < length; ++k) {
+        if (i + k >= text.size()) {
+            bad = k;
+            return 0;
+        }
+        unsigned char c = text[i + k];
+        if (c < low || c > high) {
+            bad = k;
+            return 0;
+        }
+        low = 0x80;
+        high = 0xBF;
+    }
+    return length;
+}
+
+size_t valid_from(std::string_view text, size_t i) {
+    while (i < text.size()) {
+#if defined(__SSE2__)
+        while (i + 16 <= text.size()) {
+            __m128i chunk = _mm_loadu_si128(reinterpret_cast< const __m128i* >(text.data() + i));
+            if (_mm_movemask_epi8(chunk) != 0) {
+                break;
+            }
+            i += 16;
+        }
+        if (i >= text.size()) {
+            break;
+        }
+#endif
+        size_t bad;
+        size_t length = sequence_length(text, i, bad);
+        if (length == 0) {
+            return i;
+        }
+        i += length;
+    }
+    return text.size();
+}
+
+} // namespace
+
+size_t valid_utf8_prefix(std::string_view text) {
+    return valid_from(text, 0);
+}
+
+size_t repair_utf8(std::string& str, Utf8Policy policy) {
+    size_t i = valid_from(str, 0);
+    if (i == str.size()) {
+        return 0;
+    }
+    bool rewrite = policy != Utf8Policy::KEEP;
+    std::string result;
+    if (rewrite) {
+        result.assign(str, 0, i);
+    }
+    size_t invalid = 0;
+    while (i < str.size()) {
+        size_t bad;
+        if (sequence_length(str, i, bad) != 0) {
+            size_t end = valid_from(str, i);
+            if (rewrite) {
+                result.append(str, i, end - i);
+            }
+            i = end;
+            continue;
+        }
+        invalid += 1;
+        if (policy == Utf8Policy::REPLACE) {
+            result += "\xEF\xBF\xBD";
+        } else if (policy == Utf8Policy::ESCAPE) {
+            for (size_t k = 0; k < bad; ++k) {
+                char escaped[5];
+                std::snprintf(escaped, sizeof(escaped), "\\x%02X", static_cast< unsigned char >(str[i + k]));
+                result += escaped;
+            }
+        }
+        i += bad;
+    }
+    if (rewrite) {
+        str = std::move(result);
+    }
+    return invalid;
+}
+
+void append_utf8(std::string& out, uint32_t code_point) {
+    if (code_point < 0x80) {
+        out += static_cast< char >(code_point);
+    } else if (code_point < 0x800) {
+        out += static_cast< char >(0xC0 | (code_point >> 6));
+        out += static_cast< char >(0x80 | (code_point & 0x3F));
+    } else if (code_point < 0x10000) {
+        out += static_cast< char >(0xE0 | (code_point >> 12));
+        out += static_cast< char >(0x80 | ((code_point >> 6) & 0x3F));
+        out += static_cast< char >(0x80 | (code_point & 0x3F));
+    } else {
+        out += static_cast< char >(0xF0 | (code_point >> 18));
+        out += static_cast< char >(0x80 | ((code_point >> 12) & 0x3F));
+        out += static_cast< char >(0x80 | ((code_point >> 6) & 0x3F));
+        out += static_cast< char >(0x80 | (code_point & 0x3F));
+    }
+}
@@ -0,0 +1,30 @@
+#ifndef UTF8_HPP
+#define UTF8_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+// What parse_string does with a byte sequence that is not valid UTF-8, such as a multi-byte
+// character cut by a truncated token, or a \u escape of an unpaired surrogate
+enum class Utf8Policy {
+    // Left as they are, strings are not validated
+    KEEP,
+    // One U+FFFD per invalid sequence
+    REPLACE,
+    DROP,
+    // Invalid bytes written as the text \xNN, unpaired surrogate escapes kept as \uXXXX
+    ESCAPE,
+};
+
+// Length of the longest valid UTF-8 prefix of text, checked 16 bytes at a time while they are ASCII
+size_t valid_utf8_prefix(std::string_view text);
+
+// Rewrites the invalid sequences of str according to policy, returns how many there were.
+// KEEP only counts them.
+size_t repair_utf8(std::string& str, Utf8Policy policy);
+
+void append_utf8(std::string& out, uint32_t code_point);
+
+#endif
@@ -0,0 +1,122 @@
+#include "json_repair/allocation_counter.hpp"
+#include "json_repair/json_parser.hpp"
+#include "json_repair/parser_pool.hpp"
+#include <array>
+#include <cstddef>
+#include <iostream>
+#include <memory_resource>
+#include <string>
+
+// Allocations per document, after warm-up a parse only allocates the repaired value: one node
+// per object member, log2 growth steps per array and the strings that do not fit inline.
+
+int failures = 0;
+
+void check(bool passed, const std::string& name, const std::string& detail) {
+    if (!passed) {
+        failures += 1;
+        std::cerr << "FAILED " << name << ": " << detail << std::endl;
+    }
+}
+
+void check_bound(const std::string& name, size_t allocations, size_t bound) {
+    check(allocations <= bound, name,
+          std::to_string(allocations) + " allocations, at most " + std::to_string(bound) + " expected");
+}
+
+std::string embedding(size_t size) {
+    std::string input = "{\"embedding\": [";
+    for (size_t i = 0; i < size; ++i) {
+        input += (i ? ", " : "") + std::to_string(i * 0.001 - 0.5);
+    }
+    return input + "]}";
+}
+
+struct Case {
+    const char* name;
+    std::string input;
+    size_t max_allocations;
+};
+
+const Case cases[] = {
+    {"flat object", R"({"id": 1, "name": "x", "ok": true})", 3},
+    {"broken object", R"({id: 1 name: 'x' ok: True)", 3},
+    {"number array", "[1, 2, 3, 4, 5]", 4},
+    {"long string", R"({"text": "a string longer than the inline buffer"})", 2},
+    {"nested", R"({"a": {"b": [{"c": null}]}})", 4},
+    {"trailing pairs", R"({"a": 1}, "b": 2, "c": 3})", 3},
+    {"comments", "{\"a\": 1, // note\n\"b\": [2] /* end */}", 3},
+    // Packed: one member node and the doubling steps of one std::vector< double >
+    {"packed numbers", embedding(1024), 12},
+};
+
+void test_pooled_parse() {
+    for (const auto& test : cases) {
+        // Warm-up, the pooled parser keeps its buffers
+        ParserPool::acquire(test.input)->parse();
+        AllocationCounter counter;
+        {
+            auto parser = ParserPool::acquire(test.input);
+            JSONReturnType value = parser->parse();
+            check_bound(test.name, counter.allocations(), test.max_allocations);
+        }
+    }
+}
+
+void test_logs_are_moved() {
+    const std::string input = R"({"a": 1 "b": [1, 2,, 3], c: 'x')";
+    size_t parse_allocations = 0;
+    {
+        JSONParser parser(input, true);
+        AllocationCounter counter;
+        JSONReturnType value = parser.parse();
+        parse_allocations = counter.allocations();
+    }
+    JSONParser parser(input, true);
+    AllocationCounter counter;
+    auto result = parser.parse_with_logs();
+    check_bound("parse_with_logs", counter.allocations(), parse_allocations);
+    check(!result.second.empty(), "parse_with_logs", "no logs");
+}
+
+void test_memory_resource() {
+    const std::string input = R"({"records": [{"id": 1, "tags": ["a", "b"]}, {"id": 2, "note": "longer than inline"}]})";
+    JSONParser parser(input);
+    std::string expected = parser.parse().dump();
+
+    std::array< std::byte, 16 << 10 > buffer;
+    for (int round = 0; round < 2; ++round) {
+        parser.reset(input);
+        // Fails instead of falling back to the heap
+        std::pmr::monotonic_buffer_resource arena(buffer.data(), buffer.size(), std::pmr::null_memory_resource());
+        AllocationCounter counter;
+        PmrJSONReturnType value = parser.parse(&arena);
+        if (round == 1) {
+            check_bound("memory resource", counter.allocations(), 0);
+        }
+        check(value.dump() == expected, "memory resource", value.dump());
+        check(parser.resource == std::pmr::get_default_resource(), "memory resource", "the arena was kept");
+    }
+
+    // An arena too small for the result throws, the parser does not keep it either
+    std::array< std::byte, 64 > small;
+    std::pmr::monotonic_buffer_resource arena(small.data(), small.size(), std::pmr::null_memory_resource());
+    parser.reset(input);
+    try {
+        parser.parse(&arena);
+        check(false, "small memory resource", "no exception");
+    } catch (const std::bad_alloc&) {
+    }
+    check(parser.resource == std::pmr::get_default_resource(), "small memory resource", "the arena was kept");
+}
+
+int main() {
+    test_pooled_parse();
+    test_logs_are_moved();
+    test_memory_resource();
+    if (failures) {
+        return 1;
+    }
+    std::cout << "all allocation tests passed" << std::endl;
+    return 0;
+}
@@ -0,0 +1,88 @@
+#include "json_repair/async_repair.hpp"
+#include "json_repair/json_parser.hpp"
+#include <deque>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// The coroutine API fed through a ByteChannel, against parse() on the whole input
+
+int failures = 0;
+
+void check(bool passed, const std::string& name, const std::string& detail) {
+    if (!passed) {
+        failures += 1;
+        std::cerr << "FAILED " << name << ": " << detail << std::endl;
+    }
+}
+
+const std::string inputs[] = {
+    R"({"name": "f", "arguments": {"x": 1, "y": [1, 2, 3]}})",
+    R"({"a": 1} {"a": 1} {"b": [true, null]} "tail")",
+    R"(```json
+[{"id": 1, "note": 'single quoted'}, {"id": 2, "unterminated)",
+    R"({"a": 1}, "b": 2, "c": 3})",
+    "",
+};
+
+// Every byte pushed on its own, the reader resumed inline by push()
+void test_byte_by_byte() {
+    for (const auto& input : inputs) {
+        ByteChannel channel;
+        Task< JSONReturnType > task = async_repair(channel);
+        task.start();
+        for (char c : input) {
+            channel.push(std::string_view(&c, 1));
+        }
+        channel.close();
+        check(task.done(), "byte by byte", "not done: " + input);
+        if (task.done()) {
+            std::string expected = JSONParser(input).parse().dump();
+            std::string found = task.result().dump();
+            check(found == expected, "byte by byte", found + " instead of " + expected);
+        }
+    }
+}
+
+// Values come out before the input is closed, resumed through an executor queue
+void test_values_before_close() {
+    std::deque< std::coroutine_handle<> > queue;
+    auto run = [&]() {
+        while (!queue.empty()) {
+            auto handle = queue.front();
+            queue.pop_front();
+            handle.resume();
+        }
+    };
+    ByteChannel channel([&](std::coroutine_handle<> handle) { queue.push_back(handle); });
+    std::vector< std::string > seen;
+    auto consume = [&](ByteChannel& source) -> Task< int > {
+        auto values = repair_values(source);
+        while (auto value = co_await values.next()) {
+            seen.push_back(value->dump());
+        }
+        co_return 0;
+    };
+    Task< int > task = consume(channel);
+    task.start();
+    channel.push("{\"id\": 1}\n{\"id\": ");
+    run();
+    check(seen.empty(), "before close", "a value was returned before the next one started");
+    channel.push("2}\n{");
+    run();
+    check(seen.size() == 1, "before close", std::to_string(seen.size()) + " values");
+    channel.push("\"id\": 3}");
+    channel.close();
+    run();
+    check(task.done() && seen.size() == 3, "before close", std::to_string(seen.size()) + " values at the end");
+}
+
+int main() {
+    test_byte_by_byte();
+    test_values_before_close();
+    if (failures) {
+        return 1;
+    }
+    std::cout << "all async tests passed" << std::endl;
+    return 0;
+}
@@ -0,0 +1,78 @@
+#include "json_repair/binary_writer.hpp"
+#include "json_repair/json_parser.hpp"
+#include <iostream>
+#include <string>
+
+// Exact MessagePack and CBOR bytes of repaired values
+
+int failures = 0;
+
+std::string hex(const std::string& bytes) {
+    static const char digits[] = "0123456789abcdef";
+    std::string text;
+    for (unsigned char c : bytes) {
+        text += digits[c >> 4];
+        text += digits[c & 15];
+    }
+    return text;
+}
+
+void expect(const std::string& input, const std::string& msgpack, const std::string& cbor) {
+    JSONParser parser(input);
+    JSONReturnType value = parser.parse();
+    std::string found[2] = {to_msgpack(value), to_cbor(value)};
+    const std::string* expected[2] = {&msgpack, &cbor};
+    const BinaryFormat formats[2] = {BinaryFormat::MSGPACK, BinaryFormat::CBOR};
+    for (int f = 0; f < 2; ++f) {
+        if (hex(found[f]) != *expected[f] || encoded_size(value, formats[f]) != found[f].size()) {
+            failures += 1;
+            std::cerr << "FAILED " << input << ": " << hex(found[f]) << " instead of " << *expected[f] << std::endl;
+        }
+    }
+}
+
+int main() {
+    // Parsed numbers are doubles, those holding an int are written as the smallest int
+    expect(R"({"a": 1, "e": 2.5)", "82a16101a165cb4004000000000000", "a26161016165fb4004000000000000");
+    expect(R"({"a": 4294967296.0, "b": -1})", "82a161cf0000000100000000a162ff", "a261611b0000000100000000616220");
+    // And the elements of packed arrays, negative zero and doubles past the range of an int stay float64
+    expect(R"([1.5, 2])", "92cb3ff800000000000002", "82fb3ff800000000000002");
+    expect(R"([-0.0, 1e20, 4294967296.0, -2147483649.0, 255, -129])",
+           "96cb8000000000000000cb4415af1d78b58c40cf0000000100000000d3ffffffff7fffffffccffd1ff7f",
+           "86fb8000000000000000fb4415af1d78b58c401b00000001000000003a8000000018ff3880");
+    expect(R"(["x", {"k": []}, "abcdefghijklmnopqrstuvwxyzABCDEFG"])",
+           "93a17881a16b90d9216162636465666768696a6b6c6d6e6f707172737475767778797a41424344454647",
+           "836178a1616b80782161626364656667"
+           "68696a6b6c6d6e6f707172737475767778797a41424344454647");
+
+    // Ints are kept as the smallest int
+    JSONReturnType::MapType map;
+    map["a"] = JSONReturnType(JSONReturnType::Data(1));
+    map["b"] = JSONReturnType(JSONReturnType::Data(-1));
+    map["c"] = JSONReturnType(JSONReturnType::Data(300));
+    map["d"] = JSONReturnType(JSONReturnType::Data(-70000));
+    map["e"] = JSONReturnType(JSONReturnType::Data(100000));
+    map["n"] = nullptr;
+    map["t"] = true;
+    JSONReturnType value(map);
+    std::string msgpack = hex(to_msgpack(value));
+    std::string cbor = hex(to_cbor(value));
+    if (msgpack != "87a16101a162ffa163cd012ca164d2fffeee90a165ce000186a0a16ec0a174c3" ||
+        cbor != "a7616101616220616319012c61643a0001116f61651a000186a0616ef66174f5") {
+        failures += 1;
+        std::cerr << "FAILED ints, bool and null: " << msgpack << " " << cbor << std::endl;
+    }
+
+    // Values are appended to what the buffer holds
+    std::string out = "x";
+    write_binary(JSONReturnType(JSONReturnType::StringType("y")), BinaryFormat::CBOR, out);
+    if (out != "xay") {
+        failures += 1;
+        std::cerr << "FAILED append: " << hex(out) << std::endl;
+    }
+
+    if (failures == 0) {
+        std::cout << "binary_test passed" << std::endl;
+    }
+    return failures == 0 ? 0 : 1;
+}
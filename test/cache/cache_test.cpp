@@ -0,0 +1,160 @@
+#include "json_repair/json_parser.hpp"
+#include "json_repair/result_cache.hpp"
+#include <atomic>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// ResultCache hits, eviction and expiry, and a parser looking its input up in a cache
+
+int failures = 0;
+
+void check(bool condition, const std::string& what) {
+    if (!condition) {
+        failures += 1;
+        std::cerr << "FAILED " << what << std::endl;
+    }
+}
+
+const char* inputs[] = {
+    R"({"a": 1, "b": [1, 2, 3], "c": 'x'})",
+    R"([{"id": 1}, {"id": 2, "name": "unterminated)",
+    "[1.5, 2.5, -3, 4e2]",
+    R"({"key": "value" "other": tru)",
+};
+
+int main() {
+    {
+        ResultCache cache;
+        auto first = cache.parse(inputs[0]);
+        auto second = cache.parse(inputs[0]);
+        check(first == second, "the second parse shares the cached value");
+        check(*first == JSONParser(inputs[0]).parse(), "the cached value is the one parsed");
+        CacheStats stats = cache.stats();
+        check(stats.hits == 1 && stats.misses == 1 && stats.entries == 1, "one miss then one hit");
+        check(cache.parse(inputs[0], true) != first, "stream_stable is part of the key");
+        for (const char* input : inputs) {
+            check(*cache.repair(input) == JSONParser(input).parse().dump(), std::string("repair of ") + input);
+        }
+        auto text = cache.repair(inputs[1]);
+        check(cache.repair(inputs[1]) == text, "the repaired text is kept");
+        cache.clear();
+        check(cache.stats().entries == 0 && cache.stats().bytes == 0, "clear");
+    }
+    {
+        CacheOptions options;
+        options.max_bytes = 4096;
+        options.shards = 1;
+        ResultCache cache(options);
+        for (int i = 0; i < 200; ++i) {
+            cache.parse("{\"n\": " + std::to_string(i) + ", \"pad\": \"" + std::string(64, 'x') + "\"}");
+        }
+        CacheStats stats = cache.stats();
+        check(stats.evictions > 0 && stats.bytes <= options.max_bytes, "eviction under max_bytes");
+        cache.parse("{\"n\": 199, \"pad\": \"" + std::string(64, 'x') + "\"}");
+        check(cache.stats().hits == 1, "the newest entry stays");
+    }
+    {
+        CacheOptions options;
+        options.ttl = std::chrono::milliseconds(1);
+        ResultCache cache(options);
+        cache.parse(inputs[2]);
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        cache.parse(inputs[2]);
+        CacheStats stats = cache.stats();
+        check(stats.expirations == 1 && stats.misses == 2, "expired entries are parsed again");
+    }
+    {
+        auto cache = std::make_shared< ResultCache >();
+        for (int round = 0; round < 2; ++round) {
+            for (const char* input : inputs) {
+                JSONParser parser(input);
+                parser.cache = cache;
+                check(parser.parse() == JSONParser(input).parse(), std::string("cached parse of ") + input);
+            }
+        }
+        check(cache->stats().hits == 4, "the parser looks its input up");
+        JSONParser logged(inputs[0], true);
+        logged.cache = cache;
+        logged.parse_with_logs();
+        logged.parse();
+        check(cache->stats().hits == 4, "logging parsers bypass the cache");
+    }
+    {
+        ResultCache cache;
+        std::atomic< int > wrong{0};
+        std::vector< std::thread > threads;
+        for (int t = 0; t < 4; ++t) {
+            threads.emplace_back([&]() {
+                for (int i = 0; i < 500; ++i) {
+                    const char* input = inputs[i % 4];
+                    if (*cache.repair(input) != JSONParser(input).parse().dump()) {
+                        wrong += 1;
+                    }
+                }
+            });
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        check(wrong == 0, "concurrent repairs");
+        check(cache.stats().entries == 4, "concurrent repairs share the entries");
+    }
+    {
+        // Const reads of a cached value from several threads, run under -fsanitize=thread to see
+        // that none of them writes. Modifying the nested value left hashes to compute.
+        const std::string input = R"({"embedding": [1, 2, 3, 4, 5, 6], "meta": {"n": 1}})";
+        JSONReturnType modified = JSONParser(input).parse();
+        modified["meta"]["n"] = 2.0;
+        auto cache = std::make_shared< ResultCache >();
+        auto shared = cache->insert(ResultCache::key(input, false, JSONParser::DEFAULT_MAX_DEPTH), modified);
+        size_t hash = modified.hash();
+        std::atomic< int > wrong{0};
+        std::vector< std::thread > threads;
+        for (int t = 0; t < 4; ++t) {
+            threads.emplace_back([&, t]() {
+                for (int i = 0; i < 200; ++i) {
+                    const JSONReturnType& value = *shared;
+                    const JSONReturnType& embedding = value["embedding"];
+                    if (embedding[3 + t % 3] != 4.0 + t % 3 || !embedding.is< JSONReturnType::PackedType >() ||
+                        value.hash() != hash || value["meta"].hash() == 0 || !(value == modified)) {
+                        wrong += 1;
+                    }
+                    JSONParser parser(input);
+                    parser.cache = cache;
+                    if (parser.parse() != modified) {
+                        wrong += 1;
+                    }
+                }
+            });
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        check(wrong == 0, "concurrent reads of a cached value");
+    }
+    {
+        // Past max_depth the iterative engine keeps the text and the recursive one nests, each
+        // gets its own entry
+        const std::string input = "[[[[1]]]]";
+        auto cache = std::make_shared< ResultCache >();
+        std::string dumps[2][2];
+        for (int round = 0; round < 2; ++round) {
+            for (bool iterative : {true, false}) {
+                JSONParser parser(input);
+                parser.iterative = iterative;
+                parser.max_depth = 2;
+                parser.cache = round ? cache : nullptr;
+                dumps[round][iterative] = parser.parse().dump();
+            }
+        }
+        check(dumps[0][true] != dumps[0][false], "the engines differ past max_depth");
+        check(dumps[1][true] == dumps[0][true] && dumps[1][false] == dumps[0][false], "one entry per engine");
+    }
+    if (failures) {
+        return 1;
+    }
+    std::cout << "all cache tests passed" << std::endl;
+    return 0;
+}
@@ -0,0 +1,59 @@
+#include "json_repair/candidate_scanner.hpp"
+#include "json_repair/json_parser.hpp"
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Regions found by CandidateScanner in prose, compared as the text they cover
+
+int failures = 0;
+
+void check_regions(const std::string& name,
+                   const std::string& text,
+                   CandidatePolicy policy,
+                   const std::vector< std::string >& expected) {
+    std::vector< std::string > found;
+    for (const auto& candidate : CandidateScanner::scan(text, policy)) {
+        found.push_back(text.substr(candidate.begin, candidate.size()));
+    }
+    if (found != expected) {
+        failures += 1;
+        std::cerr << "FAILED " << name << ":";
+        for (const auto& region : found) {
+            std::cerr << " <" << region << ">";
+        }
+        std::cerr << std::endl;
+    }
+}
+
+const std::string fenced = "Sure! Here is the object [1]:\n```json\n{\"a\": 1}\n```\nand a smaller one\n```\n[2]\n```\n";
+const std::string prose = "The call {\"name\": \"f\", \"args\": {\"x\": 1}} then [1, 2] but not {this} or [see above].";
+const std::string code = "```python\nd = {'a': [1]}\n```\nresult: {'ok': true";
+
+int main() {
+    check_regions("fenced first", fenced, CandidatePolicy::FIRST, {"{\"a\": 1}"});
+    check_regions("fenced all", fenced, CandidatePolicy::ALL, {"{\"a\": 1}", "[2]"});
+    check_regions("fenced largest", fenced, CandidatePolicy::LARGEST, {"{\"a\": 1}"});
+    check_regions("prose all", prose, CandidatePolicy::ALL, {"{\"name\": \"f\", \"args\": {\"x\": 1}}", "[1, 2]"});
+    check_regions("prose largest", prose, CandidatePolicy::LARGEST, {"{\"name\": \"f\", \"args\": {\"x\": 1}}"});
+    check_regions("code fence skipped", code, CandidatePolicy::ALL, {"{'ok': true"});
+    check_regions("no candidate", "just prose", CandidatePolicy::ALL, {});
+    check_regions("single quoted brace", "Result: {'a': 'x}y', 'b': 1} done", CandidatePolicy::ALL,
+                  {"{'a': 'x}y', 'b': 1}"});
+    check_regions("typographic quoted brace", "Result: {\"a\": “x}”, \"b\": 1} done", CandidatePolicy::ALL,
+                  {"{\"a\": “x}”, \"b\": 1}"});
+    check_regions("quote in other quotes", "Result: {\"a\": \"it's\", 'b': \"}\"} done", CandidatePolicy::ALL,
+                  {"{\"a\": \"it's\", 'b': \"}\"}"});
+
+    // Same value as repairing the region alone
+    auto values = repair_candidates(code);
+    if (values.size() != 1 || values[0] != JSONParser("{'ok': true").parse()) {
+        failures += 1;
+        std::cerr << "FAILED repair_candidates: " << (values.empty() ? "" : values[0].dump()) << std::endl;
+    }
+    if (failures) {
+        return 1;
+    }
+    std::cout << "all candidate tests passed" << std::endl;
+    return 0;
+}
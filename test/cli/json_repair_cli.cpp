@@ -1,29 +1,491 @@
+#include "json_repair/binary_writer.hpp"
+#include "json_repair/decompressing_reader.hpp"
+#include "json_repair/edit_script.hpp"
+#include "json_repair/json_cursor.hpp"
 #include "json_repair/json_parser.hpp"
+#include "json_repair/parser_pool.hpp"
+#include "json_repair/stream_repair.hpp"
+#include "json_repair/trace.hpp"
 #include <iostream>
+#include <atomic>
 #include <cassert>
-#include <sstream>
+#include <chrono>
+#include <cerrno>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
 #include <fstream>
+#include <glob.h>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+#include <unordered_map>
+#include <vector>
+
+// Read-only mapping of a whole file, or stdin, a pipe or a decompressed file read into memory.
+// error is set when the file cannot be read, bytes are empty then.
+class InputFile {
+public:
+    explicit InputFile(const std::string& path) {
+        if (path == "-") {
+            char chunk[1 << 16];
+            size_t n;
+            while ((n = std::fread(chunk, 1, sizeof(chunk), stdin)) > 0) {
+                buffer.append(chunk, n);
+            }
+            if (std::ferror(stdin)) {
+                error = std::strerror(errno);
+            }
+            bytes = buffer;
+            return;
+        }
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            error = std::strerror(errno);
+            return;
+        }
+        struct stat info;
+        bool compressed = false;
+        if (::fstat(fd, &info) != 0) {
+            error = std::strerror(errno);
+        } else if (S_ISDIR(info.st_mode)) {
+            error = std::strerror(EISDIR);
+        } else if (!S_ISREG(info.st_mode)) {
+            // A pipe is read once, detecting its compression would consume the first bytes
+            char chunk[1 << 16];
+            ssize_t n;
+            while ((n = ::read(fd, chunk, sizeof(chunk))) > 0) {
+                buffer.append(chunk, n);
+            }
+            if (n < 0) {
+                error = std::strerror(errno);
+            }
+            bytes = buffer;
+        } else if (detect_compression(path) != Compression::NONE) {
+            compressed = true;
+        } else if (info.st_size > 0) {
+            void* address = ::mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (address != MAP_FAILED) {
+                ::madvise(address, info.st_size, MADV_SEQUENTIAL);
+                mapped = address;
+                bytes = std::string_view(static_cast< const char* >(address), info.st_size);
+            } else {
+                error = std::strerror(errno);
+            }
+        }
+        ::close(fd);
+        if (compressed) {
+            DecompressingReader reader(path);
+            std::string chunk;
+            while (reader.read(chunk)) {
+                buffer += chunk;
+            }
+            bytes = buffer;
+        }
+    }
+    InputFile(const InputFile&) = delete;
+    InputFile& operator=(const InputFile&) = delete;
+    ~InputFile() {
+        if (mapped) {
+            ::munmap(mapped, bytes.size());
+        }
+    }
 
-std::string test_basic_parsing(std::string input) {
+    std::string_view bytes;
+    std::string error;
+
+private:
+    void* mapped = nullptr;
+    std::string buffer;
+};
+
+// The input is read where the file is mapped, reset() copies it once into the parser
+std::string test_basic_parsing(std::string_view input) {
     // Test simple string
     {
-        JSONParser parser(input);
+        JSONParser parser("");
+        parser.reset(input);
         auto result = parser.parse().dump(4);
         return result;
     }
 }
 
+std::string test_pointer(std::string_view input, const std::string& pointer) {
+    JSONParser parser("");
+    parser.reset(input);
+    auto value = JSONCursor(parser).at_pointer(pointer);
+    if (!value) {
+        return "null";
+    }
+    return value->get().dump(4);
+}
+
+int stream_file(const std::string& input_path, const std::string& output_path, size_t window) {
+    std::fstream input(input_path, std::ios::in | std::ios::binary);
+    std::ofstream output(output_path, std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!input || !output) {
+        std::cerr << "Cannot open " << (!input ? input_path : output_path) << std::endl;
+        return 1;
+    }
+    std::vector< char > output_buffer(1 << 20);
+    output.rdbuf()->pubsetbuf(output_buffer.data(), output_buffer.size());
+
+    // The window is split in 4 chunks so that small rollbacks stay in memory. Compressed input is
+    // decompressed on another thread into chunks of the same size.
+    std::unique_ptr< DecompressingReader > reader;
+    if (detect_compression(input_path) != Compression::NONE) {
+        reader = std::make_unique< DecompressingReader >(input_path, std::max< size_t >(window / 4, 2));
+    }
+    StringFileWrapper wrapper = reader ? StringFileWrapper(*reader, 4) : StringFileWrapper(input, window / 4, 4);
+    JSONParser parser(wrapper);
+    OstreamSink sink(output);
+    StreamRepair repair(parser, sink);
+
+    auto start = std::chrono::steady_clock::now();
+    auto seconds_since_start = [&start]() {
+        std::chrono::duration< double > elapsed = std::chrono::steady_clock::now() - start;
+        return std::max(elapsed.count(), 1e-9);
+    };
+    repair.set_progress([&](size_t done, size_t total) {
+        std::cerr << "\r";
+        if (total != StringFileWrapper::UNKNOWN_SIZE) {
+            std::cerr << done * 100 / std::max< size_t >(total, 1) << "% ";
+        }
+        std::cerr << done / 1e6 / seconds_since_start() << " MB/s" << std::flush;
+    }, 16 << 20);
+    size_t values;
+    try {
+        values = repair.run();
+    } catch (const std::exception& e) {
+        std::cerr << std::endl << input_path << ": " << e.what() << std::endl;
+        return 1;
+    }
+    output.flush();
+
+    double seconds = seconds_since_start();
+    std::cerr << "\rrepaired " << parser.get_length() << " bytes into " << sink.written() << " bytes ("
+              << values << " values) in " << seconds << " s, " << parser.get_length() / 1e6 / seconds
+              << " MB/s" << std::endl;
+    return output ? 0 : 1;
+}
+
+int edit_file(const std::string& input_path, bool patch) {
+    std::fstream input(input_path, std::ios::in | std::ios::out | std::ios::binary);
+    if (!input) {
+        std::cerr << "Cannot open " << input_path << std::endl;
+        return 1;
+    }
+    StringFileWrapper wrapper(input, 0);
+    JSONParser parser(wrapper);
+    auto edits = repair_edits(parser);
+    if (!patch) {
+        for (const auto& edit : edits) {
+            std::cout << "[" << edit.offset << ", " << edit.length << ", "
+                      << JSONReturnType::dump_string(edit.text) << "]\n";
+        }
+        return 0;
+    }
+
+    if (apply_edits_in_place(wrapper, edits)) {
+        std::cerr << "patched " << edits.size() << " edits in place" << std::endl;
+        return 0;
+    }
+    // Some edit moves the rest of the file, stream through a copy
+    std::string copy_path = input_path + ".repaired";
+    {
+        std::ofstream output(copy_path, std::ios::out | std::ios::binary | std::ios::trunc);
+        apply_edits(wrapper, output, edits);
+        if (!output) {
+            std::cerr << "Cannot write " << copy_path << std::endl;
+            return 1;
+        }
+    }
+    input.close();
+    if (std::rename(copy_path.c_str(), input_path.c_str()) != 0) {
+        std::cerr << "Cannot replace " << input_path << std::endl;
+        return 1;
+    }
+    std::cerr << "patched " << edits.size() << " edits through a copy" << std::endl;
+    return 0;
+}
+
+struct BatchOptions {
+    unsigned threads = 0;
+    int indent = -1;
+    // Each output is written to this directory under the name of its input, stdout when empty. Two
+    // inputs of the same name are an error.
+    std::string output_dir;
+    bool stats = false;
+    // MessagePack or CBOR instead of JSON text, the outputs are written back to back
+    bool binary = false;
+    BinaryFormat format = BinaryFormat::MSGPACK;
+};
+
+struct BatchResult {
+    std::string output;
+    size_t bytes = 0;
+    size_t repairs = 0;
+    double seconds = 0;
+    bool failed = false;
+    bool done = false;
+};
+
+// The paths matched by every argument, glob patterns are expanded and "-" is stdin
+std::vector< std::string > expand_inputs(const std::vector< std::string >& args) {
+    std::vector< std::string > paths;
+    for (const auto& arg : args) {
+        if (arg == "-" || arg.find_first_of("*?[") == std::string::npos) {
+            paths.push_back(arg);
+            continue;
+        }
+        glob_t matches;
+        if (::glob(arg.c_str(), 0, nullptr, &matches) == 0) {
+            for (size_t i = 0; i < matches.gl_pathc; ++i) {
+                paths.push_back(matches.gl_pathv[i]);
+            }
+        } else {
+            std::cerr << "No file matches " << arg << std::endl;
+        }
+        ::globfree(&matches);
+    }
+    return paths;
+}
+
+bool write_all(FILE* file, const std::string& text, bool newline = true) {
+    return std::fwrite(text.data(), 1, text.size(), file) == text.size() && (!newline || std::fputc('\n', file) != EOF);
+}
+
+// Writes a line to stderr at once, so that the lines of the workers do not interleave
+void report(const std::string& line) {
+    write_all(stderr, line + "\n", false);
+}
+
+void encode(const JSONReturnType& value, const BatchOptions& options, std::string& output) {
+    if (options.binary) {
+        write_binary(value, options.format, output);
+    } else {
+        output = value.dump(options.indent);
+    }
+}
+
+// The file each input is written to in options.output_dir, named after the input. Inputs that
+// would overwrite each other are reported instead.
+bool name_outputs(const std::vector< std::string >& paths,
+                  const BatchOptions& options,
+                  std::vector< std::string >& outputs) {
+    std::unordered_map< std::string, size_t > named;
+    for (size_t i = 0; i < paths.size(); ++i) {
+        const std::string& path = paths[i];
+        std::string name = path == "-" ? "stdin.json" : path.substr(path.find_last_of('/') + 1);
+        std::string output_path = options.output_dir + "/" + name;
+        if (options.binary) {
+            output_path += options.format == BinaryFormat::MSGPACK ? ".msgpack" : ".cbor";
+        }
+        auto [previous, inserted] = named.emplace(output_path, i);
+        if (!inserted) {
+            std::cerr << paths[previous->second] << " and " << path << " would both be written to " << output_path
+                      << std::endl;
+            return false;
+        }
+        outputs.push_back(std::move(output_path));
+    }
+    return true;
+}
+
+// Repairs path into result.output, or into output_path when it is not empty
+void repair_one(const std::string& path, const std::string& output_path, const BatchOptions& options,
+                BatchResult& result) {
+    auto start = std::chrono::steady_clock::now();
+    try {
+        InputFile input(path);
+        if (!input.error.empty()) {
+            throw std::runtime_error("Cannot read: " + input.error);
+        }
+        result.bytes = input.bytes.size();
+        // Repairs are only counted from the logs when they are reported. parse() keeps them in
+        // logger and returns every top-level value, parse_with_logs() only the first one.
+        auto parser = ParserPool::acquire(input.bytes, options.stats);
+        encode(parser->parse(), options, result.output);
+        result.repairs = parser->logger.size();
+    } catch (const std::exception& e) {
+        report(path + ": " + e.what());
+        result.failed = true;
+    }
+    if (!result.failed && !output_path.empty()) {
+        FILE* file = std::fopen(output_path.c_str(), "wb");
+        if (!file || !write_all(file, result.output, !options.binary)) {
+            report("Cannot write " + output_path);
+            result.failed = true;
+        }
+        if (file && std::fclose(file) != 0) {
+            result.failed = true;
+        }
+        result.output.clear();
+        result.output.shrink_to_fit();
+    }
+    std::chrono::duration< double > elapsed = std::chrono::steady_clock::now() - start;
+    result.seconds = std::max(elapsed.count(), 1e-9);
+}
+
+// Repairs every input on a pool of threads. Outputs to stdout are written in input order as soon
+// as they and all before them are done.
+int batch(const std::vector< std::string >& paths, const std::vector< std::string >& outputs,
+          const BatchOptions& options) {
+    std::vector< BatchResult > results(paths.size());
+    std::mutex mutex;
+    std::condition_variable finished;
+    std::atomic< size_t > next{0};
+    auto work = [&]() {
+        for (size_t i = next++; i < paths.size(); i = next++) {
+            BatchResult result;
+            repair_one(paths[i], outputs.empty() ? std::string() : outputs[i], options, result);
+            std::lock_guard< std::mutex > lock(mutex);
+            results[i] = std::move(result);
+            results[i].done = true;
+            finished.notify_one();
+        }
+    };
+
+    auto start = std::chrono::steady_clock::now();
+    unsigned threads = options.threads ? options.threads : std::max(1u, std::thread::hardware_concurrency());
+    std::vector< std::thread > workers;
+    for (unsigned t = 0; t < std::min< size_t >(threads, paths.size()); ++t) {
+        workers.emplace_back(work);
+    }
+
+    static char stdout_buffer[1 << 20];
+    std::setvbuf(stdout, stdout_buffer, _IOFBF, sizeof(stdout_buffer));
+    size_t failed = 0;
+    size_t bytes = 0;
+    size_t repairs = 0;
+    for (size_t i = 0; i < paths.size(); ++i) {
+        BatchResult result;
+        {
+            std::unique_lock< std::mutex > lock(mutex);
+            finished.wait(lock, [&]() { return results[i].done; });
+            result = std::move(results[i]);
+        }
+        if (!result.failed && options.output_dir.empty() && !write_all(stdout, result.output, !options.binary)) {
+            result.failed = true;
+        }
+        failed += result.failed;
+        bytes += result.bytes;
+        repairs += result.repairs;
+        if (options.stats) {
+            std::ostringstream line;
+            line << paths[i] << ": " << result.bytes << " bytes, " << result.repairs << " repairs, "
+                 << result.seconds * 1e3 << " ms, " << result.bytes / 1e6 / result.seconds << " MB/s";
+            report(line.str());
+        }
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    std::fflush(stdout);
+
+    if (options.stats) {
+        std::chrono::duration< double > elapsed = std::chrono::steady_clock::now() - start;
+        double seconds = std::max(elapsed.count(), 1e-9);
+        std::ostringstream line;
+        line << "repaired " << paths.size() - failed << " of " << paths.size() << " documents, " << bytes
+             << " bytes, " << repairs << " repairs in " << seconds << " s on " << workers.size()
+             << " threads: " << bytes / 1e6 / seconds << " MB/s, " << paths.size() / seconds << " docs/s";
+        report(line.str());
+    }
+    return failed ? 1 : 0;
+}
+
+int batch_main(int argc, char const* argv[]) {
+    BatchOptions options;
+    std::vector< std::string > args;
+    for (int i = 2; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--threads" && i + 1 < argc) {
+            options.threads = std::stoul(argv[++i]);
+        } else if (arg == "--pretty") {
+            options.indent = 4;
+            options.binary = false;
+        } else if (arg == "--compact") {
+            options.indent = -1;
+            options.binary = false;
+        } else if (arg == "--output-dir" && i + 1 < argc) {
+            options.output_dir = argv[++i];
+        } else if (arg == "--stats") {
+            options.stats = true;
+        } else if (arg == "--msgpack" || arg == "--cbor") {
+            options.binary = true;
+            options.format = arg == "--msgpack" ? BinaryFormat::MSGPACK : BinaryFormat::CBOR;
+        } else {
+            args.push_back(arg);
+        }
+    }
+    std::vector< std::string > paths = expand_inputs(args.empty() ? std::vector< std::string >{"-"} : args);
+    std::vector< std::string > outputs;
+    if (paths.empty() || (!options.output_dir.empty() && !name_outputs(paths, options, outputs))) {
+        return 1;
+    }
+    return batch(paths, outputs, options);
+}
+
 int main(int argc, char const *argv[])
 {
     if(argc < 2)  {
-        std::cout << "Usage: " << argv[0] << " <json_path>" << std::endl;
+        std::cout << "Usage: " << argv[0] << " <json_path> [json_pointer]" << std::endl;
+        std::cout << "       " << argv[0] << " --stream <json_path> <output_path> [window_bytes]" << std::endl;
+        std::cout << "       " << argv[0] << " --edits|--patch <json_path>" << std::endl;
+        std::cout << "       " << argv[0] << " --trace <trace_path> <json_path> [json_pointer]" << std::endl;
+        std::cout << "       " << argv[0]
+                  << " --batch [--threads n] [--compact|--pretty|--msgpack|--cbor] [--output-dir dir] [--stats] [paths, globs or -]"
+                  << std::endl;
         return 1;
     }
+    if (std::string(argv[1]) == "--stream") {
+        if (argc < 4) {
+            std::cerr << "--stream needs an input and an output path" << std::endl;
+            return 1;
+        }
+        return stream_file(argv[2], argv[3], argc > 4 ? std::stoul(argv[4]) : 4000000);
+    }
+    if (std::string(argv[1]) == "--batch") {
+        return batch_main(argc, argv);
+    }
+    if (argc > 2 && (std::string(argv[1]) == "--edits" || std::string(argv[1]) == "--patch")) {
+        return edit_file(argv[2], std::string(argv[1]) == "--patch");
+    }
+    std::string trace_path;
+    if (argc > 3 && std::string(argv[1]) == "--trace") {
+        trace_path = argv[2];
+        argc -= 2;
+        argv += 2;
+#ifndef JSON_REPAIR_TRACING
+        std::cerr << "json_repair is built without JSON_REPAIR_TRACING, the trace will be empty" << std::endl;
+#endif
+        Tracer::start();
+    }
     auto file_path = std::string(argv[1]);
-    std::ifstream file(file_path);
-    std::stringstream buffer;
-    buffer << file.rdbuf();
-    auto result = test_basic_parsing(buffer.str());
+    InputFile file(file_path);
+    if (!file.error.empty()) {
+        std::cerr << file_path << ": Cannot read: " << file.error << std::endl;
+        return 1;
+    }
+    auto result = argc > 2 ? test_pointer(file.bytes, argv[2]) : test_basic_parsing(file.bytes);
     std::cout << result << std::endl;
+    if (!trace_path.empty()) {
+        Tracer::stop();
+        std::vector< TraceEvent > events = Tracer::collect();
+        std::ofstream trace(trace_path, std::ios::binary);
+        if (!(trace << chrome_trace(events))) {
+            std::cerr << "Cannot write " << trace_path << std::endl;
+            return 1;
+        }
+        std::cerr << "wrote " << events.size() << " events to " << trace_path << std::endl;
+    }
     return 0;
 }
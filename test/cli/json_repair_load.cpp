@@ -0,0 +1,309 @@
+#include "repair_socket.hpp"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <glob.h>
+#include <iostream>
+#include <mutex>
+#include <poll.h>
+#include <sstream>
+#include <string>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+// Drives json_repair_server over its Unix socket: every connection sends the input files in turn
+// with up to --pipeline requests in flight, and the latency of each is measured from its send to
+// its response. With --spawn the server is started on a temporary socket and stopped at the end.
+// With --terminate it is sent SIGTERM once every request is sent and every connection has had a
+// response, and must still answer the requests queued by then. With --stalled, as many more
+// connections send large requests and never read the responses, the server must drop them and
+// keep answering the others. --max-outbox is passed to the spawned server.
+
+using namespace repair_socket;
+using Clock = std::chrono::steady_clock;
+
+struct LoadOptions {
+    std::string socket_path;
+    std::string spawn;
+    unsigned connections = 4;
+    size_t requests = 10000;
+    size_t pipeline = 8;
+    char kind = REPAIR_JSON;
+    bool terminate = false;
+    unsigned stalled = 0;
+    // Passed to the spawned server, empty for its default
+    std::string max_outbox;
+};
+
+// The spawned server, sent SIGTERM by the last connection to send its requests with --terminate
+pid_t spawned = -1;
+std::atomic< unsigned > senders_done{0};
+
+struct ConnectionResult {
+    LatencyHistogram latency;
+    size_t errors = 0;
+    size_t bytes_out = 0;
+    // Set by either thread of the connection
+    std::atomic< bool > failed{false};
+};
+
+int connect_to(const std::string& path) {
+    int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    std::strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+    if (fd >= 0 && ::connect(fd, reinterpret_cast< sockaddr* >(&address), sizeof(address)) == 0) {
+        return fd;
+    }
+    if (fd >= 0) {
+        ::close(fd);
+    }
+    return -1;
+}
+
+// Sends count requests on one connection, a reader thread takes the responses so that the
+// socket buffers never fill in both directions at once
+void drive(const LoadOptions& options, const std::vector< std::string >& inputs, size_t count,
+           ConnectionResult& result) {
+    int fd = connect_to(options.socket_path);
+    if (fd < 0) {
+        result.failed = true;
+        return;
+    }
+    std::vector< Clock::time_point > sent(count);
+    std::mutex mutex;
+    std::condition_variable answered;
+    size_t in_flight = 0;
+    size_t received = 0;
+
+    std::thread reader([&]() {
+        Frame response;
+        for (size_t i = 0; i < count; ++i) {
+            if (!read_frame(fd, response) || response.id >= count) {
+                result.failed = true;
+                break;
+            }
+            auto now = Clock::now();
+            std::lock_guard< std::mutex > lock(mutex);
+            result.latency.record(std::chrono::duration_cast< std::chrono::microseconds >(now - sent[response.id]).count());
+            if (response.kind != OK) {
+                result.errors += 1;
+                std::cerr << "request " << response.id << ": " << response.payload << std::endl;
+            }
+            result.bytes_out += response.payload.size();
+            received += 1;
+            in_flight -= 1;
+            answered.notify_one();
+        }
+        std::lock_guard< std::mutex > lock(mutex);
+        in_flight = 0;
+        answered.notify_one();
+    });
+
+    for (size_t i = 0; i < count && !result.failed; ++i) {
+        {
+            std::unique_lock< std::mutex > lock(mutex);
+            answered.wait(lock, [&]() { return in_flight < options.pipeline || result.failed; });
+            in_flight += 1;
+            sent[i] = Clock::now();
+        }
+        if (!write_frame(fd, i, options.kind, inputs[i % inputs.size()])) {
+            result.failed = true;
+        }
+    }
+    if (result.failed) {
+        ::shutdown(fd, SHUT_RDWR);
+    }
+    if (options.terminate && spawned > 0) {
+        {
+            std::unique_lock< std::mutex > lock(mutex);
+            answered.wait(lock, [&]() { return received > 0 || in_flight == 0 || result.failed; });
+        }
+        if (++senders_done == options.connections) {
+            ::kill(spawned, SIGTERM);
+        }
+    }
+    reader.join();
+    ::close(fd);
+}
+
+// Sends large requests without reading a response, true once the server drops the connection.
+// The responses are never read, a drop is seen as the hangup of both directions.
+bool stall(const std::string& path) {
+    int fd = connect_to(path);
+    if (fd < 0) {
+        return false;
+    }
+    const std::string payload = "{\"stalled\": \"" + std::string(64 << 10, 'x') + "\"}";
+    for (uint32_t id = 0; id < 1024 && write_frame(fd, id, REPAIR_JSON, payload); ++id) {
+    }
+    pollfd hangup{fd, 0, 0};
+    bool dropped = ::poll(&hangup, 1, 60000) > 0 && (hangup.revents & POLLHUP);
+    ::close(fd);
+    return dropped;
+}
+
+std::string request_stats(const std::string& path) {
+    int fd = connect_to(path);
+    Frame response;
+    if (fd < 0 || !write_frame(fd, 0, STATS, "") || !read_frame(fd, response)) {
+        response.payload = "{}";
+    }
+    if (fd >= 0) {
+        ::close(fd);
+    }
+    return response.payload;
+}
+
+// Starts the server and waits until its socket accepts connections
+pid_t spawn_server(const std::string& server, const std::string& socket_path, const std::string& max_outbox) {
+    pid_t pid = ::fork();
+    if (pid == 0) {
+        if (max_outbox.empty()) {
+            ::execl(server.c_str(), server.c_str(), "--socket", socket_path.c_str(), static_cast< char* >(nullptr));
+        } else {
+            ::execl(server.c_str(), server.c_str(), "--socket", socket_path.c_str(), "--max-outbox", max_outbox.c_str(),
+                    static_cast< char* >(nullptr));
+        }
+        std::_Exit(127);
+    }
+    for (int attempt = 0; attempt < 100; ++attempt) {
+        int fd = connect_to(socket_path);
+        if (fd >= 0) {
+            ::close(fd);
+            return pid;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    }
+    ::kill(pid, SIGKILL);
+    ::waitpid(pid, nullptr, 0);
+    return -1;
+}
+
+int main(int argc, char const* argv[]) {
+    LoadOptions options;
+    std::vector< std::string > patterns;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--socket" && i + 1 < argc) {
+            options.socket_path = argv[++i];
+        } else if (arg == "--spawn" && i + 1 < argc) {
+            options.spawn = argv[++i];
+        } else if (arg == "--connections" && i + 1 < argc) {
+            options.connections = std::max(1ul, std::stoul(argv[++i]));
+        } else if (arg == "--requests" && i + 1 < argc) {
+            options.requests = std::stoul(argv[++i]);
+        } else if (arg == "--pipeline" && i + 1 < argc) {
+            options.pipeline = std::max(1ul, std::stoul(argv[++i]));
+        } else if (arg == "--msgpack") {
+            options.kind = REPAIR_MSGPACK;
+        } else if (arg == "--cbor") {
+            options.kind = REPAIR_CBOR;
+        } else if (arg == "--terminate") {
+            options.terminate = true;
+        } else if (arg == "--stalled" && i + 1 < argc) {
+            options.stalled = std::stoul(argv[++i]);
+        } else if (arg == "--max-outbox" && i + 1 < argc) {
+            options.max_outbox = argv[++i];
+        } else {
+            patterns.push_back(arg);
+        }
+    }
+
+    std::vector< std::string > inputs;
+    for (const auto& pattern : patterns) {
+        glob_t matches;
+        if (::glob(pattern.c_str(), 0, nullptr, &matches) == 0) {
+            for (size_t i = 0; i < matches.gl_pathc; ++i) {
+                std::ifstream file(matches.gl_pathv[i], std::ios::binary);
+                std::stringstream buffer;
+                buffer << file.rdbuf();
+                inputs.push_back(buffer.str());
+            }
+        }
+        ::globfree(&matches);
+    }
+    if (inputs.empty() || (options.socket_path.empty() && options.spawn.empty())) {
+        std::cout << "Usage: " << argv[0]
+                  << " --socket path|--spawn server [--connections n] [--requests n] [--pipeline n]"
+                     " [--msgpack|--cbor] [--terminate] [--stalled n] [--max-outbox bytes] files or globs"
+                  << std::endl;
+        return 1;
+    }
+
+    if (options.terminate && options.spawn.empty()) {
+        std::cerr << "--terminate needs --spawn" << std::endl;
+        return 1;
+    }
+    if (!options.spawn.empty()) {
+        if (options.socket_path.empty()) {
+            options.socket_path = "/tmp/json_repair_load_" + std::to_string(::getpid()) + ".sock";
+        }
+        spawned = spawn_server(options.spawn, options.socket_path, options.max_outbox);
+        if (spawned < 0) {
+            std::cerr << "Cannot start " << options.spawn << std::endl;
+            return 1;
+        }
+    }
+
+    size_t bytes_in = 0;
+    for (size_t i = 0; i < options.requests; ++i) {
+        bytes_in += inputs[i % inputs.size()].size();
+    }
+    std::atomic< unsigned > stalled_dropped{0};
+    std::vector< std::thread > stalled;
+    for (unsigned c = 0; c < options.stalled; ++c) {
+        stalled.emplace_back([&]() { stalled_dropped += stall(options.socket_path); });
+    }
+    std::vector< ConnectionResult > results(options.connections);
+    std::vector< std::thread > threads;
+    auto start = Clock::now();
+    for (unsigned c = 0; c < options.connections; ++c) {
+        size_t count = options.requests / options.connections + (c < options.requests % options.connections);
+        threads.emplace_back([&, c, count]() { drive(options, inputs, count, results[c]); });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    for (auto& thread : stalled) {
+        thread.join();
+    }
+    double seconds = std::max(std::chrono::duration< double >(Clock::now() - start).count(), 1e-9);
+
+    ConnectionResult total;
+    for (const auto& result : results) {
+        total.latency.merge(result.latency);
+        total.errors += result.errors;
+        total.bytes_out += result.bytes_out;
+        total.failed = total.failed || result.failed;
+    }
+    std::cout << total.latency.count() << " requests in " << seconds << " s on " << options.connections
+              << " connections, pipeline " << options.pipeline << ": " << total.latency.count() / seconds
+              << " requests/s, " << bytes_in / 1e6 / seconds << " MB/s in, " << total.errors << " errors" << std::endl;
+    std::cout << "latency us p50 " << total.latency.percentile(0.5) << ", p90 " << total.latency.percentile(0.9)
+              << ", p99 " << total.latency.percentile(0.99) << ", p999 " << total.latency.percentile(0.999)
+              << ", max " << total.latency.max() << std::endl;
+    if (options.stalled) {
+        std::cout << stalled_dropped << " of " << options.stalled << " stalled connections dropped" << std::endl;
+    }
+    if (!options.terminate) {
+        std::cout << "server stats " << request_stats(options.socket_path) << std::endl;
+    }
+
+    if (spawned > 0) {
+        ::kill(spawned, SIGTERM);
+        ::waitpid(spawned, nullptr, 0);
+    }
+    return total.failed || total.errors || total.latency.count() != options.requests ||
+                   stalled_dropped != options.stalled
+               ? 1
+               : 0;
+}
@@ -0,0 +1,398 @@
+#include "json_repair/binary_writer.hpp"
+#include "json_repair/json_parser.hpp"
+#include "json_repair/parser_pool.hpp"
+#include "repair_socket.hpp"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <csignal>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <poll.h>
+#include <set>
+#include <sstream>
+#include <string>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+// Repairs requests read from a Unix domain socket on a pool of workers. Each connection has a
+// reader thread that queues its requests, the workers take up to --batch of them at a time and
+// queue each response for the writer thread of its connection. Stats requests are answered by
+// the reader at once. A client that stops reading only holds up its writer, and is dropped once
+// more than --max-outbox bytes of responses wait for it. SIGINT or SIGTERM stops reading, the
+// queued requests are still answered before the server exits, and connections still not written
+// to after --drain-timeout seconds are dropped.
+
+using namespace repair_socket;
+using Clock = std::chrono::steady_clock;
+
+volatile std::sig_atomic_t stop_requested = 0;
+
+void request_stop(int) {
+    stop_requested = 1;
+}
+
+struct ServerOptions {
+    std::string socket_path;
+    unsigned threads = 0;
+    size_t batch = 16;
+    size_t max_queue = 4096;
+    size_t max_outbox = 64u << 20;
+    std::chrono::seconds drain_timeout{30};
+};
+
+class Connection {
+public:
+    Connection(int fd, size_t max_outbox) : fd(fd), max_outbox(max_outbox) {}
+    ~Connection() { ::close(fd); }
+
+    // A request was read, the writer waits for its response
+    void received() {
+        std::lock_guard< std::mutex > lock(mutex);
+        pending += 1;
+    }
+
+    // Queues the response, the connection is dropped instead when too much is already queued
+    void respond(uint32_t id, char kind, std::string payload) {
+        std::lock_guard< std::mutex > lock(mutex);
+        pending -= 1;
+        if (dropped) {
+            return;
+        }
+        size_t size = HEADER_SIZE + payload.size();
+        if (outbox_bytes > 0 && outbox_bytes + size > max_outbox) {
+            drop_locked();
+            return;
+        }
+        outbox_bytes += size;
+        outbox.push_back(Frame{id, kind, std::move(payload)});
+        changed.notify_one();
+    }
+
+    void stop_reading() {
+        std::lock_guard< std::mutex > lock(mutex);
+        reading = false;
+        changed.notify_one();
+    }
+
+    void drop() {
+        std::lock_guard< std::mutex > lock(mutex);
+        drop_locked();
+    }
+
+    bool is_dropped() {
+        std::lock_guard< std::mutex > lock(mutex);
+        return dropped;
+    }
+
+    // Writes the queued responses, several at once when they are queued faster than written,
+    // until every request read was answered or the connection is dropped
+    void write_responses() {
+        std::string data;
+        std::unique_lock< std::mutex > lock(mutex);
+        while (true) {
+            changed.wait(lock, [this]() { return dropped || !outbox.empty() || (!reading && pending == 0); });
+            if (dropped || outbox.empty()) {
+                return;
+            }
+            size_t size = outbox_bytes;
+            for (const Frame& frame : outbox) {
+                append_frame(data, frame.id, frame.kind, frame.payload);
+            }
+            outbox.clear();
+            lock.unlock();
+            bool written = write_full(fd, data.data(), data.size());
+            data.clear();
+            lock.lock();
+            if (dropped) {
+                return;
+            }
+            outbox_bytes -= size;
+            if (!written) {
+                drop_locked();
+                return;
+            }
+        }
+    }
+
+    const int fd;
+
+private:
+    void drop_locked() {
+        dropped = true;
+        outbox.clear();
+        outbox_bytes = 0;
+        // Wakes the reader and a writer blocked on the socket
+        ::shutdown(fd, SHUT_RDWR);
+        changed.notify_one();
+    }
+
+    const size_t max_outbox;
+    std::mutex mutex;
+    std::condition_variable changed;
+    std::deque< Frame > outbox;
+    // Queued and being written
+    size_t outbox_bytes = 0;
+    size_t pending = 0;
+    bool reading = true;
+    bool dropped = false;
+};
+
+struct Job {
+    std::shared_ptr< Connection > connection;
+    Frame request;
+    Clock::time_point received;
+};
+
+class Server {
+public:
+    explicit Server(const ServerOptions& options)
+        : options(options), started(Clock::now()), last_stats(started), stopping(false) {}
+
+    int run() {
+        listen_fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+        sockaddr_un address{};
+        address.sun_family = AF_UNIX;
+        if (options.socket_path.size() >= sizeof(address.sun_path)) {
+            std::cerr << "Socket path too long: " << options.socket_path << std::endl;
+            return 1;
+        }
+        std::strcpy(address.sun_path, options.socket_path.c_str());
+        ::unlink(options.socket_path.c_str());
+        if (listen_fd < 0 || ::bind(listen_fd, reinterpret_cast< sockaddr* >(&address), sizeof(address)) != 0 ||
+            ::listen(listen_fd, 128) != 0) {
+            std::cerr << "Cannot listen on " << options.socket_path << ": " << std::strerror(errno) << std::endl;
+            return 1;
+        }
+
+        unsigned threads = options.threads ? options.threads : std::max(1u, std::thread::hardware_concurrency());
+        std::vector< std::thread > workers;
+        for (unsigned t = 0; t < threads; ++t) {
+            workers.emplace_back([this]() { work(); });
+        }
+        std::cerr << "listening on " << options.socket_path << " with " << threads << " workers" << std::endl;
+
+        // Polled so that a signal is noticed without a connection
+        while (!stop_requested) {
+            pollfd listening{listen_fd, POLLIN, 0};
+            if (::poll(&listening, 1, 200) <= 0) {
+                continue;
+            }
+            int fd = ::accept(listen_fd, nullptr, nullptr);
+            if (fd >= 0) {
+                start_serving(fd);
+            }
+        }
+
+        // Clients of the connections waiting in the backlog may have sent requests already
+        pollfd pending{listen_fd, POLLIN, 0};
+        while (::poll(&pending, 1, 0) > 0) {
+            int fd = ::accept(listen_fd, nullptr, nullptr);
+            if (fd < 0) {
+                break;
+            }
+            start_serving(fd);
+        }
+        ::close(listen_fd);
+        ::unlink(options.socket_path.c_str());
+        // Only the reading side is shut down: the requests already sent are still queued and
+        // answered, and each connection is closed once its last response is written. Clients that
+        // do not read them are dropped after drain_timeout.
+        std::unique_lock< std::mutex > lock(mutex);
+        for (Connection* connection : connections) {
+            ::shutdown(connection->fd, SHUT_RD);
+        }
+        if (!readers_done.wait_for(lock, options.drain_timeout, [this]() { return connections.empty(); })) {
+            for (Connection* connection : connections) {
+                connection->drop();
+            }
+            readers_done.wait(lock, [this]() { return connections.empty(); });
+        }
+        stopping = true;
+        queue_changed.notify_all();
+        lock.unlock();
+        for (auto& worker : workers) {
+            worker.join();
+        }
+        std::cerr << stats() << std::endl;
+        return 0;
+    }
+
+private:
+    void start_serving(int fd) {
+        auto connection = std::make_shared< Connection >(fd, options.max_outbox);
+        std::lock_guard< std::mutex > lock(mutex);
+        connections.insert(connection.get());
+        std::thread([this, connection]() { serve(connection); }).detach();
+    }
+
+    void serve(std::shared_ptr< Connection > connection) {
+        std::thread writer([connection]() { connection->write_responses(); });
+        Frame request;
+        while (read_frame(connection->fd, request)) {
+            connection->received();
+            if (request.kind == STATS) {
+                connection->respond(request.id, OK, stats());
+                continue;
+            }
+            std::unique_lock< std::mutex > lock(mutex);
+            queue_changed.wait(lock, [this]() { return queue.size() < options.max_queue; });
+            bytes_in += request.payload.size();
+            queue.push_back(Job{connection, std::move(request), Clock::now()});
+            max_depth = std::max(max_depth, queue.size());
+            queue_changed.notify_all();
+        }
+        connection->stop_reading();
+        writer.join();
+        std::lock_guard< std::mutex > lock(mutex);
+        dropped += connection->is_dropped();
+        connections.erase(connection.get());
+        readers_done.notify_all();
+    }
+
+    void work() {
+        std::vector< Job > batch;
+        std::vector< uint64_t > latencies;
+        while (true) {
+            {
+                std::unique_lock< std::mutex > lock(mutex);
+                queue_changed.wait(lock, [this]() { return stopping || !queue.empty(); });
+                if (queue.empty()) {
+                    return;
+                }
+                size_t count = std::min(options.batch, queue.size());
+                for (size_t i = 0; i < count; ++i) {
+                    batch.push_back(std::move(queue.front()));
+                    queue.pop_front();
+                }
+                batches += 1;
+                queue_changed.notify_all();
+            }
+
+            size_t failed = 0;
+            size_t written = 0;
+            for (Job& job : batch) {
+                // Its client will not get the response
+                if (job.connection->is_dropped()) {
+                    continue;
+                }
+                std::string output;
+                char status = OK;
+                try {
+                    // Parsers are pooled per thread, so each worker keeps reusing its own
+                    auto parser = ParserPool::acquire(job.request.payload);
+                    JSONReturnType value = parser->parse();
+                    if (job.request.kind == REPAIR_MSGPACK) {
+                        write_binary(value, BinaryFormat::MSGPACK, output);
+                    } else if (job.request.kind == REPAIR_CBOR) {
+                        write_binary(value, BinaryFormat::CBOR, output);
+                    } else if (job.request.kind == REPAIR_JSON) {
+                        output = value.dump();
+                    } else {
+                        throw std::runtime_error(std::string("Unknown request kind ") + job.request.kind);
+                    }
+                } catch (const std::exception& e) {
+                    status = ERROR;
+                    output = e.what();
+                    failed += 1;
+                }
+                written += output.size();
+                job.connection->respond(job.request.id, status, std::move(output));
+                auto elapsed = std::chrono::duration_cast< std::chrono::microseconds >(Clock::now() - job.received);
+                latencies.push_back(elapsed.count());
+            }
+
+            std::lock_guard< std::mutex > lock(mutex);
+            for (uint64_t micros : latencies) {
+                latency.record(micros);
+            }
+            latencies.clear();
+            errors += failed;
+            bytes_out += written;
+            batch.clear();
+        }
+    }
+
+    std::string stats() {
+        std::lock_guard< std::mutex > lock(mutex);
+        auto now = Clock::now();
+        double uptime = std::chrono::duration< double >(now - started).count();
+        double interval = std::chrono::duration< double >(now - last_stats).count();
+        uint64_t requests = latency.count();
+        std::ostringstream out;
+        out << "{\"uptime_s\":" << uptime << ",\"requests\":" << requests << ",\"errors\":" << errors
+            << ",\"qps\":" << requests / std::max(uptime, 1e-9)
+            << ",\"recent_qps\":" << (requests - last_requests) / std::max(interval, 1e-9)
+            << ",\"latency_us\":{\"p50\":" << latency.percentile(0.5) << ",\"p90\":" << latency.percentile(0.9)
+            << ",\"p99\":" << latency.percentile(0.99) << ",\"p999\":" << latency.percentile(0.999)
+            << ",\"max\":" << latency.max() << "},\"queue_depth\":" << queue.size()
+            << ",\"max_queue_depth\":" << max_depth << ",\"connections\":" << connections.size()
+            << ",\"dropped_connections\":" << dropped
+            << ",\"batches\":" << batches << ",\"bytes_in\":" << bytes_in << ",\"bytes_out\":" << bytes_out << "}";
+        last_stats = now;
+        last_requests = requests;
+        return out.str();
+    }
+
+    ServerOptions options;
+    int listen_fd = -1;
+
+    std::mutex mutex;
+    std::condition_variable queue_changed;
+    std::condition_variable readers_done;
+    std::deque< Job > queue;
+    std::set< Connection* > connections;
+
+    // Guarded by mutex
+    Clock::time_point started;
+    Clock::time_point last_stats;
+    uint64_t last_requests = 0;
+    LatencyHistogram latency;
+    uint64_t errors = 0;
+    uint64_t batches = 0;
+    uint64_t bytes_in = 0;
+    uint64_t bytes_out = 0;
+    uint64_t dropped = 0;
+    size_t max_depth = 0;
+    bool stopping;
+};
+
+int main(int argc, char const* argv[]) {
+    ServerOptions options;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--socket" && i + 1 < argc) {
+            options.socket_path = argv[++i];
+        } else if (arg == "--threads" && i + 1 < argc) {
+            options.threads = std::stoul(argv[++i]);
+        } else if (arg == "--batch" && i + 1 < argc) {
+            options.batch = std::max(1ul, std::stoul(argv[++i]));
+        } else if (arg == "--max-queue" && i + 1 < argc) {
+            options.max_queue = std::max(1ul, std::stoul(argv[++i]));
+        } else if (arg == "--max-outbox" && i + 1 < argc) {
+            options.max_outbox = std::stoul(argv[++i]);
+        } else if (arg == "--drain-timeout" && i + 1 < argc) {
+            options.drain_timeout = std::chrono::seconds(std::stoul(argv[++i]));
+        } else {
+            std::cerr << "Unknown argument " << arg << std::endl;
+            return 1;
+        }
+    }
+    if (options.socket_path.empty()) {
+        std::cout << "Usage: " << argv[0]
+                  << " --socket path [--threads n] [--batch n] [--max-queue n] [--max-outbox bytes]"
+                     " [--drain-timeout seconds]"
+                  << std::endl;
+        return 1;
+    }
+    std::signal(SIGINT, request_stop);
+    std::signal(SIGTERM, request_stop);
+    std::signal(SIGPIPE, SIG_IGN);
+    return Server(options).run();
+}
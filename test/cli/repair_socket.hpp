@@ -0,0 +1,178 @@
+#ifndef REPAIR_SOCKET_HPP
+#define REPAIR_SOCKET_HPP
+
+// Framing shared by json_repair_server and json_repair_load. Every request and response is a
+// 9-byte header, the payload length and a request id as big-endian u32 and a kind byte, followed
+// by the payload. Responses carry the id of their request, so requests can be pipelined and
+// answered out of order.
+
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstdint>
+#include <string>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <vector>
+
+namespace repair_socket {
+
+// Request kinds
+constexpr char REPAIR_JSON = 'J';
+constexpr char REPAIR_MSGPACK = 'M';
+constexpr char REPAIR_CBOR = 'C';
+constexpr char STATS = 'S';
+
+// Response kinds
+constexpr char OK = 'O';
+constexpr char ERROR = 'E';
+
+constexpr size_t HEADER_SIZE = 9;
+constexpr uint32_t MAX_PAYLOAD = 64u << 20;
+
+struct Frame {
+    uint32_t id = 0;
+    char kind = 0;
+    std::string payload;
+};
+
+inline bool read_full(int fd, char* data, size_t size) {
+    while (size > 0) {
+        ssize_t count = ::read(fd, data, size);
+        if (count < 0 && errno == EINTR) {
+            continue;
+        }
+        if (count <= 0) {
+            return false;
+        }
+        data += count;
+        size -= count;
+    }
+    return true;
+}
+
+inline bool write_full(int fd, const char* data, size_t size) {
+    while (size > 0) {
+        ssize_t count = ::send(fd, data, size, MSG_NOSIGNAL);
+        if (count < 0 && errno == EINTR) {
+            continue;
+        }
+        if (count <= 0) {
+            return false;
+        }
+        data += count;
+        size -= count;
+    }
+    return true;
+}
+
+inline void put_u32(char* data, uint32_t value) {
+    for (int i = 0; i < 4; ++i) {
+        data[i] = static_cast< char >(value >> (24 - 8 * i));
+    }
+}
+
+inline uint32_t get_u32(const char* data) {
+    uint32_t value = 0;
+    for (int i = 0; i < 4; ++i) {
+        value = value << 8 | static_cast< unsigned char >(data[i]);
+    }
+    return value;
+}
+
+// False at the end of the stream, on an error or a payload over MAX_PAYLOAD
+inline bool read_frame(int fd, Frame& frame) {
+    char header[HEADER_SIZE];
+    if (!read_full(fd, header, HEADER_SIZE)) {
+        return false;
+    }
+    uint32_t length = get_u32(header);
+    if (length > MAX_PAYLOAD) {
+        return false;
+    }
+    frame.id = get_u32(header + 4);
+    frame.kind = header[8];
+    frame.payload.resize(length);
+    return read_full(fd, &frame.payload[0], length);
+}
+
+inline void append_frame(std::string& data, uint32_t id, char kind, const std::string& payload) {
+    size_t start = data.size();
+    data.resize(start + HEADER_SIZE);
+    put_u32(&data[start], payload.size());
+    put_u32(&data[start + 4], id);
+    data[start + 8] = kind;
+    data += payload;
+}
+
+// Header and payload in one write, so that small frames are one segment
+inline bool write_frame(int fd, uint32_t id, char kind, const std::string& payload) {
+    std::string data;
+    append_frame(data, id, kind, payload);
+    return write_full(fd, data.data(), data.size());
+}
+
+// Latencies in microseconds, exact below 128 and within 1/64 above
+class LatencyHistogram {
+public:
+    LatencyHistogram() : counts(128 + 64 * 40), total(0), largest(0) {}
+
+    void record(uint64_t micros) {
+        counts[std::min(index(micros), counts.size() - 1)] += 1;
+        total += 1;
+        largest = std::max(largest, micros);
+    }
+
+    void merge(const LatencyHistogram& other) {
+        for (size_t i = 0; i < counts.size(); ++i) {
+            counts[i] += other.counts[i];
+        }
+        total += other.total;
+        largest = std::max(largest, other.largest);
+    }
+
+    // Upper bound of the bucket holding the fraction q of the samples
+    uint64_t percentile(double q) const {
+        if (total == 0) {
+            return 0;
+        }
+        uint64_t rank = std::max< uint64_t >(1, std::ceil(q * total));
+        uint64_t seen = 0;
+        for (size_t i = 0; i < counts.size(); ++i) {
+            seen += counts[i];
+            if (seen >= rank) {
+                return std::min(upper(i), largest);
+            }
+        }
+        return largest;
+    }
+
+    uint64_t count() const { return total; }
+    uint64_t max() const { return largest; }
+
+private:
+    static size_t index(uint64_t value) {
+        if (value < 128) {
+            return value;
+        }
+        int exponent = 63 - __builtin_clzll(value);
+        return 128 + (exponent - 7) * 64 + ((value >> (exponent - 6)) & 63);
+    }
+
+    static uint64_t upper(size_t i) {
+        if (i < 128) {
+            return i;
+        }
+        int exponent = (i - 128) / 64 + 7;
+        uint64_t sub = (i - 128) % 64;
+        return ((64 + sub + 1) << (exponent - 6)) - 1;
+    }
+
+    std::vector< uint64_t > counts;
+    uint64_t total;
+    uint64_t largest;
+};
+
+} // namespace repair_socket
+
+#endif
@@ -0,0 +1,53 @@
+#include "json_repair/json_cursor.hpp"
+#include "json_repair/json_parser.hpp"
+#include <iostream>
+#include <optional>
+#include <string>
+
+// JSONCursor navigation over malformed inputs, each value found must be the one parse() repairs
+
+int failures = 0;
+
+void expect(const std::string& input, const std::string& pointer, const std::string& expected) {
+    JSONParser parser(input);
+    std::optional< JSONCursor > cursor = JSONCursor(parser).at_pointer(pointer);
+    std::string found = cursor ? cursor->get().dump() : "nullopt";
+    if (found != expected) {
+        failures += 1;
+        std::cerr << "FAILED " << input << " at " << pointer << ": " << found << " instead of " << expected
+                  << std::endl;
+    }
+}
+
+int main() {
+    expect(R"({"a": {"b": [1, {"c": "x"}]}})", "/a/b/1/c", R"("x")");
+    expect(R"({"a~b": 1, "c/d": 2})", "/c~1d", "2.000000");
+    expect(R"({"a": 1})", "/b", "nullopt");
+    expect("[1, 2]", "/2", "nullopt");
+
+    // Strings with other delimiters hold the separators that end a scalar
+    expect(R"({'a': 'x,y', 'b': 1})", "/b", "1.000000");
+    expect(R"({"a": “x,y”, "b": 1})", "/b", "1.000000");
+    expect(R"({"a": ["x]", 'y}'], "b": 1})", "/b", "1.000000");
+    expect(R"({"a": "it's", "b": 'x'})", "/b", R"("x")");
+
+    // Missing commas, scalars end where parse_number or parse_string stop reading
+    expect("[1 2 3]", "/1", "2.000000");
+    expect(R"({"a": 1 "b": 2})", "/b", "2.000000");
+    expect(R"({"a": true "b": 2})", "/b", "2.000000");
+    expect(R"(["a" "b" "c"])", "/2", R"("c")");
+    expect(R"({"a": "x" "b": [1, 2] "c": 3})", "/c", "3.000000");
+    expect("[-1.5e3 7]", "/1", "7.000000");
+
+    // Unquoted strings still run to the separator, apostrophes included
+    expect(R"({"a": don't stop, "b": 1})", "/b", "1.000000");
+    expect(R"([hello world, 2])", "/1", "2.000000");
+
+    // An unclosed container ends with the input
+    expect(R"({"a": [1, 2, "b": 3)", "/b", "nullopt");
+
+    if (failures == 0) {
+        std::cout << "cursor_test passed" << std::endl;
+    }
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,112 @@
+#include "json_repair/decompressing_reader.hpp"
+#include "json_repair/json_parser.hpp"
+#include "json_repair/stream_repair.hpp"
+#include "json_repair/string_file_wrapper.hpp"
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <zlib.h>
+
+// Gzip input read through DecompressingReader against the same bytes read from a plain file
+
+int failures = 0;
+
+void check(bool condition, const std::string& what) {
+    if (!condition) {
+        failures += 1;
+        std::cerr << "FAILED " << what << std::endl;
+    }
+}
+
+void write_file(const std::string& path, const std::string& bytes) {
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file.write(bytes.data(), bytes.size());
+}
+
+// Every part is written as its own gzip member, as appending to a .gz file does
+void write_gzip(const std::string& path, const std::string& bytes, size_t parts) {
+    std::remove(path.c_str());
+    size_t part = bytes.size() / parts + 1;
+    for (size_t offset = 0; offset < bytes.size(); offset += part) {
+        gzFile file = gzopen(path.c_str(), "ab");
+        std::string piece = bytes.substr(offset, part);
+        gzwrite(file, piece.data(), static_cast< unsigned >(piece.size()));
+        gzclose(file);
+    }
+}
+
+std::string stream(StringFileWrapper& wrapper) {
+    JSONParser parser(wrapper);
+    std::ostringstream out;
+    OstreamSink sink(out);
+    StreamRepair(parser, sink).run();
+    return out.str();
+}
+
+int main() {
+    std::string jsonl;
+    for (int i = 0; i < 2000; ++i) {
+        jsonl += "{\"id\": " + std::to_string(i) + ", \"name\": 'item " + std::to_string(i) + "', \"tags\": [\"a\", \"b\",]";
+        jsonl += i % 5 ? "}\n" : "\n";
+    }
+    jsonl += "[1, 2, {\"unterminated\": \"tail";
+    write_file("decompress_test.jsonl", jsonl);
+    write_gzip("decompress_test.jsonl.gz", jsonl, 3);
+
+    check(detect_compression("decompress_test.jsonl.gz") == Compression::GZIP, "gzip magic");
+    check(detect_compression("decompress_test.jsonl") == Compression::NONE, "plain input");
+    {
+        DecompressingReader reader("decompress_test.jsonl.gz", 1000, 2);
+        std::string all;
+        std::string chunk;
+        while (reader.read(chunk)) {
+            check(chunk.size() == 1000 || all.size() + chunk.size() == jsonl.size(), "chunk length");
+            all += chunk;
+        }
+        check(all == jsonl, "decompressed bytes");
+        reader.rewind();
+        check(reader.read(chunk) && chunk == jsonl.substr(0, 1000), "rewind");
+    }
+
+    std::fstream plain("decompress_test.jsonl", std::ios::in | std::ios::binary);
+    StringFileWrapper plain_wrapper(plain, 256, 4);
+    std::string expected = stream(plain_wrapper);
+    for (size_t chunk_length : {16, 256, 1 << 20}) {
+        DecompressingReader reader("decompress_test.jsonl.gz", chunk_length);
+        StringFileWrapper wrapper(reader, 4);
+        check(stream(wrapper) == expected, "stream repair with chunks of " + std::to_string(chunk_length));
+    }
+    {
+        DecompressingReader reader("decompress_test.jsonl.gz", 64);
+        StringFileWrapper wrapper(reader, 2);
+        JSONParser parser(wrapper);
+        check(parser.parse() == JSONParser(jsonl).parse(), "parse of a decompressed input");
+    }
+
+    std::string compressed;
+    {
+        std::ifstream file("decompress_test.jsonl.gz", std::ios::binary);
+        compressed.assign(std::istreambuf_iterator< char >(file), std::istreambuf_iterator< char >());
+    }
+    write_file("decompress_test_truncated.gz", compressed.substr(0, compressed.size() - 20));
+    {
+        DecompressingReader reader("decompress_test_truncated.gz", 4096);
+        std::string chunk;
+        bool threw = false;
+        try {
+            while (reader.read(chunk)) {
+            }
+        } catch (const std::runtime_error&) {
+            threw = true;
+        }
+        check(threw, "truncated input throws");
+    }
+
+    if (failures) {
+        return 1;
+    }
+    std::cout << "all decompress tests passed" << std::endl;
+    return 0;
+}
@@ -0,0 +1,92 @@
+#include "json_repair/edit_script.hpp"
+#include "json_repair/json_parser.hpp"
+#include "json_repair/stream_repair.hpp"
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+// Edit scripts applied to the source give the streamed repair, in memory and through a file as
+// --edits and --patch apply them
+
+int failures = 0;
+
+void check(bool condition, const std::string& what) {
+    if (!condition) {
+        failures += 1;
+        std::cerr << "FAILED " << what << std::endl;
+    }
+}
+
+std::string stream(const std::string& input) {
+    JSONParser parser(input);
+    std::ostringstream out;
+    OstreamSink sink(out);
+    StreamRepair(parser, sink).run();
+    return out.str();
+}
+
+std::vector< JSONEdit > edits_of(const std::string& input) {
+    JSONParser parser(input);
+    return repair_edits(parser);
+}
+
+std::string read_file(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    std::stringstream buffer;
+    buffer << file.rdbuf();
+    return buffer.str();
+}
+
+// Single values, edit scripts keep the source layout and do not separate top-level values
+const char* inputs[] = {
+    R"({"a": true, "b": "true", "c": null, "d": [false, True, nul]})",
+    R"({b: 1, a: 2e3, c: -0.5})",
+    "```json\n{\"k\": [1, {\"n\": tru\n```",
+    "// comment\n{\"a\": \"x\" /* y */, \"b\": [1, 2\n",
+    R"({"key": "value" "other": tru)",
+    R"([{"id": 1}, {"id": 2, "name": "unterminated)",
+    R"({'single': 'quotes', "nested": {"list": [1, "two", {"three": 3}]}})",
+    R"({"text": "say \"hi\"\n", "esc": "é"})",
+    R"([1.5, -3, 4e2, .5, 1., -])",
+    R"({"a": [], "b": {}, "c": ""})",
+    "text before {\"a\": 1} text after",
+    "{\n    \"indented\": [\n        1,\n        2,\n    ],\n}\n",
+    R"({"a": 1, "b": 2)",
+    R"({"valid": ["json", 1, {"x": null}]})",
+};
+
+int main() {
+    const std::string path = "edit_test_input.json";
+    for (const char* input : inputs) {
+        std::vector< JSONEdit > edits = edits_of(input);
+        std::string patched = apply_edits(input, edits);
+        check(stream(patched) == stream(input), std::string(input) + ": patched to " + patched);
+        check(edits_of(patched).empty(), std::string(input) + ": the patched text needs no edits");
+
+        // Read through a StringFileWrapper in small chunks, as the CLI reads files
+        {
+            std::ofstream(path, std::ios::binary) << input;
+            std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+            StringFileWrapper wrapper(file, 16);
+            JSONParser parser(wrapper);
+            check(repair_edits(parser) == edits, std::string(input) + ": edits of the file");
+            std::ostringstream copy;
+            apply_edits(wrapper, copy, edits);
+            check(copy.str() == patched, std::string(input) + ": --patch through a copy");
+            if (apply_edits_in_place(wrapper, edits)) {
+                file.close();
+                check(read_file(path) == patched, std::string(input) + ": --patch in place");
+            }
+        }
+    }
+    std::remove(path.c_str());
+
+    check(edits_of(R"({"valid": ["json", 1, {"x": null}]})").empty(), "valid input has no edits");
+
+    if (failures == 0) {
+        std::cout << "edit_test passed" << std::endl;
+    }
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,133 @@
+#include "json_repair/json_parser.hpp"
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+// The iterative parser against the recursive one over generated malformed documents, and the
+// nesting limit of the iterative parser
+
+int failures = 0;
+
+void check(bool condition, const std::string& what) {
+    if (!condition) {
+        failures += 1;
+        std::cerr << "FAILED " << what << std::endl;
+    }
+}
+
+const std::vector< std::string > atoms = {
+    "\"a\"", "'b'", "abc", "true", "false", "null", "True", "None", "12", "-3.5", "1e5", "1,2", "\"x y\"",
+    "\"q\\\"q\"", "\"esc\\n\\t\"", "“smart”", "...", "\"", "'", "\"\"", "\"k\":", "key:", "#c\n", "// c\n",
+    "/* b */", "```json", "```", " ", "\n", ",", ",,", ":", "{", "}", "[", "]", "\"\\u0041\"", "12a", "-", ".5",
+    "n", "t"};
+
+template < typename T > const T& pick(std::mt19937& random, const std::vector< T >& choices) {
+    return choices[random() % choices.size()];
+}
+
+// A value of atoms, objects and arrays with missing, extra and mismatched punctuation
+std::string generate(std::mt19937& random, int depth) {
+    std::uniform_real_distribution< double > uniform(0, 1);
+    double r = uniform(random);
+    if (depth > 3 || r < 0.4) {
+        return pick(random, atoms);
+    }
+    std::string text;
+    size_t count = random() % 5;
+    if (r < 0.65) {
+        text = "{";
+        for (size_t i = 0; i < count; ++i) {
+            text += i ? pick(random, std::vector< std::string >{",", ", ", " ,"}) : "";
+            text += pick(random, std::vector< std::string >{"\"k0\"", "\"k1\"", "'s'", "bare", "\"dup\"", ""});
+            text += pick(random, std::vector< std::string >{":", ": ", " ", "::", ""});
+            text += generate(random, depth + 1);
+        }
+        return text + pick(random, std::vector< std::string >{"}", "}", "}", "", "]"});
+    }
+    text = "[";
+    for (size_t i = 0; i < count; ++i) {
+        text += i ? pick(random, std::vector< std::string >{",", ", ", " ", ",,"}) : "";
+        text += generate(random, depth + 1);
+    }
+    return text + pick(random, std::vector< std::string >{"]", "]", "]", "", "}"});
+}
+
+// The repaired text, or what was thrown
+std::string repair(const std::string& input, bool iterative, size_t max_depth = JSONParser::DEFAULT_MAX_DEPTH) {
+    try {
+        JSONParser parser(input);
+        parser.iterative = iterative;
+        parser.max_depth = max_depth;
+        return parser.parse().dump();
+    } catch (const std::exception& e) {
+        return std::string("threw ") + e.what();
+    }
+}
+
+void expect_same(const std::string& input) {
+    std::string iterative = repair(input, true);
+    std::string recursive = repair(input, false);
+    check(iterative == recursive, input + ": " + iterative + " iterative, " + recursive + " recursive");
+}
+
+// Arrays and objects in turn, closed or not
+std::string nested(size_t depth, const std::string& inner, bool closed = true) {
+    std::string text;
+    for (size_t i = 0; i < depth; ++i) {
+        text += i % 2 ? "{\"k\": " : "[";
+    }
+    text += inner;
+    for (size_t i = depth; closed && i-- > 0;) {
+        text += i % 2 ? "}" : "]";
+    }
+    return text;
+}
+
+// The first value that is not a container, and how deep it is
+JSONReturnType& innermost(JSONReturnType& value, size_t& depth) {
+    JSONReturnType* current = &value;
+    depth = 0;
+    while (current->is< JSONReturnType::MapType >() || current->is< JSONReturnType::VectorType >()) {
+        depth += 1;
+        current = current->is< JSONReturnType::MapType >() ? &(*current)["k"] : &(*current)[0];
+    }
+    return *current;
+}
+
+int main() {
+    std::mt19937 random(31);
+    for (int document = 0; document < 3000; ++document) {
+        std::string input;
+        for (size_t part = random() % 3 + 1; part > 0; --part) {
+            input += pick(random, std::vector< std::string >{"", "text ", "```json\n", "\n"});
+            input += generate(random, 0);
+            input += pick(random, std::vector< std::string >{"", " ", "\n```", " trailing"});
+        }
+        // Truncated inputs
+        if (random() % 5 == 0 && input.size() > 2) {
+            input.resize(1 + random() % (input.size() - 1));
+        }
+        expect_same(input);
+    }
+
+    // Nesting up to max_depth is parsed alike, deeper containers are kept as their source text
+    size_t max_depth = JSONParser::DEFAULT_MAX_DEPTH;
+    expect_same(nested(max_depth, "1"));
+    expect_same(nested(max_depth - 1, "[1, 'x'"));
+    JSONReturnType value = JSONParser(nested(max_depth + 1, "1")).parse();
+    size_t depth;
+    check(innermost(value, depth) == JSONReturnType(std::string("[1]")) && depth == max_depth,
+          "the container past max_depth is kept as text");
+    check(repair(nested(6, "1"), true, 4) == R"([{"k":[{"k":"[{\"k\": 1}]"}]}])", "a lower max_depth");
+
+    // Unclosed nesting far deeper than a thread stack could recurse
+    value = JSONParser(nested(1000000, "1", false)).parse();
+    check(innermost(value, depth).is< JSONReturnType::StringType >() && depth == max_depth,
+          "unclosed nesting is cut at max_depth, not " + std::to_string(depth));
+
+    if (failures == 0) {
+        std::cout << "engines_test passed" << std::endl;
+    }
+    return failures == 0 ? 0 : 1;
+}
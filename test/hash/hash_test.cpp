@@ -0,0 +1,71 @@
+#include "json_repair/json_parser.hpp"
+#include <iostream>
+#include <string>
+
+// Structural hashes of parsed and built values, and the dedup of consecutive top-level values
+
+int failures = 0;
+
+void check(bool condition, const std::string& what) {
+    if (!condition) {
+        failures += 1;
+        std::cerr << "FAILED " << what << std::endl;
+    }
+}
+
+JSONReturnType parse(const std::string& input) {
+    return JSONParser(input).parse();
+}
+
+void expect_dump(const std::string& input, const std::string& expected) {
+    std::string found = parse(input).dump();
+    check(found == expected, input + ": " + found + " instead of " + expected);
+}
+
+int main() {
+    // Equal values hash alike however they were built
+    JSONReturnType built;
+    built["b"] = JSONReturnType::VectorType{JSONReturnType(1.0), JSONReturnType(std::string("x"))};
+    built["a"] = std::string("s");
+    JSONReturnType parsed = parse(R"({"a": 's', "b": [1, "x"]})");
+    check(parsed == built && parsed.hash() == built.hash(), "parsed and built objects");
+    JSONReturnType packed = parse("[1, 2.5, -3]");
+    JSONReturnType unpacked = parse(R"([1, 2.5, -3, "x"])");
+    unpacked.get< JSONReturnType::VectorType >().pop_back();
+    check(packed.is< JSONReturnType::PackedType >() && !unpacked.is< JSONReturnType::PackedType >(), "packing");
+    check(packed == unpacked && packed.hash() == unpacked.hash(), "packed and unpacked arrays");
+    check(parse("0").hash() == parse("-0").hash(), "0.0 and -0.0");
+    check(parse(R"({"a": 1})").hash() != parse(R"({"a": 2})").hash(), "different values");
+    check(parse(R"(["a"])").hash() != parse(R"("a")").hash(), "array and string");
+
+    // A modified value hashes like a value parsed with the new contents
+    JSONReturnType modified = parse(R"({"a": {"b": 1}, "c": [1]})");
+    size_t before = modified.hash();
+    modified["a"]["b"] = 2.0;
+    check(modified.hash() != before && modified.hash() == parse(R"({"a": {"b": 2}, "c": [1]})").hash(),
+          "nested modification");
+    modified["c"][0] = std::string("y");
+    check(modified == parse(R"({"a": {"b": 2}, "c": ["y"]})") &&
+              modified.hash() == parse(R"({"a": {"b": 2}, "c": ["y"]})").hash(),
+          "modified packed array");
+
+    // Equality does not trust the hash cached before a child was modified through a reference
+    JSONReturnType v = parse(R"({"a": {"b": 1}})");
+    auto& inner = v["a"];
+    v.hash();
+    inner["b"] = JSONReturnType(2.0);
+    JSONReturnType w = parse(R"({"a": {"b": 2}})");
+    check(v == w && w == v, "modified through a kept reference");
+
+    // Consecutive equal top-level values are kept once
+    expect_dump(R"({"a": 1} {"a": 1})", R"({"a":1.000000})");
+    expect_dump(R"({"a": 1} {"a": 2})", R"([{"a":1.000000},{"a":2.000000}])");
+    expect_dump("[1, 2] [1, 2]", "[1.000000,2.000000]");
+    expect_dump(R"({"a": 1}{"a": 1}{"a": 2}{"a": 2})", R"([{"a":1.000000},{"a":2.000000}])");
+    expect_dump(R"({"a": 1} [1] {"a": 1})", R"([{"a":1.000000},[1.000000],{"a":1.000000}])");
+
+    if (failures == 0) {
+        std::cout << "hash_test passed" << std::endl;
+    }
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,94 @@
+#include "json_repair/json_parser.hpp"
+#include "json_repair/projection.hpp"
+#include <iostream>
+#include <memory>
+#include <string>
+
+// ParseLimits stop the parse functions and the scans that look ahead of them
+
+int failures = 0;
+
+void check(bool condition, const std::string& what) {
+    if (!condition) {
+        failures += 1;
+        std::cerr << "FAILED " << what << std::endl;
+    }
+}
+
+const size_t MAX_BYTES = 10000;
+const std::string spaces(1 << 20, ' ');
+const std::string letters(1 << 20, 'x');
+
+ParseLimits byte_limit() {
+    ParseLimits limits;
+    limits.max_bytes = MAX_BYTES;
+    return limits;
+}
+
+// A scan from the start of input stops within the byte limit
+template < typename Scan > void expect_scan_stops(const std::string& name, const std::string& input, Scan scan) {
+    JSONParser parser(input);
+    parser.set_limits(byte_limit());
+    size_t end = scan(parser);
+    check(end <= MAX_BYTES && parser.limit_exceeded == LimitExceeded::BYTES,
+          name + " scanned " + std::to_string(end) + " bytes");
+}
+
+// The parse stops within the byte limit, where the parse functions were when it was reached
+void expect_parse_stops(const std::string& name,
+                        const std::string& input,
+                        std::shared_ptr< const Projection > projection = nullptr) {
+    for (bool iterative : {true, false}) {
+        JSONParser parser(input, false, 0, false, projection);
+        parser.iterative = iterative;
+        parser.set_limits(byte_limit());
+        LimitedParse result = parser.parse_with_limits();
+        check(result.exceeded == LimitExceeded::BYTES && result.index <= MAX_BYTES,
+              name + (iterative ? " iterative" : " recursive") + " stopped at " + std::to_string(result.index));
+    }
+}
+
+int main() {
+    expect_scan_stops("skip_whitespaces", spaces + "1", [](JSONParser& parser) {
+        parser.skip_whitespaces();
+        return parser.index;
+    });
+    expect_scan_stops("scroll_whitespaces", spaces + "1", [](JSONParser& parser) {
+        return parser.scroll_whitespaces(0);
+    });
+    expect_scan_stops("skip_to_character", letters + "\"", [](JSONParser& parser) {
+        return parser.skip_to_character('"', 0);
+    });
+    expect_scan_stops("skip_to_character of several", letters + "}", [](JSONParser& parser) {
+        return parser.skip_to_character(std::vector< char >{'}', ']'}, 0);
+    });
+    expect_scan_stops("skip_value of a string", "\"" + letters + "\"", [](JSONParser& parser) {
+        return parser.skip_value();
+    });
+    expect_scan_stops("skip_value of an array", "[" + spaces + "]", [](JSONParser& parser) {
+        return parser.skip_value();
+    });
+
+    expect_parse_stops("spaces in an array", "[" + spaces + "1]");
+    expect_parse_stops("spaces before a value", "{\"a\":" + spaces + "1}");
+    expect_parse_stops("unclosed string", "{\"a\": \"" + letters);
+    expect_parse_stops("skipped value", "{\"a\": [\"" + letters + "\"], \"b\": 1}",
+                       std::make_shared< const Projection >(std::vector< std::string >{"/b"}));
+
+    // A deadline already past stops the parse at the first read
+    JSONParser parser("[" + spaces + "1]");
+    ParseLimits limits;
+    limits.deadline = std::chrono::steady_clock::now();
+    parser.set_limits(limits);
+    LimitedParse result = parser.parse_with_limits();
+    check(result.exceeded == LimitExceeded::DEADLINE && result.index <= 1, "deadline");
+
+    // Without limits the scans read everything
+    JSONParser unlimited("[" + spaces + "1]");
+    check(unlimited.parse().dump() == "[1.000000]", "unlimited parse");
+
+    if (failures == 0) {
+        std::cout << "limits_test passed" << std::endl;
+    }
+    return failures == 0 ? 0 : 1;
+}
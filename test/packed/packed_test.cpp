@@ -0,0 +1,84 @@
+#include "json_repair/json_parser.hpp"
+#include <iostream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Packed arrays read like ordinary arrays, const access leaves them packed
+
+int failures = 0;
+
+void check(bool condition, const std::string& what) {
+    if (!condition) {
+        failures += 1;
+        std::cerr << "FAILED " << what << std::endl;
+    }
+}
+
+int main() {
+    JSONParser parser(R"({"embedding": [0.5, -1, 2e3, 4]})");
+    JSONReturnType value = parser.parse();
+    const JSONReturnType& embedding = value["embedding"];
+    check(embedding.is< JSONReturnType::PackedType >(), "numbers are packed");
+    check(embedding.is< JSONReturnType::VectorType >(), "a packed array is a VectorType for is<>()");
+
+    const JSONReturnType& read = embedding;
+    check(read[0] == 0.5 && read[1] == -1.0 && read[2] == 2000.0 && read[3] == 4.0, "const operator[]");
+    check(read[2].is< JSONReturnType::DoubleType >(), "elements are doubles");
+    check(read.as_span< double >().size() == 4, "as_span");
+
+    // The const get<>() reads an ordinary array, operator[] refers to its elements
+    const auto& vec = read.get< JSONReturnType::VectorType >();
+    check(vec.size() == 4 && vec[2] == 2000.0 && vec == embedding.get< JSONReturnType::VectorType >(),
+          "const get<VectorType>()");
+    check(&read[3] == &vec[3] && &read[3] == &read[3], "const operator[] returns a reference");
+    check(read.is< JSONReturnType::PackedType >(), "const reads do not unpack");
+
+    // The array read is built once, whichever thread reads first
+    const JSONReturnType shared = JSONParser("[1, 2, 3, 4, 5, 6, 7, 8]").parse();
+    std::vector< const JSONReturnType::VectorType* > seen(4);
+    std::vector< std::thread > readers;
+    for (size_t t = 0; t < seen.size(); ++t) {
+        readers.emplace_back([&shared, &seen, t]() { seen[t] = &shared.get< JSONReturnType::VectorType >(); });
+    }
+    for (auto& reader : readers) {
+        reader.join();
+    }
+    check(seen[0] == seen[1] && seen[1] == seen[2] && seen[2] == seen[3] && seen[0]->at(7) == 8.0,
+          "concurrent const reads");
+
+    bool thrown = false;
+    try {
+        read[4];
+    } catch (const std::out_of_range&) {
+        thrown = true;
+    }
+    check(thrown, "const operator[] past the end");
+
+    // Equal to and hashed like the unpacked array of the same numbers
+    JSONReturnType unpacked = JSONParser(R"({"embedding": [0.5, -1, 2e3, "x"]})").parse()["embedding"];
+    unpacked[3] = 4.0;
+    check(!unpacked.is< JSONReturnType::PackedType >() && unpacked == read, "packed equals unpacked");
+    check(unpacked.hash() == read.hash(), "packed hashes like unpacked");
+
+    // Non-const access unpacks
+    JSONReturnType copy = read;
+    copy[1] = std::string("y");
+    check(!copy.is< JSONReturnType::PackedType >() && copy.get< JSONReturnType::VectorType >().size() == 4 &&
+              copy[1] == std::string("y") && copy[0] == 0.5,
+          "non-const operator[] unpacks");
+    check(read.is< JSONReturnType::PackedType >() && read[1] == -1.0, "the copy was unpacked, not the original");
+
+    // Appending to the numbers drops the array read before
+    JSONReturnType grown = JSONParser("[1, 2]").parse();
+    check(std::as_const(grown).get< JSONReturnType::VectorType >().size() == 2, "read before appending");
+    grown.get< JSONReturnType::PackedType >().push_back(3);
+    check(std::as_const(grown).get< JSONReturnType::VectorType >().size() == 3 && std::as_const(grown)[2] == 3.0,
+          "read after appending");
+
+    if (failures == 0) {
+        std::cout << "packed_test passed" << std::endl;
+    }
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,108 @@
+#include "json_repair/json_parser.hpp"
+#include "json_repair/parallel_repair.hpp"
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Wall time of parse_parallel against parse() on one large top-level array, read from a file or
+// generated with every --broken-th record malformed. The best of the runs is reported for each
+// thread count, with a check that the value is the one parse() returns.
+
+std::string generate(size_t records, size_t broken) {
+    std::string text = "[\n";
+    for (size_t i = 0; i < records; ++i) {
+        std::string id = std::to_string(i);
+        if (broken && i % broken == broken - 1) {
+            // Single quotes, a missing comma and an unquoted key
+            text += "  {'id': " + id + ", 'name': 'record " + id + "' tags: [\"a\", \"b\"], \"score\": 1.5}";
+        } else {
+            text += "  {\"id\": " + id + ", \"name\": \"record " + id +
+                    "\", \"tags\": [\"a\", \"b\"], \"score\": 1.5, \"note\": \"x, y]\"}";
+        }
+        text += i + 1 < records ? ",\n" : "\n";
+    }
+    return text + "]\n";
+}
+
+template < typename Parse > double best_seconds(int runs, Parse parse) {
+    double best = 1e30;
+    for (int run = 0; run < runs; ++run) {
+        auto start = std::chrono::steady_clock::now();
+        parse();
+        best = std::min(best, std::chrono::duration< double >(std::chrono::steady_clock::now() - start).count());
+    }
+    return best;
+}
+
+int main(int argc, char const* argv[]) {
+    int runs = 5;
+    size_t records = 200000;
+    size_t broken = 100;
+    ParallelOptions options;
+    std::vector< unsigned > thread_counts;
+    std::string path;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--runs" && i + 1 < argc) {
+            runs = std::max(1, std::stoi(argv[++i]));
+        } else if (arg == "--records" && i + 1 < argc) {
+            records = std::stoul(argv[++i]);
+        } else if (arg == "--broken" && i + 1 < argc) {
+            broken = std::stoul(argv[++i]);
+        } else if (arg == "--segment-bytes" && i + 1 < argc) {
+            options.segment_bytes = std::stoul(argv[++i]);
+        } else if (arg == "--threads" && i + 1 < argc) {
+            std::stringstream list(argv[++i]);
+            for (std::string count; std::getline(list, count, ',');) {
+                thread_counts.push_back(std::max(1, std::stoi(count)));
+            }
+        } else if (arg.rfind("--", 0) != 0) {
+            path = arg;
+        } else {
+            std::cout << "Usage: " << argv[0]
+                      << " [--runs n] [--records n] [--broken n] [--segment-bytes n] [--threads 1,2,4] [file]"
+                      << std::endl;
+            return 1;
+        }
+    }
+    std::string text;
+    if (path.empty()) {
+        text = generate(records, broken);
+    } else {
+        std::ifstream file(path, std::ios::binary);
+        std::stringstream buffer;
+        buffer << file.rdbuf();
+        text = buffer.str();
+    }
+    if (thread_counts.empty()) {
+        unsigned cores = std::max(1u, std::thread::hardware_concurrency());
+        for (unsigned count = 1; count < cores; count *= 2) {
+            thread_counts.push_back(count);
+        }
+        thread_counts.push_back(cores);
+    }
+
+    JSONReturnType expected = JSONParser(text).parse();
+    double sequential = best_seconds(runs, [&]() { JSONParser(text).parse(); });
+    std::cout << text.size() / 1e6 << " MB, " << std::thread::hardware_concurrency() << " cores, best of " << runs
+              << " runs" << std::endl;
+    std::cout << "parse(): " << sequential * 1e3 << " ms, " << text.size() / 1e6 / sequential << " MB/s" << std::endl;
+    bool same = true;
+    for (unsigned count : thread_counts) {
+        options.threads = count;
+        same = same && parse_parallel(text, options) == expected;
+        double parallel = best_seconds(runs, [&]() { parse_parallel(text, options); });
+        std::cout << "parse_parallel, " << count << " threads: " << parallel * 1e3 << " ms, "
+                  << text.size() / 1e6 / parallel << " MB/s, speedup " << sequential / parallel << std::endl;
+    }
+    if (!same) {
+        std::cout << "parse_parallel returned another value than parse()" << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,107 @@
+#include "json_repair/json_parser.hpp"
+#include "json_repair/parallel_repair.hpp"
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+// parse_parallel against the sequential parse, cutting at every top-level comma or every few bytes,
+// on fixed inputs whose repairs cross segment boundaries and on generated malformed containers
+
+int failures = 0;
+
+std::string repair(const std::string& input, bool parallel, size_t segment_bytes = 0) {
+    try {
+        if (!parallel) {
+            return JSONParser(input).parse().dump();
+        }
+        ParallelOptions options;
+        options.threads = 4;
+        options.segment_bytes = segment_bytes;
+        return parse_parallel(input, options).dump();
+    } catch (const std::exception& e) {
+        return std::string("exception: ") + e.what();
+    }
+}
+
+void check(const std::string& input) {
+    std::string expected = repair(input, false);
+    for (size_t segment_bytes : {0, 7, 40}) {
+        std::string found = repair(input, true, segment_bytes);
+        if (found != expected) {
+            failures += 1;
+            std::cerr << "FAILED " << input << " cut every " << segment_bytes << " bytes: " << found << " instead of "
+                      << expected << std::endl;
+            return;
+        }
+    }
+}
+
+const char* inputs[] = {
+    R"([{"id": 1, "tags": ["a", "b"]}, {"id": 2, "tags": []}, {"id": 3, "note": "x, y]"}])",
+    R"({"a": 1, "b": [1, 2], "a": {"c": null}, "d": "e"})",
+    "[1, 2, 3, 4.5, -6e-2]",
+    // Truncated export
+    R"([{"id": 1}, {"id": 2}, {"id": 3, "name": "unterminated)",
+    R"([{"id": 1}, {"id": 2 "name": 'x'}, {"id": 3}, [ ], {"k": "v", "k": "w"}, 1e+5])",
+    R"({"a": 1, "b": 2,, "c": 3} trailing)",
+    "  [true, false, null, \"\\u00e9\", {}, []]\n",
+    // A string left open in the middle takes in the members after it
+    R"([{"id": 1}, {"id": "open}, {"id": 3}, {"id": 4}, {"id": 5}])",
+    R"({"a": "open, "b": 2, "c": 3, "d": 4})",
+    // Single quoted strings with commas the structural scan cuts at
+    R"([{'n': 'a, "b'}, {'n': "c"}, {'n': 'd, e'}, 7])",
+    // A duplicate key closes the object and the next member reads the key again
+    R"([{"k": 1, "k": 2}, {"k": 3}, {"a": 1, "b": 2, "a": 3, "c": 4}, 5])",
+    // Numbers read by the packed scan across segments, then something else
+    "[1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12]",
+    "[1, 2, 3, 4, 5, 6, \"x\", 7, 8, 9]",
+    "[1, 2, 3, 4, 5, 6, 7, x, 8, 9]",
+    "[1, 2, 3, 4, 5, 6, 7, 8",
+    "[1, 2, 3, 4, 5, 6, 7, 8, ]",
+    // The array ends early, at a brace, or at the end of the input
+    R"([{"a": 1}, {"b": 2}], {"c": 3}, {"d": 4}])",
+    R"([{"a": 1}, {"b": 2}}, {"c": 3}])",
+    R"([{"a": 1}, {"b": 2}, )",
+    // An object with no members is parsed again as an array
+    R"({  , , "x" })",
+    R"([{"a": [1, 2, {"b": "c, d"}]}, {"e": {"f": [3, 4]}}, {"g": "h"}])",
+};
+
+const std::vector< std::string > atoms = {
+    "{\"id\": 1, \"n\": \"x\"}", "{'id': 2, name: 'y'}", "[1, 2, 3]", "\"str\"", "\"open", "1", "-2.5", "true",
+    "null", "{\"a\": [1, {\"b\": \"c, d\"}]}", "{\"k\": 1, \"k\": 2}", "{}", "[]", " , ", "...", "{\"a\" 1}",
+    "{\"x\": \"y\" \"z\": 3}", "// c\n", "1e+5", "\"a\": 1", "]", "}", "[", "{", "'q", "\"q\\\"q\"", "  "};
+
+// A top-level array or object of atoms, with keys in objects and missing or extra punctuation
+std::string generate(std::mt19937& random) {
+    bool object = random() % 2;
+    std::string text = object ? "{" : "[";
+    size_t count = 1 + random() % 12;
+    for (size_t i = 0; i < count; ++i) {
+        text += i ? (random() % 5 ? ", " : ",") : "";
+        if (object && random() % 4) {
+            text += "\"k" + std::to_string(random() % 5) + "\": ";
+        }
+        text += random() % 3 ? atoms[random() % atoms.size()] : std::to_string(random() % 100);
+    }
+    if (random() % 3) {
+        text += object ? "}" : "]";
+    }
+    return text;
+}
+
+int main() {
+    for (const char* input : inputs) {
+        check(input);
+    }
+    std::mt19937 random(40);
+    for (int i = 0; i < 3000; ++i) {
+        check(generate(random));
+    }
+    if (failures) {
+        return 1;
+    }
+    std::cout << "all parallel tests passed" << std::endl;
+    return 0;
+}
@@ -0,0 +1,100 @@
+#include "json_repair/parser_pool.hpp"
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Parsers returned to the pool of the thread that releases them, with their buffers and the
+// default options. Each case runs on a new thread, whose pool starts empty.
+
+int failures = 0;
+
+void check(bool condition, const std::string& what) {
+    if (!condition) {
+        failures += 1;
+        std::cerr << "FAILED " << what << std::endl;
+    }
+}
+
+const std::string long_string = "[\"" + std::string(4096, 'x') + "\"]";
+
+// Whether the parser repaired long_string before, its string buffer kept the capacity
+bool reused(const ParserPool::Lease& lease) {
+    return lease->scratch.capacity() >= 4096;
+}
+
+ParserPool::Lease used_parser() {
+    ParserPool::Lease lease = ParserPool::acquire(long_string);
+    lease->parse();
+    return lease;
+}
+
+template < typename Function > void on_new_thread(Function function) {
+    std::thread(function).join();
+}
+
+int main() {
+    on_new_thread([]() {
+        { used_parser(); }
+        ParserPool::Lease lease = ParserPool::acquire("{'a': 1");
+        check(reused(lease), "a released parser is acquired again");
+        check(lease->parse().dump() == R"({"a":1.000000})", "a reused parser repairs its new input");
+    });
+
+    on_new_thread([]() {
+        {
+            ParserPool::Lease lease = used_parser();
+            lease->iterative = false;
+            lease->max_depth = 3;
+            lease->stream_stable = true;
+            lease->utf8_policy = Utf8Policy::REPLACE;
+            ParseLimits limits;
+            limits.max_nodes = 1;
+            lease->set_limits(limits);
+        }
+        ParserPool::Lease lease = ParserPool::acquire("[[[[[1, 2]]]]]");
+        check(reused(lease) && lease->iterative && lease->max_depth == JSONParser::DEFAULT_MAX_DEPTH &&
+                  !lease->stream_stable && lease->utf8_policy == Utf8Policy::KEEP && !lease->has_limits(),
+              "a reused parser has the default options");
+        check(lease->parse().dump() == "[[[[[1.000000,2.000000]]]]]", "parse with the default options");
+    });
+
+    on_new_thread([]() {
+        ParserPool::Lease lease = used_parser();
+        lease = ParserPool::acquire("[2]");
+        check(!reused(lease), "the assigned lease holds the new parser");
+        ParserPool::Lease next = ParserPool::acquire("[3]");
+        check(reused(next), "move assignment returns the parser it held to the pool");
+    });
+
+    // A lease moved to another thread is released into the pool of that thread
+    on_new_thread([]() {
+        ParserPool::Lease lease = used_parser();
+        on_new_thread([&lease]() {
+            { ParserPool::Lease moved = std::move(lease); }
+            check(reused(ParserPool::acquire("[]")), "released into the pool of the destroying thread");
+        });
+        check(!reused(ParserPool::acquire("[]")), "not into the pool of the acquiring thread");
+    });
+
+    on_new_thread([]() {
+        {
+            std::vector< ParserPool::Lease > leases;
+            for (size_t i = 0; i < ParserPool::MAX_IDLE + 2; ++i) {
+                leases.push_back(used_parser());
+            }
+        }
+        std::vector< ParserPool::Lease > leases;
+        size_t count = 0;
+        for (size_t i = 0; i < ParserPool::MAX_IDLE + 2; ++i) {
+            leases.push_back(ParserPool::acquire("[]"));
+            count += reused(leases.back());
+        }
+        check(count == ParserPool::MAX_IDLE, "at most MAX_IDLE parsers are kept, not " + std::to_string(count));
+    });
+
+    if (failures == 0) {
+        std::cout << "pool_test passed" << std::endl;
+    }
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,78 @@
+#include "json_repair/json_parser.hpp"
+#include "json_repair/projection.hpp"
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+// A projected parse must equal the full parse with the unselected members and elements removed,
+// with both parse engines
+
+int failures = 0;
+
+JSONReturnType filter(const JSONReturnType& value, const Projection& projection, Projection::Path& path) {
+    if (value.is< JSONReturnType::MapType >()) {
+        JSONReturnType::MapType kept;
+        for (const auto& [key, item] : value.get< JSONReturnType::MapType >()) {
+            path.push_back(key);
+            if (projection.keep(path)) {
+                kept.emplace(key, filter(item, projection, path));
+            }
+            path.pop_back();
+        }
+        return kept;
+    }
+    if (value.is< JSONReturnType::VectorType >()) {
+        JSONReturnType::VectorType kept;
+        const auto& items = value.get< JSONReturnType::VectorType >();
+        for (size_t i = 0; i < items.size(); ++i) {
+            path.push_back(std::to_string(i));
+            if (projection.keep(path)) {
+                kept.push_back(filter(items[i], projection, path));
+            }
+            path.pop_back();
+        }
+        return kept;
+    }
+    return value;
+}
+
+void expect(const std::string& input, const std::vector< std::string >& pointers) {
+    auto projection = std::make_shared< const Projection >(pointers);
+    Projection::Path path;
+    JSONReturnType expected = filter(JSONParser(input).parse(), *projection, path);
+    for (bool iterative : {true, false}) {
+        JSONParser parser(input, false, 0, false, projection);
+        parser.iterative = iterative;
+        JSONReturnType found = parser.parse();
+        if (found != expected) {
+            failures += 1;
+            std::cerr << "FAILED " << input << (iterative ? " iterative: " : " recursive: ") << found.dump()
+                      << " instead of " << expected.dump() << std::endl;
+        }
+    }
+}
+
+int main() {
+    expect(R"({"records": [{"id": 1, "name": "a"}, {"id": 2, "tags": ["x", "y"]}], "total": 2})",
+           {"/records/*/id"});
+    expect(R"({"a": {"b": 1, "c": [1, 2]}, "d": "x"})", {"/a/c", "/d"});
+    expect(R"({"embedding": [0.5, 1.5, 2.5], "id": 3})", {"/embedding/1"});
+    expect(R"([{"keep": 1, "drop": [1, {"x": "]"}]}, {"keep": 2}])", {"/*/keep"});
+
+    // Skipped values with other string delimiters or without commas
+    expect(R"({'a': 'x,y', 'b': 1})", {"/b"});
+    expect(R"({"a": “x,y”, "b": 1})", {"/b"});
+    expect(R"({"a": ['x]', "y"], "b": 1})", {"/b"});
+    expect(R"({"a": 1 "b": 2 "c": 3})", {"/b"});
+    expect(R"({"a": true "b": "x" "c": [1 2 3]})", {"/c"});
+    expect(R"({"a": "x" "b": {"c": 'd}'} "e": 5})", {"/e", "/b"});
+    expect(R"([["a" "b"] ["c" "d"] ["e"]])", {"/1", "/2/0"});
+    expect(R"({"list": ["a" "b" "c"]})", {"/list/1"});
+    expect(R"({"a": don't, "b": 2})", {"/b"});
+
+    if (failures == 0) {
+        std::cout << "projection_test passed" << std::endl;
+    }
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,84 @@
+"""
+Checks that the entry points of the json_repair_cpp extension agree with each other: loads with
+repair_json, str with bytes and buffer inputs, repair_batch with single calls, and threads.
+Usage:  PYTHONPATH=<build dir> python test/python/python_test.py
+"""
+
+import json
+import sys
+import threading
+
+import json_repair_cpp
+
+INPUTS = [
+    '{"a": 1, "b": [1, 2, 3], "c": \'x\'}',
+    '[{"id": 1}, {"id": 2, "name": "unterminated',
+    "[1.5, 2.5, -3.25, 4e2]",
+    '{"key": "value" "other": tru',
+    '{"text": "caf\\u00e9", "emoji": "\U0001F600"}',
+    "[true, false, null, -7]",
+]
+
+failures = 0
+
+
+def check(condition: bool, what: str) -> None:
+    global failures
+    if not condition:
+        failures += 1
+        print(f"FAILED {what}", file=sys.stderr)
+
+
+for text in INPUTS:
+    repaired = json_repair_cpp.repair_json(text)
+    value = json_repair_cpp.loads(text)
+    check(json.loads(repaired) == value, f"loads and repair_json agree on {text!r}")
+    check(json_repair_cpp.loads(text.encode()) == value, f"bytes input of {text!r}")
+    check(json_repair_cpp.loads(memoryview(bytearray(text.encode()))) == value, f"buffer input of {text!r}")
+
+check(json_repair_cpp.loads("[2.5, \"x\", {\"k\": [\"v\"]}]") == [2.5, "x", {"k": ["v"]}], "python types")
+check(json_repair_cpp.repair_batch(INPUTS) == [json_repair_cpp.repair_json(text) for text in INPUTS], "batch texts")
+check(json_repair_cpp.repair_batch(INPUTS, return_objects=True) == [json_repair_cpp.loads(text) for text in INPUTS],
+      "batch values")
+
+try:
+    json_repair_cpp.loads(42)
+    check(False, "non-buffer input raises")
+except TypeError:
+    pass
+
+# Parsing releases the GIL, so threads repair at the same time
+results = []
+
+
+def work() -> None:
+    results.append(json_repair_cpp.repair_batch(INPUTS * 200))
+
+
+threads = [threading.Thread(target=work) for _ in range(4)]
+for thread in threads:
+    thread.start()
+for thread in threads:
+    thread.join()
+check(all(result == results[0] for result in results), "threads agree")
+
+# Items replaced in the list while a batch parses them without the GIL stay alive until it is done
+big = [f'{{"n": {i}, "text": "{"x" * (1 << 18)}"' for i in range(16)]
+expected = [json_repair_cpp.repair_json(text) for text in big]
+shared = list(big)
+del big
+batch_results = []
+batch = threading.Thread(target=lambda: batch_results.append(json_repair_cpp.repair_batch(shared)))
+batch.start()
+while batch.is_alive():
+    for i in range(len(shared)):
+        shared[i] = "[]"
+batch.join()
+# Each item is repaired as it was when the batch started
+empty = json_repair_cpp.repair_json("[]")
+check(len(batch_results) == 1 and all(result in (text, empty) for result, text in zip(batch_results[0], expected)),
+      "items replaced during a batch")
+
+if failures:
+    sys.exit(1)
+print("all python tests passed")
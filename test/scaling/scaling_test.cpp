@@ -0,0 +1,55 @@
+#include "json_repair/allocation_counter.hpp"
+#include "json_repair/json_parser.hpp"
+#include <iostream>
+#include <string>
+
+// Work of a parse as the input grows fourfold: the bytes read and the bytes allocated should grow
+// about fourfold too, sixteenfold would mean the repairs went quadratic
+
+int failures = 0;
+
+std::string repeat(const std::string& prefix, const std::string& unit, size_t count) {
+    std::string input = prefix;
+    for (size_t i = 0; i < count; ++i) {
+        input += unit;
+    }
+    return input;
+}
+
+struct Work {
+    size_t bytes_examined;
+    size_t bytes_allocated;
+};
+
+Work measure(const std::string& input) {
+    AllocationCounter counter;
+    JSONParser parser(input);
+    parser.parse();
+    return Work{parser.bytes_examined, counter.bytes()};
+}
+
+void check_linear(const std::string& name, const std::string& prefix, const std::string& unit) {
+    const size_t small = 2000;
+    Work a = measure(repeat(prefix, unit, small));
+    Work b = measure(repeat(prefix, unit, small * 4));
+    // Within 6x for 4x the input, allowing for the doubling of buffers
+    if (b.bytes_examined > a.bytes_examined * 6 || b.bytes_allocated > a.bytes_allocated * 6) {
+        failures += 1;
+        std::cerr << "FAILED " << name << ": read " << a.bytes_examined << " then " << b.bytes_examined
+                  << " bytes, allocated " << a.bytes_allocated << " then " << b.bytes_allocated << std::endl;
+    }
+}
+
+int main() {
+    // Duplicate keys inside an array roll back objects and reparse their keys
+    check_linear("unclosed objects", "[", R"({"a":1,)");
+    check_linear("duplicate keys", "[", R"({"a":1,"a":2,)");
+    check_linear("bare keys", "[", R"("a":)");
+    check_linear("empty objects", "[", "{}");
+    check_linear("nested arrays", "", "[");
+
+    if (failures == 0) {
+        std::cout << "scaling_test passed" << std::endl;
+    }
+    return failures == 0 ? 0 : 1;
+}
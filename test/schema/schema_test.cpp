@@ -0,0 +1,60 @@
+#include "json_repair/json_parser.hpp"
+#include "json_repair/schema.hpp"
+#include <iostream>
+#include <string>
+
+// Values parsed and coerced as the types declared by a CompiledSchema, with both parsers
+
+int failures = 0;
+
+const std::string schema_text = R"({
+    "type": "object",
+    "properties": {
+        "i": {"type": "integer"},
+        "n": {"type": "number"},
+        "b": {"type": "boolean"},
+        "s": {"type": "string"},
+        "o": {"type": ["integer", "null"]},
+        "l": {"type": "array", "items": {"type": "integer"}}
+    }
+})";
+
+void expect(const std::string& input, const std::string& expected) {
+    static auto schema = CompiledSchema::compile(schema_text);
+    for (bool iterative : {true, false}) {
+        JSONParser parser(input, false, 0, false, nullptr, schema);
+        parser.iterative = iterative;
+        std::string found = parser.parse().dump();
+        if (found != expected) {
+            failures += 1;
+            std::cerr << "FAILED " << input << (iterative ? " iterative: " : " recursive: ") << found
+                      << " instead of " << expected << std::endl;
+        }
+    }
+}
+
+int main() {
+    // Quoted numbers, past the range of int and of long long too
+    expect(R"({"i": "42"})", R"({"i":42.000000})");
+    expect(R"({"i": "-2147483648", "n": "2147483648"})", R"({"i":-2147483648.000000,"n":2147483648.000000})");
+    expect(R"({"i": "-9000000000"})", R"({"i":-9000000000.000000})");
+    expect(R"({"i": "99999999999999999999"})", R"({"i":100000000000000000000.000000})");
+    expect(R"({"l": ["1", 2, "3000000000"]})", R"({"l":[1.000000,2.000000,3000000000.000000]})");
+
+    // Text that is not wholly a number of the declared type stays a string
+    expect(R"({"i": "12abc", "n": "0x1A"})", R"({"i":"12abc","n":"0x1A"})");
+    expect(R"({"i": "1.5", "n": "1.5"})", R"({"i":"1.5","n":1.500000})");
+    expect(R"({"n": "1e999"})", R"({"n":"1e999"})");
+    expect(R"({"n": "inf", "i": "nan"})", R"({"i":"nan","n":"inf"})");
+
+    // Literals
+    expect(R"({"b": "TRUE", "o": "None"})", R"({"b":true,"o":null})");
+    expect(R"({"b": false, "s": true, "i": 7})", R"({"b":false,"i":7.000000,"s":"true"})");
+    expect(R"({"s": unquoted text, "n": 1})", R"({"n":1.000000,"s":"unquoted text"})");
+    expect(R"({"s": 12, "b": "false"})", R"({"b":false,"s":"12"})");
+
+    if (failures == 0) {
+        std::cout << "schema_test passed" << std::endl;
+    }
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,75 @@
+#ifdef JSON_REPAIR_SINGLE_HEADER_BENCH
+#define JSON_REPAIR_IMPLEMENTATION
+#include "json_repair.hpp"
+#else
+#include "json_repair/json_parser.hpp"
+#endif
+#include <algorithm>
+#include <ctime>
+#include <fstream>
+#include <glob.h>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Parse throughput of the files matched by the arguments, built once against the json_parser
+// library and once as the single header. The best of the runs in process CPU time is reported,
+// which is steadier than wall time on a busy machine.
+
+double cpu_seconds() {
+    timespec now;
+    ::clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &now);
+    return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+int main(int argc, char const* argv[]) {
+    int runs = 25;
+    std::vector< std::string > documents;
+    size_t bytes = 0;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--runs" && i + 1 < argc) {
+            runs = std::max(1, std::stoi(argv[++i]));
+            continue;
+        }
+        glob_t matches;
+        if (::glob(arg.c_str(), 0, nullptr, &matches) == 0) {
+            for (size_t m = 0; m < matches.gl_pathc; ++m) {
+                std::ifstream file(matches.gl_pathv[m], std::ios::binary);
+                std::stringstream buffer;
+                buffer << file.rdbuf();
+                documents.push_back(buffer.str());
+                bytes += documents.back().size();
+            }
+        }
+        ::globfree(&matches);
+    }
+    if (documents.empty()) {
+        std::cout << "Usage: " << argv[0] << " [--runs n] files or globs" << std::endl;
+        return 1;
+    }
+
+    double best = 1e30;
+    size_t parsed = 0;
+    for (int run = 0; run < runs; ++run) {
+        double start = cpu_seconds();
+        for (const auto& document : documents) {
+            try {
+                JSONParser parser(document);
+                parsed += parser.parse().is< JSONReturnType::MapType >();
+            } catch (const std::exception&) {
+            }
+        }
+        best = std::min(best, cpu_seconds() - start);
+    }
+#ifdef JSON_REPAIR_SINGLE_HEADER_BENCH
+    std::cout << "single header: ";
+#else
+    std::cout << "library: ";
+#endif
+    std::cout << documents.size() << " documents, " << parsed / runs << " objects, " << bytes / 1e6
+              << " MB, best of " << runs << " runs " << best * 1e3 << " ms, "
+              << bytes / 1e6 / std::max(best, 1e-9) << " MB/s" << std::endl;
+    return 0;
+}
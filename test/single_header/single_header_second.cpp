@@ -0,0 +1,9 @@
+#include "json_repair.hpp"
+#include <string>
+
+// A second translation unit including the single header without JSON_REPAIR_IMPLEMENTATION
+
+std::string repair_in_second_unit(const std::string& input) {
+    JSONParser parser(input);
+    return parser.parse().dump();
+}
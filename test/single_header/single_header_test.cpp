@@ -0,0 +1,33 @@
+#define JSON_REPAIR_IMPLEMENTATION
+#include "json_repair.hpp"
+#include <iostream>
+#include <string>
+
+// The generated single header repairs like the library, from either translation unit
+
+std::string repair_in_second_unit(const std::string& input);
+
+int failures = 0;
+
+void expect(const std::string& input, const std::string& expected) {
+    std::string found = JSONParser(input).parse().dump();
+    std::string second = repair_in_second_unit(input);
+    if (found != expected || second != expected) {
+        failures += 1;
+        std::cerr << "FAILED " << input << ": " << found << " and " << second << " instead of " << expected
+                  << std::endl;
+    }
+}
+
+int main() {
+    expect(R"({"a": [1, "x"], "b": 3)", R"({"a":[1.000000,"x"],"b":3.000000})");
+    expect(R"({'k': tru, "s": "unterminated)", R"({"k":"tru,","s":"unterminated"})");
+    expect(R"([1, 2,, {"n": null}]  trailing)", R"([1.000000,2.000000,{"n":"null"}])");
+    expect(R"(```json {"quote": "say \"hi\"", "list": [true, false, ] ```)",
+           R"({"list":["true","false"],"quote":"say \"hi\""})");
+
+    if (failures == 0) {
+        std::cout << "single_header_test passed" << std::endl;
+    }
+    return failures == 0 ? 0 : 1;
+}
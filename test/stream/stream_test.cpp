@@ -0,0 +1,71 @@
+#include "json_repair/json_parser.hpp"
+#include "json_repair/stream_repair.hpp"
+#include <iostream>
+#include <sstream>
+#include <string>
+
+// StreamRepair against parse(): the streamed text parses to the value parse() returns, and keeps
+// the source spelling of numbers and of the true, false and null literals
+
+int failures = 0;
+
+std::string stream(const std::string& input) {
+    JSONParser parser(input);
+    std::ostringstream out;
+    OstreamSink sink(out);
+    StreamRepair(parser, sink).run();
+    return out.str();
+}
+
+void expect_stream(const std::string& input, const std::string& expected) {
+    std::string found = stream(input);
+    if (found != expected) {
+        failures += 1;
+        std::cerr << "FAILED " << input << ": streamed " << found << " instead of " << expected << std::endl;
+    }
+}
+
+// Parsing the streamed text reads the literals as parse() does, and merges the values written one
+// per line into an array like parse()
+void expect_same_value(const std::string& input) {
+    std::string streamed = stream(input);
+    JSONReturnType expected = JSONParser(input).parse();
+    JSONReturnType found = JSONParser(streamed).parse();
+    if (found != expected) {
+        failures += 1;
+        std::cerr << "FAILED " << input << ": streamed " << streamed << " parses to " << found.dump()
+                  << " instead of " << expected.dump() << std::endl;
+    }
+}
+
+const char* inputs[] = {
+    R"({"a": true, "b": "true", "c": null, "d": [false, True, nul]})",
+    R"({b: 1, a: 2e3, c: -0.5} [1, 2,] 'x')",
+    "```json\n{\"k\": [1, {\"n\": tru\n```",
+    "// comment\n{\"a\": \"x\" /* y */, \"b\": [1, 2\n",
+    R"({"key": "value" "other": tru)",
+    R"([{"id": 1}, {"id": 2, "name": "unterminated)",
+    R"({'single': 'quotes', "nested": {"list": [1, "two", {"three": 3}]}})",
+    R"({"text": "say \"hi\"\n", "esc": "é"})",
+    R"([1.5, -3, 4e2, .5, 1., -])",
+    R"({"a": [], "b": {}, "c": ""})",
+    "text before {\"a\": 1} text after",
+    R"({"a": 1} {"b": 2})",
+};
+
+int main() {
+    // Literals written unquoted in the source stay literals, parse() returns them as strings
+    expect_stream(R"({"a": true, "b": "true", "c": null, "d": [false, True, nul]})",
+                  R"({"a":true,"b":"true","c":null,"d":[false,"true","nul"]})");
+    expect_stream(R"({b: 1, a: 2e3, c: -0.5})", R"({"b":1,"a":2e3,"c":-0.5})");
+    expect_stream(R"([1, 2,] {"x": 1})", "[1,2]\n{\"x\":1}");
+
+    for (const char* input : inputs) {
+        expect_same_value(input);
+    }
+
+    if (failures == 0) {
+        std::cout << "stream_test passed" << std::endl;
+    }
+    return failures == 0 ? 0 : 1;
+}
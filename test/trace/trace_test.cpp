@@ -0,0 +1,64 @@
+#include "json_repair/json_parser.hpp"
+#include "json_repair/trace.hpp"
+#include <iostream>
+#include <string>
+
+// Tracer events of a parse, and none at all when the scopes are compiled out
+
+int failures = 0;
+
+void check(bool condition, const std::string& what) {
+    if (!condition) {
+        failures += 1;
+        std::cerr << "FAILED " << what << std::endl;
+    }
+}
+
+const TraceEvent* find(const std::vector< TraceEvent >& events, const std::string& name) {
+    for (const auto& event : events) {
+        if (event.name == name) {
+            return &event;
+        }
+    }
+    return nullptr;
+}
+
+int main() {
+    const std::string input = R"({"a": [1, "x"], "b": 3)";
+    Tracer::start();
+    JSONParser parser(input);
+    std::string output = parser.parse().dump();
+    Tracer::stop();
+    std::vector< TraceEvent > events = Tracer::collect();
+
+#ifdef JSON_REPAIR_TRACING
+    const TraceEvent* object = find(events, "parse_object");
+    const TraceEvent* array = find(events, "parse_array");
+    check(object && object->begin_offset == 1 && object->end_offset == input.size() + 1, "parse_object offsets");
+    check(array && array->begin_offset == 7 && array->end_offset == 14, "parse_array offsets");
+    check(object && array && array->start_ns >= object->start_ns &&
+              array->start_ns + array->duration_ns <= object->start_ns + object->duration_ns,
+          "parse_array nested in parse_object");
+    check(find(events, "parse_string") && find(events, "parse_number") && find(events, "dump"), "scope names");
+    std::string json = chrome_trace(events);
+    check(json.find("\"name\":\"parse_object\",\"ph\":\"X\"") != std::string::npos, "chrome trace event");
+
+    // Only the last events are kept
+    Tracer::start(4);
+    JSONParser(input).parse();
+    Tracer::stop();
+    check(Tracer::collect().size() == 4, "ring buffer capacity");
+
+    // Nothing is recorded while stopped
+    JSONParser(input).parse();
+    check(Tracer::collect().empty(), "stopped tracer");
+#else
+    check(events.empty(), "no events without JSON_REPAIR_TRACING");
+#endif
+    check(chrome_trace({}) == "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n]}\n", "empty chrome trace");
+
+    if (failures == 0) {
+        std::cout << "trace_test passed with " << events.size() << " events" << std::endl;
+    }
+    return failures == 0 ? 0 : 1;
+}
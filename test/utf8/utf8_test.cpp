@@ -0,0 +1,69 @@
+#include "json_repair/json_parser.hpp"
+#include "json_repair/utf8.hpp"
+#include <iostream>
+#include <string>
+
+// \u escapes, surrogate pairs and the repair policies for invalid UTF-8 in strings
+
+int failures = 0;
+
+void check(bool condition, const std::string& what) {
+    if (!condition) {
+        failures += 1;
+        std::cerr << "FAILED " << what << std::endl;
+    }
+}
+
+std::string repair(const std::string& input, Utf8Policy policy = Utf8Policy::KEEP) {
+    JSONParser parser(input);
+    parser.utf8_policy = policy;
+    return parser.parse().dump();
+}
+
+void expect(const std::string& input, Utf8Policy policy, const std::string& expected) {
+    std::string found = repair(input, policy);
+    check(found == expected, input + ": " + found + " instead of " + expected);
+}
+
+int main() {
+    // Escapes are decoded whatever the policy
+    for (Utf8Policy policy : {Utf8Policy::KEEP, Utf8Policy::REPLACE, Utf8Policy::DROP, Utf8Policy::ESCAPE}) {
+        expect(R"(["caf\u00e9", "\u0041BC"])", policy, "[\"caf\xC3\xA9\",\"ABC\"]");
+        expect(R"({"emoji": "\ud83d\ude00!"})", policy, "{\"emoji\":\"\xF0\x9F\x98\x80!\"}");
+        expect(R"(["\u20AC \uzzzz"])", policy, "[\"\xE2\x82\xAC \\\\uzzzz\"]");
+        expect(R"(["\uD83D\uDE00"])", policy, "[\"\xF0\x9F\x98\x80\"]");
+    }
+    expect(R"(["a\\u0041"])", Utf8Policy::KEEP, "[\"a\\\\u0041\"]");
+
+    // Unpaired surrogates
+    expect(R"(["x\ud83d y"])", Utf8Policy::KEEP, "[\"x\\\\ud83d y\"]");
+    expect(R"(["x\ud83d y"])", Utf8Policy::ESCAPE, "[\"x\\\\ud83d y\"]");
+    expect(R"(["x\ud83d y"])", Utf8Policy::REPLACE, "[\"x\xEF\xBF\xBD y\"]");
+    expect(R"(["x\ude00 y"])", Utf8Policy::DROP, "[\"x y\"]");
+
+    // A character cut by a truncated token, and a stray continuation byte
+    std::string broken = "[\"caf\xC3\", \"ok \xE2\x82\xAC\", \"\x80x\"]";
+    expect(broken, Utf8Policy::KEEP, "[\"caf\xC3\",\"ok \xE2\x82\xAC\",\"\x80x\"]");
+    expect(broken, Utf8Policy::REPLACE, "[\"caf\xEF\xBF\xBD\",\"ok \xE2\x82\xAC\",\"\xEF\xBF\xBDx\"]");
+    expect(broken, Utf8Policy::DROP, "[\"caf\",\"ok \xE2\x82\xAC\",\"x\"]");
+    expect(broken, Utf8Policy::ESCAPE, "[\"caf\\\\xC3\",\"ok \xE2\x82\xAC\",\"\\\\x80x\"]");
+
+    // Overlong forms, encoded surrogates and code points past U+10FFFF are invalid
+    check(valid_utf8_prefix("ab\xC0\xAF") == 2, "overlong");
+    check(valid_utf8_prefix("\xED\xA0\x80") == 0, "encoded surrogate");
+    check(valid_utf8_prefix("\xF4\x90\x80\x80") == 0, "past U+10FFFF");
+    std::string text(1000, 'a');
+    text += "\xF0\x9F\x98\x80";
+    text += std::string(40, 'b');
+    check(valid_utf8_prefix(text) == text.size(), "long valid text");
+    text[1017] = '\xFF';
+    check(valid_utf8_prefix(text) == 1017, "invalid byte after the ASCII run");
+    std::string truncated = "\xE2\x82";
+    check(repair_utf8(truncated, Utf8Policy::REPLACE) == 1 && truncated == "\xEF\xBF\xBD", "one replacement per sequence");
+
+    if (failures) {
+        return 1;
+    }
+    std::cout << "all utf8 tests passed" << std::endl;
+    return 0;
+}
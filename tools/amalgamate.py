@@ -0,0 +1,96 @@
+#!/usr/bin/env python
+"""
+Generate the single-header distribution of the json_parser library.
+Usage:  python tools/amalgamate.py [output_path]
+
+The headers come first in include order, then the sources of add_library(json_parser ...) in
+CMakeLists.txt inside #ifdef JSON_REPAIR_IMPLEMENTATION. Exactly one translation unit defines
+JSON_REPAIR_IMPLEMENTATION before including the header. All the parse_* functions are then in
+one translation unit, so the compiler inlines across them without LTO.
+"""
+
+import os
+import re
+import sys
+
+ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+SOURCE_DIR = os.path.join(ROOT, "json_repair")
+LOCAL_INCLUDE = re.compile(r'^\s*#\s*include\s+"([^"]+)"')
+
+
+def library_sources():
+    """The sources listed in add_library(json_parser ...)."""
+    with open(os.path.join(ROOT, "CMakeLists.txt")) as cmake:
+        match = re.search(r"add_library\(json_parser\s+([^)]*)\)", cmake.read())
+    return [path.strip() for path in match.group(1).split() if path.strip().endswith(".cpp")]
+
+
+def read(name):
+    with open(os.path.join(SOURCE_DIR, name), encoding="utf-8") as source:
+        return source.read().splitlines()
+
+
+def append_header(name, out, seen):
+    """Appends a header after the local headers it includes, once."""
+    if name in seen:
+        return
+    seen.add(name)
+    lines = read(name)
+    for line in lines:
+        match = LOCAL_INCLUDE.match(line)
+        if match:
+            append_header(os.path.basename(match.group(1)), out, seen)
+    out.append(f"// json_repair/{name}")
+    out.extend(line for line in lines if not LOCAL_INCLUDE.match(line))
+    out.append("")
+
+
+def amalgamate():
+    headers = []
+    seen = set()
+    sources = []
+    for path in library_sources():
+        name = os.path.basename(path)
+        lines = read(name)
+        for line in lines:
+            match = LOCAL_INCLUDE.match(line)
+            if match:
+                append_header(os.path.basename(match.group(1)), headers, seen)
+        sources.append(f"// {path}")
+        sources.extend(line for line in lines if not LOCAL_INCLUDE.match(line))
+        sources.append("")
+
+    out = [
+        "// json_repair single-header distribution, generated by tools/amalgamate.py, do not edit",
+        "#ifndef JSON_REPAIR_SINGLE_HPP",
+        "#define JSON_REPAIR_SINGLE_HPP",
+        "",
+    ]
+    out.extend(headers)
+    out.append("#endif")
+    out.append("")
+    out.append("#ifdef JSON_REPAIR_IMPLEMENTATION")
+    out.append("#ifndef JSON_REPAIR_IMPLEMENTATION_INCLUDED")
+    out.append("#define JSON_REPAIR_IMPLEMENTATION_INCLUDED")
+    out.append("")
+    out.extend(sources)
+    out.append("#endif")
+    out.append("#endif")
+    return "\n".join(out) + "\n"
+
+
+def main():
+    output = sys.argv[1] if len(sys.argv) > 1 else os.path.join(ROOT, "single_include", "json_repair.hpp")
+    text = amalgamate()
+    os.makedirs(os.path.dirname(os.path.abspath(output)), exist_ok=True)
+    # Unchanged output keeps its timestamp, so dependent targets are not rebuilt
+    if os.path.exists(output):
+        with open(output, encoding="utf-8") as previous:
+            if previous.read() == text:
+                return
+    with open(output, "w", encoding="utf-8") as single:
+        single.write(text)
+
+
+if __name__ == "__main__":
+    main()